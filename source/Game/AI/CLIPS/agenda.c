@@ -64,6 +64,7 @@
 #include "moduldef.h"
 #include "modulutl.h"
 #include "multifld.h"
+#include "proflfun.h"
 #include "reteutil.h"
 #include "retract.h"
 #include "router.h"
@@ -141,6 +142,9 @@ globle void AddActivation(
    struct partialMatch *binds = (struct partialMatch *) vBinds;
    struct defruleModule *theModuleItem;
    struct salienceGroup *theGroup;
+#if PROFILING_FUNCTIONS
+   struct constructProfileInfo *profileInfo;
+#endif
 
    /*=======================================*/
    /* Focus on the module if the activation */
@@ -170,6 +174,20 @@ globle void AddActivation(
 
    AgendaData(theEnv)->NumberOfActivations++;
 
+   /*===================================================*/
+   /* Count the activations of the rule when constructs */
+   /* are profiled (firings are counted as entries).    */
+   /*===================================================*/
+
+#if PROFILING_FUNCTIONS
+   if (ProfileFunctionData(theEnv)->ProfileConstructs)
+     {
+      profileInfo = (struct constructProfileInfo *)
+                    FetchUserData(theEnv,ProfileFunctionData(theEnv)->ProfileDataID,&theRule->header.usrData);
+      if (profileInfo != NULL) profileInfo->numberOfActivations++;
+     }
+#endif
+
    /*=======================================================*/
    /* Point the partial match to the activation to complete */
    /* the link between the join network and the agenda.     */
@@ -256,6 +256,21 @@ globle void ConstructsToCCommand(
       return;
      }
 
+   /*===========================================*/
+   /* The run-time tables use the default sizes */
+   /* of the atomic value hash tables.          */
+   /*===========================================*/
+
+   if ((SymbolData(theEnv)->SymbolHashSize != SYMBOL_HASH_SIZE) ||
+       (SymbolData(theEnv)->FloatHashSize != FLOAT_HASH_SIZE) ||
+       (SymbolData(theEnv)->IntegerHashSize != INTEGER_HASH_SIZE) ||
+       (SymbolData(theEnv)->BitMapHashSize != BITMAP_HASH_SIZE))
+     {
+      PrintErrorID(theEnv,"CONSCOMP",2,FALSE);
+      EnvPrintRouter(theEnv,WERROR,"Aborting because the hash table sizes of the environment were changed.\n");
+      return;
+     }
+
    /*===========================================*/
    /* If the base file name is greater than 3   */
    /* characters, issue a warning that the file */
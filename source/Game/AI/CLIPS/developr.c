@@ -128,7 +128,7 @@ globle void PrimitiveTablesInfo(
    /*====================================*/
 
    symbolArray = GetSymbolTable(theEnv);
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       for (symbolPtr = symbolArray[i]; symbolPtr != NULL; symbolPtr = symbolPtr->next)
         { symbolCount++; }
@@ -139,7 +139,7 @@ globle void PrimitiveTablesInfo(
    /*====================================*/
 
    integerArray = GetIntegerTable(theEnv);
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       for (integerPtr = integerArray[i]; integerPtr != NULL; integerPtr = integerPtr->next)
         { integerCount++; }
@@ -150,7 +150,7 @@ globle void PrimitiveTablesInfo(
    /*====================================*/
 
    floatArray = GetFloatTable(theEnv);
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       for (floatPtr = floatArray[i]; floatPtr != NULL; floatPtr = floatPtr->next)
         { floatCount++; }
@@ -161,7 +161,7 @@ globle void PrimitiveTablesInfo(
    /*====================================*/
 
    bitMapArray = GetBitMapTable(theEnv);
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (bitMapPtr = bitMapArray[i]; bitMapPtr != NULL; bitMapPtr = bitMapPtr->next)
         { bitMapCount++; }
@@ -219,7 +219,7 @@ globle void PrimitiveTablesUsage(
    /*====================================*/
 
    symbolArray = GetSymbolTable(theEnv);
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       symbolCount = 0;
       for (symbolPtr = symbolArray[i]; symbolPtr != NULL; symbolPtr = symbolPtr->next)
@@ -239,7 +239,7 @@ globle void PrimitiveTablesUsage(
    /*===================================*/
    
    floatArray = GetFloatTable(theEnv);
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       floatCount = 0;
       for (floatPtr = floatArray[i]; floatPtr != NULL; floatPtr = floatPtr->next)
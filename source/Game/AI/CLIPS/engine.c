@@ -257,6 +257,14 @@ globle long long EnvRun(
            { ((void (*)(void *))(*theBeforeRunFunction->func))(theActivation); }
         }
 
+      /*===============================================*/
+      /* A function called before the firing may halt */
+      /* the rules: the activation stays on the agenda */
+      /* for the next run.                             */
+      /*===============================================*/
+
+      if (EngineData(theEnv)->HaltRules) break;
+
       /*===========================================*/
       /* Detach the activation from the agenda and */
       /* determine which rule is firing.           */
@@ -78,7 +78,7 @@
    static void                    RemoveEnvironmentCleanupFunctions(struct environmentData *);
    static void                   *CreateEnvironmentDriver(struct symbolHashNode **,struct floatHashNode **,
                                                           struct integerHashNode **,struct bitMapHashNode **,
-                                                          struct externalAddressHashNode **);
+                                                          struct externalAddressHashNode **,unsigned long *);
 
 /***************************************/
 /* LOCAL INTERNAL VARIABLE DEFINITIONS */
@@ -301,7 +301,30 @@ static struct environmentData *FindEnvironment(
 /************************************************************/
 globle void *CreateEnvironment()
   {
-   return CreateEnvironmentDriver(NULL,NULL,NULL,NULL,NULL);
+   return CreateEnvironmentDriver(NULL,NULL,NULL,NULL,NULL,NULL);
+  }
+
+/***********************************************************/
+/* CreateSizedEnvironment: Creates an environment whose    */
+/*   symbol, float, integer and bitmap hash tables have    */
+/*   the specified number of buckets (zero for the default */
+/*   size). Small tables save memory when many environments */
+/*   hold few facts and rules.                             */
+/***********************************************************/
+globle void *CreateSizedEnvironment(
+  unsigned long symbolSize,
+  unsigned long floatSize,
+  unsigned long integerSize,
+  unsigned long bitMapSize)
+  {
+   unsigned long sizes[4];
+
+   sizes[0] = symbolSize;
+   sizes[1] = floatSize;
+   sizes[2] = integerSize;
+   sizes[3] = bitMapSize;
+
+   return CreateEnvironmentDriver(NULL,NULL,NULL,NULL,NULL,sizes);
   }
 
 /**********************************************************/
@@ -314,7 +337,7 @@ globle void *CreateRuntimeEnvironment(
   struct integerHashNode **integerTable,
   struct bitMapHashNode **bitmapTable)
   {
-   return CreateEnvironmentDriver(symbolTable,floatTable,integerTable,bitmapTable,NULL);
+   return CreateEnvironmentDriver(symbolTable,floatTable,integerTable,bitmapTable,NULL,NULL);
   }
   
 /*********************************************************/
@@ -326,7 +349,8 @@ globle void *CreateEnvironmentDriver(
   struct floatHashNode **floatTable,
   struct integerHashNode **integerTable,
   struct bitMapHashNode **bitmapTable,
-  struct externalAddressHashNode **externalAddressTable)
+  struct externalAddressHashNode **externalAddressTable,
+  unsigned long *atomHashSizes)
   {
    struct environmentData *theEnvironment;
    void *theData;
@@ -386,7 +410,13 @@ globle void *CreateEnvironmentDriver(
    CurrentEnvironment = theEnvironment;
 #endif
 
+   /*=========================================================*/
+   /* The sizes are only read while the atom tables are made. */
+   /*=========================================================*/
+
+   theEnvironment->atomHashSizes = atomHashSizes;
    EnvInitializeEnvironment(theEnvironment,symbolTable,floatTable,integerTable,bitmapTable,externalAddressTable);
+   theEnvironment->atomHashSizes = NULL;
 
    return(theEnvironment);
   }
@@ -80,6 +80,7 @@ struct environmentData
    void **theData;
    void (**cleanupFunctions)(void *);
    struct environmentCleanupFunction *listOfCleanupEnvironmentFunctions;
+   unsigned long *atomHashSizes;
    struct environmentData *next;
   };
 
@@ -99,6 +100,8 @@ typedef struct environmentData * ENVIRONMENT_DATA_PTR;
    LOCALE unsigned long                  GetEnvironmentIndex(void *);
 #endif
    LOCALE void                          *CreateEnvironment(void);
+   LOCALE void                          *CreateSizedEnvironment(unsigned long,unsigned long,
+                                                                unsigned long,unsigned long);
    LOCALE void                          *CreateRuntimeEnvironment(struct symbolHashNode **,struct floatHashNode **,
                                                                   struct integerHashNode **,struct bitMapHashNode **);
    LOCALE intBool                        DestroyEnvironment(void *);
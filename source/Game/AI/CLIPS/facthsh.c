@@ -61,6 +61,7 @@
    static struct fact            *FactExists(void *,struct fact *,unsigned long);
    static struct factHashEntry  **CreateFactHashTable(void *,unsigned long);
    static void                    ResizeFactHashTable(void *);
+   static void                    RehashFactTable(void *,unsigned long);
    static void                    ResetFactHashTable(void *);
    
 /************************************************/
@@ -277,6 +278,22 @@ globle void InitializeFactHashTable(
    {
     FactData(theEnv)->FactHashTable = CreateFactHashTable(theEnv,SIZE_FACT_HASH);
     FactData(theEnv)->FactHashTableSize = SIZE_FACT_HASH;
+    FactData(theEnv)->InitialFactHashTableSize = SIZE_FACT_HASH;
+   }
+
+/*****************************************************/
+/* EnvSetFactHashSize: Changes the number of buckets */
+/*   of the fact hash table, which grows from this   */
+/*   size and shrinks back to it on reset.           */
+/*****************************************************/
+globle void EnvSetFactHashSize(
+   void *theEnv,
+   unsigned long tableSize)
+   {
+    if (tableSize == 0) return;
+
+    FactData(theEnv)->InitialFactHashTableSize = tableSize;
+    RehashFactTable(theEnv,tableSize);
    }
 
 /*******************************************************************/
@@ -305,13 +322,23 @@ static struct factHashEntry **CreateFactHashTable(
 static void ResizeFactHashTable(
    void *theEnv)
    {
-    unsigned long i, newSize, newLocation;
+    RehashFactTable(theEnv,(FactData(theEnv)->FactHashTableSize * 2) + 1);
+   }
+
+/*******************************************************************/
+/* RehashFactTable: Moves the facts to a new table of newSize      */
+/*   buckets.                                                      */
+/*******************************************************************/
+static void RehashFactTable(
+   void *theEnv,
+   unsigned long newSize)
+   {
+    unsigned long i, newLocation;
     struct factHashEntry **theTable, **newTable;
     struct factHashEntry *theEntry, *nextEntry;
 
     theTable = FactData(theEnv)->FactHashTable;
     
-    newSize = (FactData(theEnv)->FactHashTableSize * 2) + 1;
     newTable = CreateFactHashTable(theEnv,newSize);
 
     /*========================================*/
@@ -355,21 +382,21 @@ static void ResetFactHashTable(
     /* has been expanded from its original size.   */
     /*=============================================*/
     
-    if (FactData(theEnv)->FactHashTableSize == SIZE_FACT_HASH)
+    if (FactData(theEnv)->FactHashTableSize == FactData(theEnv)->InitialFactHashTableSize)
       { return; }
           
     /*=======================*/
     /* Create the new table. */
     /*=======================*/
     
-    newTable = CreateFactHashTable(theEnv,SIZE_FACT_HASH);
+    newTable = CreateFactHashTable(theEnv,FactData(theEnv)->InitialFactHashTableSize);
     
     /*=====================================================*/
     /* Replace the old hash table with the new hash table. */
     /*=====================================================*/
     
     rm3(theEnv,FactData(theEnv)->FactHashTable,sizeof(struct factHashEntry *) * FactData(theEnv)->FactHashTableSize);
-    FactData(theEnv)->FactHashTableSize = SIZE_FACT_HASH;
+    FactData(theEnv)->FactHashTableSize = FactData(theEnv)->InitialFactHashTableSize;
     FactData(theEnv)->FactHashTable = newTable;
    }
       
@@ -63,6 +63,7 @@ struct factHashEntry
    LOCALE intBool                        EnvGetFactDuplication(void *);
    LOCALE intBool                        EnvSetFactDuplication(void *,int);
    LOCALE void                           InitializeFactHashTable(void *);
+   LOCALE void                           EnvSetFactHashSize(void *,unsigned long);
    LOCALE void                           ShowFactHashTable(void *);
    LOCALE unsigned long                  HashFact(struct fact *);
    LOCALE intBool                        FactWillBeAsserted(void *,void *);
@@ -119,6 +119,7 @@ struct factsData
 #endif
    struct factHashEntry **FactHashTable;
    unsigned long FactHashTableSize;
+   unsigned long InitialFactHashTableSize;
    intBool FactDuplication;
 #if DEFRULE_CONSTRUCT
    struct fact             *CurrentPatternFact;
@@ -128,6 +128,7 @@ globle void *CreateProfileData(
              genalloc(theEnv,sizeof(struct constructProfileInfo));
 
    theInfo->numberOfEntries = 0;
+   theInfo->numberOfActivations = 0;
    theInfo->childCall = FALSE;
    theInfo->startTime = 0.0;
    theInfo->totalSelfTime = 0.0;
@@ -552,6 +553,7 @@ globle void ResetProfileInfo(
    if (profileInfo == NULL) return;
    
    profileInfo->numberOfEntries = 0;
+   profileInfo->numberOfActivations = 0;
    profileInfo->childCall = FALSE;
    profileInfo->startTime = 0.0;
    profileInfo->totalSelfTime = 0.0;
@@ -59,6 +59,7 @@ struct constructProfileInfo
   {
    struct userData usrData;
    long numberOfEntries;
+   long numberOfActivations;
    unsigned int childCall : 1;
    double startTime;
    double totalSelfTime;
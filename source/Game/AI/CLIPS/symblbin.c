@@ -88,7 +88,7 @@ globle void InitAtomicValueNeededFlags(
 
    symbolArray = GetSymbolTable(theEnv);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       symbolPtr = symbolArray[i];
       while (symbolPtr != NULL)
@@ -104,7 +104,7 @@ globle void InitAtomicValueNeededFlags(
 
    floatArray = GetFloatTable(theEnv);
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       floatPtr = floatArray[i];
       while (floatPtr != NULL)
@@ -120,7 +120,7 @@ globle void InitAtomicValueNeededFlags(
 
    integerArray = GetIntegerTable(theEnv);
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       integerPtr = integerArray[i];
       while (integerPtr != NULL)
@@ -136,7 +136,7 @@ globle void InitAtomicValueNeededFlags(
 
    bitMapArray = GetBitMapTable(theEnv);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       bitMapPtr = bitMapArray[i];
       while (bitMapPtr != NULL)
@@ -172,7 +172,7 @@ globle void WriteNeededSymbols(
    /* Get the number of symbols and the total string size. */
    /*======================================================*/
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
@@ -193,7 +193,7 @@ globle void WriteNeededSymbols(
    GenWrite((void *) &numberOfUsedSymbols,(unsigned long) sizeof(unsigned long int),fp);
    GenWrite((void *) &size,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
@@ -231,7 +231,7 @@ globle void WriteNeededFloats(
    /* Get the number of floats. */
    /*===========================*/
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
@@ -245,7 +245,7 @@ globle void WriteNeededFloats(
 
    GenWrite(&numberOfUsedFloats,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0 ; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0 ; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
@@ -281,7 +281,7 @@ globle void WriteNeededIntegers(
    /* Get the number of integers. */
    /*=============================*/
 
-   for (i = 0 ; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0 ; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
@@ -297,7 +297,7 @@ globle void WriteNeededIntegers(
 
    GenWrite(&numberOfUsedIntegers,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0 ; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0 ; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
@@ -336,7 +336,7 @@ static void WriteNeededBitMaps(
    /* Get the number of bitmaps and the total bitmap size. */
    /*======================================================*/
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
@@ -357,7 +357,7 @@ static void WriteNeededBitMaps(
    GenWrite((void *) &numberOfUsedBitMaps,(unsigned long) sizeof(unsigned long int),fp);
    GenWrite((void *) &size,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
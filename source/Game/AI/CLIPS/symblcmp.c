@@ -123,7 +123,7 @@ static int SymbolHashNodesToCode(
    symbolTable = GetSymbolTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       for (hashPtr = symbolTable[i];
            hashPtr != NULL;
@@ -148,7 +148,7 @@ static int SymbolHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       for (hashPtr = symbolTable[i];
            hashPtr != NULL;
@@ -226,7 +226,7 @@ static int BitMapHashNodesToCode(
    bitMapTable = GetBitMapTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -251,7 +251,7 @@ static int BitMapHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -342,7 +342,7 @@ static int BitMapValuesToCode(
    bitMapTable = GetBitMapTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -371,7 +371,7 @@ static int BitMapValuesToCode(
 
    j = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -452,7 +452,7 @@ static int FloatHashNodesToCode(
    floatTable = GetFloatTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       for (hashPtr = floatTable[i];
            hashPtr != NULL;
@@ -477,7 +477,7 @@ static int FloatHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       for (hashPtr = floatTable[i];
            hashPtr != NULL;
@@ -554,7 +554,7 @@ static int IntegerHashNodesToCode(
    integerTable = GetIntegerTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       for (hashPtr = integerTable[i];
            hashPtr != NULL;
@@ -579,7 +579,7 @@ static int IntegerHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       for (hashPtr = integerTable[i];
            hashPtr != NULL;
@@ -655,13 +655,13 @@ static int HashTablesToCode(
    if ((fp = NewCFile(theEnv,fileName,pathName,fileNameBuffer,1,1,FALSE)) == NULL) return(0);
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct symbolHashNode *sht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct symbolHashNode *sht%d[%ld] = {\n",ConstructCompilerData(theEnv)->ImageID,SYMBOL_HASH_SIZE);
+   fprintf(fp,"struct symbolHashNode *sht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,SymbolData(theEnv)->SymbolHashSize);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
       {
        PrintSymbolReference(theEnv,fp,symbolTable[i]);
 
-       if (i + 1 != SYMBOL_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != SymbolData(theEnv)->SymbolHashSize) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
@@ -677,14 +677,14 @@ static int HashTablesToCode(
    if ((fp = NewCFile(theEnv,fileName,pathName,fileNameBuffer,1,2,FALSE)) == NULL) return(0);
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct floatHashNode *fht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct floatHashNode *fht%d[%d] = {\n",ConstructCompilerData(theEnv)->ImageID,FLOAT_HASH_SIZE);
+   fprintf(fp,"struct floatHashNode *fht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,SymbolData(theEnv)->FloatHashSize);
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
       {
        if (floatTable[i] == NULL) { fprintf(fp,"NULL"); }
        else PrintFloatReference(theEnv,fp,floatTable[i]);
 
-       if (i + 1 != FLOAT_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != SymbolData(theEnv)->FloatHashSize) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
@@ -700,14 +700,14 @@ static int HashTablesToCode(
    if ((fp = NewCFile(theEnv,fileName,pathName,fileNameBuffer,1,3,FALSE)) == NULL) return(0);
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct integerHashNode *iht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct integerHashNode *iht%d[%d] = {\n",ConstructCompilerData(theEnv)->ImageID,INTEGER_HASH_SIZE);
+   fprintf(fp,"struct integerHashNode *iht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,SymbolData(theEnv)->IntegerHashSize);
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++)
       {
        if (integerTable[i] == NULL) { fprintf(fp,"NULL"); }
        else PrintIntegerReference(theEnv,fp,integerTable[i]);
 
-       if (i + 1 != INTEGER_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != SymbolData(theEnv)->IntegerHashSize) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
@@ -723,13 +723,13 @@ static int HashTablesToCode(
    if ((fp = NewCFile(theEnv,fileName,pathName,fileNameBuffer,1,4,FALSE)) == NULL) return(0);
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct bitMapHashNode *bmht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct bitMapHashNode *bmht%d[%d] = {\n",ConstructCompilerData(theEnv)->ImageID,BITMAP_HASH_SIZE);
+   fprintf(fp,"struct bitMapHashNode *bmht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,SymbolData(theEnv)->BitMapHashSize);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
       {
        PrintBitMapReference(theEnv,fp,bitMapTable[i]);
 
-       if (i + 1 != BITMAP_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != SymbolData(theEnv)->BitMapHashSize) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
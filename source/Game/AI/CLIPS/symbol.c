@@ -125,25 +125,39 @@ globle void InitializeAtomTables(
 #pragma unused(externalAddressTable)
 #endif
    unsigned long i;
+   unsigned long *sizes;
    
    AllocateEnvironmentData(theEnv,SYMBOL_DATA,sizeof(struct symbolData),DeallocateSymbolData);
 
+   /*==========================================================*/
+   /* The sizes given to CreateSizedEnvironment are used once, */
+   /* before any atom exists: the buckets of the atoms are     */
+   /* kept by other hash tables (classes, constraints, joins)  */
+   /* so the atom tables can't be rehashed afterwards.         */
+   /*==========================================================*/
+
+   sizes = ((struct environmentData *) theEnv)->atomHashSizes;
+   SymbolData(theEnv)->SymbolHashSize = ((sizes != NULL) && (sizes[0] != 0)) ? sizes[0] : SYMBOL_HASH_SIZE;
+   SymbolData(theEnv)->FloatHashSize = ((sizes != NULL) && (sizes[1] != 0)) ? sizes[1] : FLOAT_HASH_SIZE;
+   SymbolData(theEnv)->IntegerHashSize = ((sizes != NULL) && (sizes[2] != 0)) ? sizes[2] : INTEGER_HASH_SIZE;
+   SymbolData(theEnv)->BitMapHashSize = ((sizes != NULL) && (sizes[3] != 0)) ? sizes[3] : BITMAP_HASH_SIZE;
+
 #if ! RUN_TIME
    /*=========================*/
    /* Create the hash tables. */
    /*=========================*/
 
    SymbolData(theEnv)->SymbolTable = (SYMBOL_HN **)
-                  gm3(theEnv,sizeof (SYMBOL_HN *) * SYMBOL_HASH_SIZE);
+                  gm3(theEnv,sizeof (SYMBOL_HN *) * SymbolData(theEnv)->SymbolHashSize);
 
    SymbolData(theEnv)->FloatTable = (FLOAT_HN **)
-                  gm2(theEnv,(int) sizeof (FLOAT_HN *) * FLOAT_HASH_SIZE);
+                  gm3(theEnv,sizeof (FLOAT_HN *) * SymbolData(theEnv)->FloatHashSize);
 
    SymbolData(theEnv)->IntegerTable = (INTEGER_HN **)
-                   gm2(theEnv,(int) sizeof (INTEGER_HN *) * INTEGER_HASH_SIZE);
+                   gm3(theEnv,sizeof (INTEGER_HN *) * SymbolData(theEnv)->IntegerHashSize);
 
    SymbolData(theEnv)->BitMapTable = (BITMAP_HN **)
-                   gm2(theEnv,(int) sizeof (BITMAP_HN *) * BITMAP_HASH_SIZE);
+                   gm3(theEnv,sizeof (BITMAP_HN *) * SymbolData(theEnv)->BitMapHashSize);
 
    SymbolData(theEnv)->ExternalAddressTable = (EXTERNAL_ADDRESS_HN **)
                    gm2(theEnv,(int) sizeof (EXTERNAL_ADDRESS_HN *) * EXTERNAL_ADDRESS_HASH_SIZE);
@@ -152,10 +166,10 @@ globle void InitializeAtomTables(
    /* Initialize all of the hash table entries to NULL. */
    /*===================================================*/
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++) SymbolData(theEnv)->SymbolTable[i] = NULL;
-   for (i = 0; i < FLOAT_HASH_SIZE; i++) SymbolData(theEnv)->FloatTable[i] = NULL;
-   for (i = 0; i < INTEGER_HASH_SIZE; i++) SymbolData(theEnv)->IntegerTable[i] = NULL;
-   for (i = 0; i < BITMAP_HASH_SIZE; i++) SymbolData(theEnv)->BitMapTable[i] = NULL;
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++) SymbolData(theEnv)->SymbolTable[i] = NULL;
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++) SymbolData(theEnv)->FloatTable[i] = NULL;
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++) SymbolData(theEnv)->IntegerTable[i] = NULL;
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++) SymbolData(theEnv)->BitMapTable[i] = NULL;
    for (i = 0; i < EXTERNAL_ADDRESS_HASH_SIZE; i++) SymbolData(theEnv)->ExternalAddressTable[i] = NULL;
 
    /*========================*/
@@ -206,7 +220,7 @@ static void DeallocateSymbolData(
        (SymbolData(theEnv)->ExternalAddressTable == NULL))
      { return; }
      
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++) 
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++) 
      {
       shPtr = SymbolData(theEnv)->SymbolTable[i];
       
@@ -222,7 +236,7 @@ static void DeallocateSymbolData(
         } 
      }
       
-   for (i = 0; i < FLOAT_HASH_SIZE; i++) 
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++) 
      {
       fhPtr = SymbolData(theEnv)->FloatTable[i];
 
@@ -235,7 +249,7 @@ static void DeallocateSymbolData(
         }
      }
      
-   for (i = 0; i < INTEGER_HASH_SIZE; i++) 
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++) 
      {
       ihPtr = SymbolData(theEnv)->IntegerTable[i];
 
@@ -248,7 +262,7 @@ static void DeallocateSymbolData(
         }
      }
      
-   for (i = 0; i < BITMAP_HASH_SIZE; i++) 
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++) 
      {
       bmhPtr = SymbolData(theEnv)->BitMapTable[i];
 
@@ -284,13 +298,13 @@ static void DeallocateSymbolData(
    /*================================*/
    
  #if ! RUN_TIME  
-   rm3(theEnv,SymbolData(theEnv)->SymbolTable,sizeof (SYMBOL_HN *) * SYMBOL_HASH_SIZE);
+   rm3(theEnv,SymbolData(theEnv)->SymbolTable,sizeof (SYMBOL_HN *) * SymbolData(theEnv)->SymbolHashSize);
 
-   genfree(theEnv,SymbolData(theEnv)->FloatTable,(int) sizeof (FLOAT_HN *) * FLOAT_HASH_SIZE);
+   rm3(theEnv,SymbolData(theEnv)->FloatTable,sizeof (FLOAT_HN *) * SymbolData(theEnv)->FloatHashSize);
 
-   genfree(theEnv,SymbolData(theEnv)->IntegerTable,(int) sizeof (INTEGER_HN *) * INTEGER_HASH_SIZE);
+   rm3(theEnv,SymbolData(theEnv)->IntegerTable,sizeof (INTEGER_HN *) * SymbolData(theEnv)->IntegerHashSize);
 
-   genfree(theEnv,SymbolData(theEnv)->BitMapTable,(int) sizeof (BITMAP_HN *) * BITMAP_HASH_SIZE);
+   rm3(theEnv,SymbolData(theEnv)->BitMapTable,sizeof (BITMAP_HN *) * SymbolData(theEnv)->BitMapHashSize);
 #endif
    
    genfree(theEnv,SymbolData(theEnv)->ExternalAddressTable,(int) sizeof (EXTERNAL_ADDRESS_HN *) * EXTERNAL_ADDRESS_HASH_SIZE);
@@ -337,7 +351,7 @@ globle void *EnvAddSymbol(
        EnvExitRouter(theEnv,EXIT_FAILURE);
       }
 
-    tally = HashSymbol(str,SYMBOL_HASH_SIZE);
+    tally = HashSymbol(str,SymbolData(theEnv)->SymbolHashSize);
     peek = SymbolData(theEnv)->SymbolTable[tally];
 
     /*==================================================*/
@@ -399,7 +413,7 @@ globle SYMBOL_HN *FindSymbolHN(
    unsigned long tally;
    SYMBOL_HN *peek;
 
-    tally = HashSymbol(str,SYMBOL_HASH_SIZE);
+    tally = HashSymbol(str,SymbolData(theEnv)->SymbolHashSize);
 
     for (peek = SymbolData(theEnv)->SymbolTable[tally];
          peek != NULL;
@@ -429,7 +443,7 @@ globle void *EnvAddDouble(
     /* Get the hash value for the double. */
     /*====================================*/
 
-    tally = HashFloat(number,FLOAT_HASH_SIZE);
+    tally = HashFloat(number,SymbolData(theEnv)->FloatHashSize);
     peek = SymbolData(theEnv)->FloatTable[tally];
 
     /*==================================================*/
@@ -494,7 +508,7 @@ globle void *EnvAddLong(
     /* Get the hash value for the long. */
     /*==================================*/
 
-    tally = HashInteger(number,INTEGER_HASH_SIZE);
+    tally = HashInteger(number,SymbolData(theEnv)->IntegerHashSize);
     peek = SymbolData(theEnv)->IntegerTable[tally];
 
     /*================================================*/
@@ -552,7 +566,7 @@ globle INTEGER_HN *FindLongHN(
    unsigned long tally;
    INTEGER_HN *peek;
 
-   tally = HashInteger(theLong,INTEGER_HASH_SIZE);
+   tally = HashInteger(theLong,SymbolData(theEnv)->IntegerHashSize);
 
    for (peek = SymbolData(theEnv)->IntegerTable[tally];
         peek != NULL;
@@ -589,7 +603,7 @@ globle void *EnvAddBitMap(
        EnvExitRouter(theEnv,EXIT_FAILURE);
       }
 
-    tally = HashBitMap(theBitMap,BITMAP_HASH_SIZE,size);
+    tally = HashBitMap(theBitMap,SymbolData(theEnv)->BitMapHashSize,size);
     peek = SymbolData(theEnv)->BitMapTable[tally];
 
     /*==================================================*/
@@ -1614,7 +1628,7 @@ globle SYMBOL_HN *GetNextSymbolMatch(
       /* Move on to the next bucket in the symbol table. */
       /*=================================================*/
 
-      if (++i >= SYMBOL_HASH_SIZE) flag = FALSE;
+      if (++i >= SymbolData(theEnv)->SymbolHashSize) flag = FALSE;
       else hashPtr = SymbolData(theEnv)->SymbolTable[i];
      }
 
@@ -1686,7 +1700,7 @@ globle void SetAtomicValueIndices(
    count = 0;
    symbolArray = GetSymbolTable(theEnv);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
@@ -1708,7 +1722,7 @@ globle void SetAtomicValueIndices(
    count = 0;
    floatArray = GetFloatTable(theEnv);
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
@@ -1730,7 +1744,7 @@ globle void SetAtomicValueIndices(
    count = 0;
    integerArray = GetIntegerTable(theEnv);
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
@@ -1752,7 +1766,7 @@ globle void SetAtomicValueIndices(
    count = 0;
    bitMapArray = GetBitMapTable(theEnv);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
@@ -1788,7 +1802,7 @@ globle void RestoreAtomicValueBuckets(
 
    symbolArray = GetSymbolTable(theEnv);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->SymbolHashSize; i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
@@ -1802,7 +1816,7 @@ globle void RestoreAtomicValueBuckets(
 
    floatArray = GetFloatTable(theEnv);
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->FloatHashSize; i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
@@ -1816,7 +1830,7 @@ globle void RestoreAtomicValueBuckets(
 
    integerArray = GetIntegerTable(theEnv);
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->IntegerHashSize; i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
@@ -1830,7 +1844,7 @@ globle void RestoreAtomicValueBuckets(
 
    bitMapArray = GetBitMapTable(theEnv);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < SymbolData(theEnv)->BitMapHashSize; i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
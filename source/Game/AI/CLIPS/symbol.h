@@ -257,6 +257,10 @@ struct symbolData
    INTEGER_HN **IntegerTable;
    BITMAP_HN **BitMapTable;
    EXTERNAL_ADDRESS_HN **ExternalAddressTable;
+   unsigned long SymbolHashSize;
+   unsigned long FloatHashSize;
+   unsigned long IntegerHashSize;
+   unsigned long BitMapHashSize;
 #if BLOAD || BLOAD_ONLY || BLOAD_AND_BSAVE || BLOAD_INSTANCES || BSAVE_INSTANCES
    long NumberOfSymbols;
    long NumberOfFloats;
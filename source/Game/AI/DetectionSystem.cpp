@@ -66,17 +66,14 @@ void UnderwaterAcousticDetectionSystem::passiveDetection(RCPtr <GameNode> gameno
 {
 	// check the intersection with nodes based on radar performance
 	Unigine::VectorStack<Unigine::NodePtr> nodes;
-	std::vector<long> nodesIds = GamePlay::Game->getCurrentevel()->getBoudingSphereIntersection(gamenode->position(), _passive_detection_range / 2);
-	if (nodesIds.size() > 1) // (because the current node is also in this list)
+	size_t count = GamePlay::Game->getCurrentevel()->getBoudingSphereIntersection(gamenode->position(), _passive_detection_range / 2, _nodes_in_range);
+	if (count > 1) // (because the current node is also in this list)
 	{
-		for (int i = 0; i < nodesIds.size(); i++)
+		for (size_t i = 0; i < count; i++)
 		{
-			long nodeID = nodesIds[i];
-
-			// verify the given node
-			GameNodePtr threat = GamePlay::Game->getCurrentevel()->getGameNode(nodeID);
+			GameNodePtr threat = _nodes_in_range[i];
 			// add to threat list if needed
-			if (threat && (threat->_id != gamenode->_id))
+			if (threat->_id != gamenode->_id)
 			{
 				OpenSteer::Vec3 bearing = (threat->position() - gamenode->position()).normalize();
 				DetectedTarget dt(bearing, gamenode->nodeDistance(threat), threat->_id);
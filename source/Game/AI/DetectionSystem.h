@@ -116,6 +116,8 @@ namespace SubWorld
 		enumNoiseLevel _noise_level;
 		float _passive_detection_range;
 		float _active_detection_range;
+		// buffer of the sphere queries
+		std::vector<GameNode*> _nodes_in_range;
 
 	};
 
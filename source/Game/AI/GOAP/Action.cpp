@@ -2,34 +2,46 @@
 #include "WorldState.h"
 
 #include <cassert>
+#include <functional>
 
 goap::Action::Action() : cost_(0) {
+    // every unnamed action shares the same empty name
+    static const std::shared_ptr<const std::string> no_name = std::make_shared<const std::string>();
+    name_ = no_name;
+    updateHash();
 }
 
 goap::Action::Action(std::string name, int cost) : Action() {
     // Because delegating constructors cannot initialize & delegate at the same time...
-    name_ = name;
+    name_ = std::make_shared<const std::string>(std::move(name));
     cost_ = cost;
+    updateHash();
 }
 
 bool goap::Action::operableOn(const WorldState& ws) const {
-    for (const auto& precond : preconditions_) {
-        try {
-            if (ws.vars_.at(precond.first) != precond.second) {
-                return false;
-            }
-        } catch (const std::out_of_range&) {
-            return false;
-        }
-    }
-    return true;
+    return ws.meetsGoal(preconditions_);
 }
 
 goap::WorldState goap::Action::actOn(const WorldState& ws) const {
     goap::WorldState tmp(ws);
-    for (const auto& effect : effects_) {
-        tmp.setVariable(effect.first, effect.second);
-    }
+    tmp.vars_ = (tmp.vars_ & ~effects_.care_) | effects_.vars_;
+    tmp.care_ |= effects_.care_;
     return tmp;
 }
 
+void goap::Action::updateHash() {
+    const WorldStateHash state_hash;
+    std::size_t h = std::hash<std::string>()(*name_);
+    h = h * 31 + static_cast<std::size_t>(cost_);
+    h = h * 31 + state_hash(preconditions_);
+    h = h * 31 + state_hash(effects_);
+    hash_ = h;
+}
+
+std::size_t goap::hashActions(const std::vector<Action>& actions) {
+    std::size_t h = actions.size();
+    for (const auto& action : actions) {
+        h = h * 31 + action.hash();
+    }
+    return h;
+}
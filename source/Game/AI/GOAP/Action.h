@@ -8,8 +8,12 @@
 
 #pragma once
 
+#include "WorldState.h"
+
+#include <cstddef>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 // To support Google Test for private members
 #ifndef TEST_FRIENDS
@@ -17,19 +21,25 @@
 #endif
 
 namespace goap {
-    struct WorldState;
-
     class Action {
     private:
-        std::string name_; // The human-readable action name
+        // The human-readable action name, shared by the copies of this action so that
+        // copying it (e.g. into a plan) never allocates, whatever its length
+        std::shared_ptr<const std::string> name_;
         int cost_;         // The numeric cost of this action
 
         // Preconditions are things that must be satisfied before this
-        // action can be taken. Only preconditions that "matter" are here.
-        std::unordered_map<int, bool> preconditions_;
+        // action can be taken. Only preconditions that "matter" are set here.
+        WorldState preconditions_;
 
         // Effects are things that happen when this action takes place.
-        std::unordered_map<int, bool> effects_;
+        // Only the variables the action changes are set here.
+        WorldState effects_;
+
+        // Hash of all the above, kept up to date by every setter
+        std::size_t hash_;
+
+        void updateHash();
 
     public:
         Action();
@@ -56,7 +66,8 @@ namespace goap {
          @param value the value the precondition must hold
          */
         void setPrecondition(const int key, const bool value) {
-            preconditions_[key] = value;
+            preconditions_.setVariable(key, value);
+            updateHash();
         }
 
         /**
@@ -65,14 +76,51 @@ namespace goap {
          @param value the value that will result
          */
         void setEffect(const int key, const bool value) {
-            effects_[key] = value;
+            effects_.setVariable(key, value);
+            updateHash();
         }
 
         int cost() const { return cost_; }
 
-        std::string name() const { return name_; }
+        const WorldState& preconditions() const { return preconditions_; }
+
+        /**
+         Change the cost of this action.
+         @param cost the new cost
+         */
+        void setCost(const int cost) {
+            cost_ = cost;
+            updateHash();
+        }
+
+        /**
+         Hashes everything the planner looks at (name, cost, preconditions, effects), so
+         two identical action pools can be recognized as such. Any change made through
+         the setters changes the hash, which is what invalidates the cached plans.
+         @return the hash of this action
+         */
+        std::size_t hash() const { return hash_; }
+
+        /**
+         Equality operator
+         @param other the other action to compare to
+         @return true if both have the same name, cost, preconditions and effects
+         */
+        bool operator==(const Action& other) const {
+            return cost_ == other.cost_ && preconditions_ == other.preconditions_ &&
+                   effects_ == other.effects_ && *name_ == *other.name_;
+        }
+
+        std::string name() const { return *name_; }
 
         TEST_FRIENDS;
     };
 
-}
\ No newline at end of file
+    /**
+     Hashes a whole pool of actions, in order.
+     @param actions the action pool
+     @return the combined hash of the actions
+     */
+    std::size_t hashActions(const std::vector<Action>& actions);
+
+}
@@ -0,0 +1,1047 @@
+
+// ----------------------------------------------------------------------------
+//
+//
+//	Goal Oriented Action Planning - headless benchmark
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+#if defined GOAP_BENCHMARK
+
+// Headless benchmark of the GOAP planner, without Unigine. On Linux, from this directory :
+//   g++ -std=c++17 -O2 -DNDEBUG -DGOAP_BENCHMARK -pthread *.cpp -o goap_benchmark
+//   ./goap_benchmark [--domains N]
+// Plans from each of the 4096 values of the 12 facts of SubClassA, then in N synthetic domains (20) of 64 facts and
+// 64 actions, with the planner and with the reference search (std::map states, open list sorted on F, linear scans
+// of the open and closed lists, as the planner was before the bitset states). Checks that both find the same plan
+// costs and that the planner is faster.
+//   ./goap_benchmark --allocations [--replans N]
+// A SubClassA agent replans N times (1000) from start states drawn from a fixed seed, each time from scratch
+// (computePlan), then as UnitGOAPPlannerAI::update_planner does (checkPlan, then computePlan if the plan cannot be
+// repaired), once every state was seen. Checks that no replan allocates (operator new of this file counts them).
+//   ./goap_benchmark --agents N [--ticks T] [--workers W]
+// N SubClassA agents sense random facts at each of T ticks (50) and replan : inline (computePlan), then through
+// a PlanningService of W workers (one per hardware thread but one), which delivers the plans at the next tick.
+// Checks that each agent receives the same plans both ways, and reports the percentiles of the game thread time
+// per tick. The service must be faster when there are at least 2 hardware threads. Build with -fsanitize=thread and
+// run many short ticks (--agents 2 --ticks 3000 --workers 8) to check the service for data races.
+//   ./goap_benchmark --cache [--agents N] [--ticks T]
+// Replays the sensor states of N SubClassA agents (1000) for T ticks (200) through a PlanningService : the agents share
+// 4 fact vectors, and 5% of them toggle one fact at each tick (back at their next toggle). The cost of shootEnemy changes
+// at the middle tick. Checks a hit rate of at least 90%, no hit at the tick of the cost change (the cached plans are
+// stale) and hits again at the next one, then replays again checking each delivered plan against a new search.
+//   ./goap_benchmark --repair [--agents N] [--ticks T]
+// N SubClassA agents (1000) for T ticks (200), 50 random facts of them flipping at each tick : each agent replans at
+// each tick (computePlan), then keeps its plan while it validates and repairs it before replanning (checkPlan), twice.
+// Checks that both incremental runs deliver the same plans, that the plan of every agent reaches its goal after each
+// tick, and that the incremental path replans less, in less time, with plans costing at most 25% more on average.
+//   ./goap_benchmark --unreachable [--domains N] [--budget ms] [--expansions E]
+// N synthetic domains (20) of 64 facts and 400 actions whose goal needs a fact no action sets. Plans each one within a
+// budget of ms (2) then of E expansions (8192) : checks that every search returns a partial plan operable from the
+// start, without exception, and within the time budget plus 1 ms (the fastest of 3 runs of each search, as the thread
+// may be preempted). Then, the actions only touching 8 of the facts, checks that the searches without budget return
+// NotFound.
+
+#include "GoapPlanner.h"
+#include "GoapInterface.h"
+#include "PlanningService.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace goap;
+
+// allocations of the process
+static std::atomic<size_t> g_allocations(0);
+
+// not inlined : gcc would pair the malloc and free of their bodies with the new and delete expressions of this file
+#if defined _MSC_VER
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+BENCH_NOINLINE void* operator new(size_t size)
+{
+	g_allocations++;
+	if (void* p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+BENCH_NOINLINE void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+BENCH_NOINLINE void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+BENCH_NOINLINE void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+BENCH_NOINLINE void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+BENCH_NOINLINE void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace
+{
+	// facts of SubClassA (see SubClassA.cpp)
+	enum Fact
+	{
+		enemy_sighted = 1, enemy_dead, enemy_in_range, enemy_in_close_range, inventory_knife, inventory_gun,
+		gun_drawn, gun_loaded, have_ammo, knife_drawn, weapon_in_hand, me_dead
+	};
+	const int SubClassFacts = 12;
+
+	// the actions of SubClassA::initActionsHandler
+	void subClassActions(std::vector<Action>& actions)
+	{
+		Action scout("scoutStealthily", 5);
+		scout.setPrecondition(enemy_sighted, false);
+		scout.setPrecondition(weapon_in_hand, true);
+		scout.setEffect(enemy_sighted, true);
+		actions.push_back(scout);
+
+		Action run("scoutRunning", 15);
+		run.setPrecondition(enemy_sighted, false);
+		run.setEffect(enemy_sighted, true);
+		actions.push_back(run);
+
+		Action approach("closeToGunRange", 2);
+		approach.setPrecondition(enemy_sighted, true);
+		approach.setPrecondition(enemy_dead, false);
+		approach.setPrecondition(enemy_in_range, false);
+		approach.setPrecondition(gun_loaded, true);
+		approach.setEffect(enemy_in_range, true);
+		actions.push_back(approach);
+
+		Action approachClose("closeToKnifeRange", 4);
+		approachClose.setPrecondition(enemy_sighted, true);
+		approachClose.setPrecondition(enemy_dead, false);
+		approachClose.setPrecondition(enemy_in_close_range, false);
+		approachClose.setEffect(enemy_in_close_range, true);
+		actions.push_back(approachClose);
+
+		Action load("loadGun", 2);
+		load.setPrecondition(have_ammo, true);
+		load.setPrecondition(gun_loaded, false);
+		load.setPrecondition(gun_drawn, true);
+		load.setEffect(gun_loaded, true);
+		load.setEffect(have_ammo, false);
+		actions.push_back(load);
+
+		Action draw("drawGun", 1);
+		draw.setPrecondition(inventory_gun, true);
+		draw.setPrecondition(weapon_in_hand, false);
+		draw.setPrecondition(gun_drawn, false);
+		draw.setEffect(gun_drawn, true);
+		draw.setEffect(weapon_in_hand, true);
+		actions.push_back(draw);
+
+		Action holster("holsterGun", 1);
+		holster.setPrecondition(weapon_in_hand, true);
+		holster.setPrecondition(gun_drawn, true);
+		holster.setEffect(gun_drawn, false);
+		holster.setEffect(weapon_in_hand, false);
+		actions.push_back(holster);
+
+		Action drawKnife("drawKnife", 1);
+		drawKnife.setPrecondition(inventory_knife, true);
+		drawKnife.setPrecondition(weapon_in_hand, false);
+		drawKnife.setPrecondition(knife_drawn, false);
+		drawKnife.setEffect(knife_drawn, true);
+		drawKnife.setEffect(weapon_in_hand, true);
+		actions.push_back(drawKnife);
+
+		Action sheath("sheathKnife", 1);
+		sheath.setPrecondition(weapon_in_hand, true);
+		sheath.setPrecondition(knife_drawn, true);
+		sheath.setEffect(knife_drawn, false);
+		sheath.setEffect(weapon_in_hand, false);
+		actions.push_back(sheath);
+
+		Action shoot("shootEnemy", 3);
+		shoot.setPrecondition(enemy_sighted, true);
+		shoot.setPrecondition(enemy_dead, false);
+		shoot.setPrecondition(gun_drawn, true);
+		shoot.setPrecondition(gun_loaded, true);
+		shoot.setPrecondition(enemy_in_range, true);
+		shoot.setEffect(enemy_dead, true);
+		actions.push_back(shoot);
+
+		Action knife("knifeEnemy", 3);
+		knife.setPrecondition(enemy_sighted, true);
+		knife.setPrecondition(enemy_dead, false);
+		knife.setPrecondition(knife_drawn, true);
+		knife.setPrecondition(enemy_in_close_range, true);
+		knife.setEffect(enemy_dead, true);
+		actions.push_back(knife);
+
+		Action destruct("selfDestruct", 30);
+		destruct.setPrecondition(enemy_sighted, true);
+		destruct.setPrecondition(enemy_dead, false);
+		destruct.setPrecondition(enemy_in_range, true);
+		destruct.setEffect(enemy_dead, true);
+		destruct.setEffect(me_dead, true);
+		actions.push_back(destruct);
+	}
+
+	// the 12 facts of SubClassA, fact f taking the value of the bit f - 1 of values
+	// (SubClassA::initWorldStateHandler is 0x130 : have_ammo, inventory_knife and inventory_gun)
+	void subClassState(unsigned values, WorldState& state)
+	{
+		for (int fact = 1; fact <= SubClassFacts; fact++)
+		{
+			state.setVariable(fact, (values >> (fact - 1)) & 1);
+		}
+	}
+
+	// SubClassA::initGoalsHandler
+	void subClassGoal(WorldState& goal)
+	{
+		goal.setVariable(enemy_dead, true);
+		goal.setVariable(me_dead, false);
+		goal.setVariable(weapon_in_hand, true);
+	}
+
+	// a problem of a synthetic domain
+	struct Problem
+	{
+		std::vector<Action> actions;
+		WorldState start;
+		WorldState goal;
+	};
+
+	// count actions drawn from seed over facts facts, each one needing 1 to 3 facts and setting 1 or 2 facts,
+	// of cost 1 to 5. The goal is at most goal_facts of the facts changed by a random walk of walk actions
+	// from the start state, so it is reachable (false if the walk changed none)
+	bool syntheticProblem(unsigned seed, int facts, int count, int walk, int goal_facts, Problem& problem)
+	{
+		std::mt19937 random(seed);
+		problem.actions.clear();
+		for (int a = 0; a < count; a++)
+		{
+			Action action("a" + std::to_string(a), 1 + random() % 5);
+			const int preconditions = 1 + random() % 3;
+			for (int p = 0; p < preconditions; p++)
+			{
+				const int fact = random() % facts;
+				action.setPrecondition(fact, random() % 2);
+			}
+			const int effects = 1 + random() % 2;
+			for (int e = 0; e < effects; e++)
+			{
+				const int fact = random() % facts;
+				action.setEffect(fact, random() % 2);
+			}
+			problem.actions.push_back(action);
+		}
+		problem.start = WorldState();
+		for (int fact = 0; fact < facts; fact++)
+		{
+			problem.start.setVariable(fact, random() % 2);
+		}
+		WorldState state = problem.start;
+		std::vector<int> operable;
+		for (int step = 0; step < walk; step++)
+		{
+			operable.clear();
+			for (int a = 0; a < count; a++)
+			{
+				if (problem.actions[a].operableOn(state)) operable.push_back(a);
+			}
+			if (operable.empty()) break;
+			state = problem.actions[operable[random() % operable.size()]].actOn(state);
+		}
+		problem.goal = WorldState();
+		int changed = 0;
+		for (int fact = 0; fact < facts && changed < goal_facts; fact++)
+		{
+			if (state.vars_[fact] != problem.start.vars_[fact])
+			{
+				problem.goal.setVariable(fact, state.vars_[fact]);
+				changed++;
+			}
+		}
+		return changed > 0;
+	}
+
+	// cost of a plan (in reverse order)
+	int planCost(const std::vector<Action>& plan)
+	{
+		int cost = 0;
+		for (const Action& action : plan) cost += action.cost();
+		return cost;
+	}
+
+	double elapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// --------------------------------------------------------------------------
+
+	// the search of the planner before the bitset world states : states are std::map, the open list is kept sorted
+	// on F (sorted insert, front erase and full sort on a better G) and the open and closed lists are scanned
+	class ReferencePlanner
+	{
+	public:
+		typedef std::map<int, bool> State;
+
+		ReferencePlanner(const std::vector<Action>& actions)
+		{
+			for (const Action& action : actions)
+			{
+				Step step;
+				step.cost = action.cost();
+				// an action's effects are the variables it changes from any state operable on it
+				const WorldState effects = action.actOn(WorldState());
+				step.preconditions = toState(action.preconditions());
+				step.effects = toState(effects);
+				_steps.push_back(step);
+			}
+		}
+
+		// cost of the plan from start to goal, -1 if there is none
+		int plan(const WorldState& start, const WorldState& goal)
+		{
+			const State target = toState(goal);
+			_open.clear();
+			_closed.clear();
+			_open.push_back(Node{ toState(start), 0, distance(toState(start), target) });
+			while (!_open.empty())
+			{
+				_closed.push_back(std::move(_open.front()));
+				_open.erase(_open.begin());
+				const Node current = _closed.back();
+				if (distance(current.ws, target) == 0)
+				{
+					return current.g;
+				}
+				for (const Step& step : _steps)
+				{
+					if (distance(current.ws, step.preconditions) != 0) continue;
+					State outcome = current.ws;
+					for (const auto& effect : step.effects) outcome[effect.first] = effect.second;
+					if (std::find_if(_closed.begin(), _closed.end(), [&](const Node& n) { return n.ws == outcome; }) != _closed.end()) continue;
+					const int g = current.g + step.cost;
+					auto open = std::find_if(_open.begin(), _open.end(), [&](const Node& n) { return n.ws == outcome; });
+					if (open == _open.end())
+					{
+						Node node{ outcome, g, distance(outcome, target) };
+						_open.insert(std::lower_bound(_open.begin(), _open.end(), node), std::move(node));
+					}
+					else if (g < open->g)
+					{
+						open->g = g;
+						std::sort(_open.begin(), _open.end());
+					}
+				}
+			}
+			return -1;
+		}
+
+	protected:
+		struct Step
+		{
+			State preconditions;
+			State effects;
+			int cost;
+		};
+
+		struct Node
+		{
+			State ws;
+			int g;
+			int h;
+			bool operator<(const Node& other) const { return g + h < other.g + other.h; }
+		};
+
+		static State toState(const WorldState& ws)
+		{
+			State state;
+			for (int var = 0; var < GOAP_MAX_VARS; var++)
+			{
+				if (ws.care_.test(var)) state[var] = ws.vars_.test(var);
+			}
+			return state;
+		}
+
+		// number of variables of goal that state does not match
+		static int distance(const State& state, const State& goal)
+		{
+			int result = 0;
+			for (const auto& kv : goal)
+			{
+				auto found = state.find(kv.first);
+				if (found == state.end() || found->second != kv.second) result++;
+			}
+			return result;
+		}
+
+		std::vector<Step> _steps;
+		std::vector<Node> _open;
+		std::vector<Node> _closed;
+	};
+
+	// --------------------------------------------------------------------------
+
+	struct SearchResult
+	{
+		int problems = 0;
+		int found = 0;
+		int different = 0;
+		double plannerMs = 0;
+		double referenceMs = 0;
+	};
+
+	// plans each problem with the planner and the reference search, comparing the costs
+	void compareSearch(const Problem& problem, Planner& planner, std::vector<Action>& plan, SearchResult& result)
+	{
+		ReferencePlanner reference(problem.actions);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		const PlanStatus status = planner.plan(problem.start, problem.goal, problem.actions, plan);
+		result.plannerMs += elapsedMs(start);
+		start = std::chrono::steady_clock::now();
+		const int cost = reference.plan(problem.start, problem.goal);
+		result.referenceMs += elapsedMs(start);
+
+		result.problems++;
+		const bool found = status == PlanStatus::Found;
+		if (found) result.found++;
+		if (found != (cost != -1) || (found && (planCost(plan) != cost || !Planner::validate(problem.start, problem.goal, plan))))
+		{
+			result.different++;
+		}
+	}
+
+	void printSearch(const char* name, const SearchResult& result)
+	{
+		printf("%-22s %9d %7d %10d %12.3f %14.3f %8.1fx\n", name, result.problems, result.found, result.different,
+			result.plannerMs, result.referenceMs, result.referenceMs / std::max(result.plannerMs, 1e-6));
+	}
+
+	int searchBenchmark(int domains)
+	{
+		Planner planner;
+		std::vector<Action> plan;
+
+		SearchResult subClass;
+		Problem problem;
+		subClassActions(problem.actions);
+		subClassGoal(problem.goal);
+		for (unsigned values = 0; values < (1u << SubClassFacts); values++)
+		{
+			problem.start = WorldState();
+			subClassState(values, problem.start);
+			compareSearch(problem, planner, plan, subClass);
+		}
+
+		SearchResult synthetic;
+		for (unsigned seed = 1; synthetic.problems < domains; seed++)
+		{
+			if (!syntheticProblem(seed, 64, 64, 5, 3, problem)) continue;
+			compareSearch(problem, planner, plan, synthetic);
+		}
+
+		printf("%-22s %9s %7s %10s %12s %14s %9s\n", "domain", "problems", "found", "different", "planner ms", "reference ms", "speedup");
+		printSearch("SubClassA", subClass);
+		printSearch("synthetic 64 facts", synthetic);
+		const bool ok = subClass.different == 0 && synthetic.different == 0 && synthetic.found == synthetic.problems &&
+			subClass.plannerMs < subClass.referenceMs && synthetic.plannerMs < synthetic.referenceMs;
+		printf("%s\n", ok ? "same costs, planner faster" : "FAILED");
+		return ok ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// a SubClassA unit : its sensors set the 12 facts to the next value of a script
+	class BenchAgent : public GOAPInterface
+	{
+	public:
+		virtual void initActionsHandler(std::vector<Action>& actions) { subClassActions(actions); }
+		virtual void initWorldStateHandler(WorldState& wstate) { subClassState(0x130, wstate); }
+		virtual void initGoalsHandler(WorldState& goals) { subClassGoal(goals); }
+		virtual void sensorUpdate(WorldState& worldStates, const float) { subClassState(Values, worldStates); }
+		virtual void onUpdatePlan(std::vector<Action>& the_plan)
+		{
+			Plans++;
+			if (Record) Delivered.push_back(hashActions(the_plan));
+			if (Verify)
+			{
+				// the state sensed when the plan was requested
+				check.plan(initial_state, goal_win, all_actions, fresh);
+				if (hashActions(fresh) != hashActions(the_plan)) Stale++;
+			}
+		}
+
+		// as UnitGOAPPlannerAI::update_planner without a planning service
+		void updatePlanner()
+		{
+			sensorUpdate(initial_state, 0.4f);
+			if (checkPlan()) return;
+			computePlan();
+			Replans++;
+		}
+
+		unsigned Values = 0x130;
+		long Plans = 0;
+		long Replans = 0;
+		// hashes of the plans delivered, in order (if Record)
+		bool Record = false;
+		std::vector<std::size_t> Delivered;
+		// number of plans delivered which differ from a new search (if Verify)
+		bool Verify = false;
+		long Stale = 0;
+
+	protected:
+		Planner check;
+		std::vector<Action> fresh;
+	};
+
+	int allocationBenchmark(int replans)
+	{
+		std::vector<unsigned> script(64);
+		std::mt19937 random(11);
+		for (unsigned& values : script)
+		{
+			values = random() % (1u << SubClassFacts);
+		}
+
+		BenchAgent agent;
+		agent.initialize();
+		printf("%-14s %8s %8s %12s %14s\n", "path", "replans", "plans", "allocations", "us/replan");
+		bool ok = true;
+		for (int pass = 0; pass < 2; pass++)
+		{
+			const bool incremental = pass == 1;
+			auto update = [&](int tick)
+			{
+				agent.Values = script[tick % script.size()];
+				if (incremental)
+				{
+					agent.updatePlanner();
+				}
+				else
+				{
+					agent.sensorUpdate(agent.initial_state, 0.4f);
+					agent.computePlan();
+					agent.Replans++;
+				}
+			};
+			// warm-up : every state of the script once (twice for checkPlan, which sees each transition)
+			for (size_t tick = 0; tick < script.size() * 2; tick++) update((int)tick);
+
+			agent.Plans = agent.Replans = 0;
+			const size_t allocations = g_allocations;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int tick = 0; tick < replans; tick++) update(tick);
+			const double ms = elapsedMs(start);
+			const size_t allocated = g_allocations - allocations;
+			printf("%-14s %8ld %8ld %12zu %14.2f\n", incremental ? "checkPlan" : "computePlan", agent.Replans, agent.Plans,
+				allocated, ms * 1000 / replans);
+			ok = ok && allocated == 0 && agent.Plans > 0;
+		}
+		printf("%s\n", ok ? "no allocation once warm" : "FAILED");
+		return ok ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	struct TickResult
+	{
+		long plans = 0;
+		double p50 = 0;
+		double p99 = 0;
+		double max = 0;
+	};
+
+	void percentiles(std::vector<double>& times, TickResult& result)
+	{
+		std::sort(times.begin(), times.end());
+		auto percentile = [&](size_t p) { return times[std::min(times.size() - 1, times.size() * p / 100)]; };
+		result.p50 = percentile(50);
+		result.p99 = percentile(99);
+		result.max = times.back();
+	}
+
+	// values[tick][agent] : the facts sensed by each agent at each tick
+	typedef std::vector<std::vector<unsigned>> SensorScript;
+
+	// each agent replans at each tick, inline or through the service (when given); returns the plans delivered
+	TickResult runAgents(const SensorScript& values, std::vector<BenchAgent>& agents, PlanningService* service)
+	{
+		TickResult result;
+		std::vector<double> times;
+		for (const std::vector<unsigned>& tick : values)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			if (service) service->collect();
+			for (size_t a = 0; a < agents.size(); a++)
+			{
+				BenchAgent& agent = agents[a];
+				agent.Values = tick[a];
+				agent.sensorUpdate(agent.initial_state, 0.4f);
+				if (service)
+				{
+					service->request(&agent);
+				}
+				else
+				{
+					agent.computePlan();
+				}
+			}
+			if (service) service->dispatch();
+			times.push_back(elapsedMs(start));
+		}
+		if (service) service->collect();
+		for (BenchAgent& agent : agents) result.plans += agent.Plans;
+		percentiles(times, result);
+		return result;
+	}
+
+	int agentBenchmark(int count, int ticks, int workers)
+	{
+		SensorScript values(ticks, std::vector<unsigned>(count));
+		std::mt19937 random(5);
+		for (std::vector<unsigned>& tick : values)
+		{
+			for (unsigned& agent : tick) agent = random() % (1u << SubClassFacts);
+		}
+
+		std::vector<BenchAgent> inline_agents(count), service_agents(count);
+		for (std::vector<BenchAgent>* agents : { &inline_agents, &service_agents })
+		{
+			for (BenchAgent& agent : *agents)
+			{
+				agent.initialize();
+				agent.Record = true;
+			}
+		}
+
+		const TickResult inline_result = runAgents(values, inline_agents, nullptr);
+		PlanningService service(workers);
+		const TickResult service_result = runAgents(values, service_agents, &service);
+
+		int different = 0;
+		for (int a = 0; a < count; a++)
+		{
+			if (inline_agents[a].Delivered != service_agents[a].Delivered) different++;
+		}
+
+		printf("%-18s %8s %10s %10s %10s\n", "path", "plans", "p50 ms", "p99 ms", "max ms");
+		printf("%-18s %8ld %10.3f %10.3f %10.3f\n", "inline", inline_result.plans, inline_result.p50, inline_result.p99, inline_result.max);
+		char name[32];
+		snprintf(name, sizeof(name), "service (%d)", service.workerCount());
+		printf("%-18s %8ld %10.3f %10.3f %10.3f\n", name, service_result.plans, service_result.p50, service_result.p99, service_result.max);
+		printf("%d agents with different plans, cache hit rate %.1f%%\n", different, service.cache().hitRate() * 100);
+
+		bool ok = different == 0 && inline_result.plans == service_result.plans && inline_result.plans > 0;
+		// a single hardware thread solves the requests while the game thread waits for them
+		if (std::thread::hardware_concurrency() >= 2)
+		{
+			ok = ok && service_result.p50 < inline_result.p50;
+		}
+		printf("%s\n", ok ? "same plans" : "FAILED");
+		return ok ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	struct ReplayResult
+	{
+		// cache hits at each tick
+		std::vector<std::size_t> hits;
+		float hitRate = 0;
+		long plans = 0;
+		long stale = 0;
+		double p50 = 0;
+	};
+
+	// the agents request a plan at each tick through the service; the cost of shootEnemy changes at change_tick
+	ReplayResult replay(const SensorScript& values, int change_tick, bool verify)
+	{
+		ReplayResult result;
+		std::vector<BenchAgent> agents(values.front().size());
+		for (BenchAgent& agent : agents)
+		{
+			agent.initialize();
+			agent.Verify = verify;
+		}
+		PlanningService service;
+		std::vector<double> times;
+		for (int tick = 0; tick < (int)values.size(); tick++)
+		{
+			if (tick == change_tick)
+			{
+				for (BenchAgent& agent : agents)
+				{
+					for (Action& action : agent.all_actions)
+					{
+						if (action.name() == "shootEnemy") action.setCost(action.cost() + 1);
+					}
+				}
+			}
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			const std::size_t hits = service.cache().hits();
+			service.collect();
+			for (size_t a = 0; a < agents.size(); a++)
+			{
+				agents[a].Values = values[tick][a];
+				agents[a].sensorUpdate(agents[a].initial_state, 0.4f);
+				service.request(&agents[a]);
+			}
+			service.dispatch();
+			times.push_back(elapsedMs(start));
+			result.hits.push_back(service.cache().hits() - hits);
+		}
+		service.collect();
+		for (BenchAgent& agent : agents)
+		{
+			result.plans += agent.Plans;
+			result.stale += agent.Stale;
+		}
+		result.hitRate = service.cache().hitRate();
+		std::sort(times.begin(), times.end());
+		result.p50 = times[times.size() / 2];
+		return result;
+	}
+
+	int cacheBenchmark(int count, int ticks)
+	{
+		// 4 fact vectors : idle, gun drawn, gun loaded, knife drawn
+		const unsigned profiles[] = { 0x130, 0x570, 0x4f0, 0x730 };
+		SensorScript values(ticks, std::vector<unsigned>(count));
+		std::vector<unsigned> base(count), toggled(count, 0);
+		std::mt19937 random(17);
+		for (int a = 0; a < count; a++) base[a] = profiles[a % 4];
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			for (int a = 0; a < count; a++)
+			{
+				if (random() % 100 < 5)
+				{
+					toggled[a] = toggled[a] ? 0 : 1u << (random() % SubClassFacts);
+				}
+				values[tick][a] = base[a] ^ toggled[a];
+			}
+		}
+
+		const int change_tick = ticks / 2;
+		const ReplayResult timed = replay(values, change_tick, false);
+		const ReplayResult verified = replay(values, change_tick, true);
+
+		printf("%d agents, %d ticks : %ld plans, hit rate %.1f%%, %.3f ms per tick (p50)\n", count, ticks, timed.plans,
+			timed.hitRate * 100, timed.p50);
+		printf("hits at the cost change (tick %d) : %zu, at the next tick : %zu\n", change_tick, timed.hits[change_tick],
+			change_tick + 1 < ticks ? timed.hits[change_tick + 1] : 0);
+		printf("stale plans : %ld\n", verified.stale);
+		const bool ok = timed.hitRate >= 0.9f && timed.hits[change_tick] == 0 && (change_tick + 1 >= ticks || timed.hits[change_tick + 1] > 0) &&
+			verified.stale == 0 && verified.plans == timed.plans;
+		printf("%s\n", ok ? "cache hits, invalidated by the cost change" : "FAILED");
+		return ok ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	struct RepairResult
+	{
+		long replans = 0;
+		// plans held at the end of the ticks, plans which did not reach the goal, and their total cost
+		long held = 0;
+		long invalid = 0;
+		long cost = 0;
+		double ms = 0;
+		std::vector<std::vector<std::size_t>> delivered;
+	};
+
+	// the agents replan at each tick, or only when their plan can neither be validated nor repaired
+	RepairResult runRepair(const SensorScript& values, bool incremental)
+	{
+		RepairResult result;
+		std::vector<BenchAgent> agents(values.front().size());
+		for (BenchAgent& agent : agents)
+		{
+			agent.initialize();
+			agent.Record = true;
+		}
+		for (const std::vector<unsigned>& tick : values)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (size_t a = 0; a < agents.size(); a++)
+			{
+				BenchAgent& agent = agents[a];
+				agent.Values = tick[a];
+				if (incremental)
+				{
+					agent.updatePlanner();
+				}
+				else
+				{
+					agent.sensorUpdate(agent.initial_state, 0.4f);
+					agent.computePlan();
+					agent.Replans++;
+				}
+			}
+			result.ms += elapsedMs(start);
+
+			for (BenchAgent& agent : agents)
+			{
+				if (agent.current_plan.empty()) continue;
+				result.held++;
+				result.cost += planCost(agent.current_plan);
+				if (!Planner::validate(agent.initial_state, agent.goal_win, agent.current_plan)) result.invalid++;
+			}
+		}
+		for (BenchAgent& agent : agents)
+		{
+			result.replans += agent.Replans;
+			result.delivered.push_back(agent.Delivered);
+		}
+		return result;
+	}
+
+	int repairBenchmark(int count, int ticks)
+	{
+		const unsigned profiles[] = { 0x130, 0x570, 0x4f0, 0x730 };
+		SensorScript values(ticks, std::vector<unsigned>(count));
+		std::vector<unsigned> state(count);
+		std::mt19937 random(23);
+		for (int a = 0; a < count; a++) state[a] = profiles[a % 4];
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			for (int flip = 0; flip < 50; flip++)
+			{
+				const int agent = random() % count;
+				state[agent] ^= 1u << (random() % SubClassFacts);
+			}
+			values[tick] = state;
+		}
+
+		const RepairResult replan = runRepair(values, false);
+		const RepairResult incremental = runRepair(values, true);
+		const RepairResult again = runRepair(values, true);
+
+		printf("%-12s %9s %9s %9s %10s %12s\n", "path", "replans", "plans", "invalid", "avg cost", "ms per tick");
+		for (const RepairResult* result : { &replan, &incremental })
+		{
+			printf("%-12s %9ld %9ld %9ld %10.2f %12.3f\n", result == &replan ? "replan" : "incremental", result->replans,
+				result->held, result->invalid, (double)result->cost / std::max(1L, result->held), result->ms / ticks);
+		}
+		const bool deterministic = again.delivered == incremental.delivered && again.replans == incremental.replans;
+		printf("incremental runs %s\n", deterministic ? "identical" : "DIFFERENT");
+		const bool ok = deterministic && replan.invalid == 0 && incremental.invalid == 0 && incremental.replans < replan.replans &&
+			incremental.ms < replan.ms && incremental.cost * replan.held <= replan.cost * incremental.held * 5 / 4;
+		printf("%s\n", ok ? "valid plans, fewer replans" : "FAILED");
+		return ok ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// the steps of a plan (in reverse order) are operable one after the other from start
+	bool operable(const WorldState& start, const std::vector<Action>& plan)
+	{
+		WorldState state = start;
+		for (auto rit = plan.rbegin(); rit != plan.rend(); ++rit)
+		{
+			if (!rit->operableOn(state)) return false;
+			state = rit->actOn(state);
+		}
+		return true;
+	}
+
+	// a synthetic problem over facts facts of which the goal also needs fact 63, which no action sets
+	bool unreachableProblem(unsigned seed, int facts, Problem& problem)
+	{
+		if (!syntheticProblem(seed, facts, 400, 5, 3, problem)) return false;
+		for (int fact = facts; fact < 64; fact++)
+		{
+			problem.start.setVariable(fact, false);
+		}
+		problem.goal.setVariable(63, true);
+		return true;
+	}
+
+	struct StressResult
+	{
+		int searches = 0;
+		int partial = 0;
+		int notFound = 0;
+		int exceptions = 0;
+		int inoperable = 0;
+		// the longest search, and the longest of the fastest runs of each problem
+		double worstMs = 0;
+		double maxMs = 0;
+	};
+
+	// runs the search of the problem runs times
+	void stress(const Problem& problem, Planner& planner, std::vector<Action>& plan, int runs, StressResult& result)
+	{
+		double fastest = 0;
+		for (int run = 0; run < runs; run++)
+		{
+			result.searches++;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			try
+			{
+				const PlanStatus status = planner.plan(problem.start, problem.goal, problem.actions, plan);
+				if (status == PlanStatus::Partial) result.partial++;
+				if (status == PlanStatus::NotFound) result.notFound++;
+				if (!operable(problem.start, plan)) result.inoperable++;
+			}
+			catch (const std::exception&)
+			{
+				result.exceptions++;
+			}
+			const double ms = elapsedMs(start);
+			result.worstMs = std::max(result.worstMs, ms);
+			fastest = run == 0 ? ms : std::min(fastest, ms);
+		}
+		result.maxMs = std::max(result.maxMs, fastest);
+	}
+
+	int unreachableBenchmark(int domains, float budget, int expansions)
+	{
+		Planner planner;
+		std::vector<Action> plan;
+		Problem problem;
+
+		StressResult timed, expanded, exhausted;
+		planner.setBudget(0, budget);
+		for (unsigned seed = 1; timed.searches < domains * 3; seed++)
+		{
+			if (unreachableProblem(seed, 63, problem)) stress(problem, planner, plan, 3, timed);
+		}
+		planner.setBudget(expansions);
+		for (unsigned seed = 1; expanded.searches < domains; seed++)
+		{
+			if (unreachableProblem(seed, 63, problem)) stress(problem, planner, plan, 1, expanded);
+		}
+		planner.setBudget(0);
+		for (unsigned seed = 1; exhausted.searches < domains; seed++)
+		{
+			if (unreachableProblem(seed, 8, problem)) stress(problem, planner, plan, 1, exhausted);
+		}
+
+		printf("%-18s %9s %8s %9s %11s %11s %8s %9s\n", "budget", "searches", "partial", "notfound", "exceptions", "inoperable",
+			"max ms", "worst ms");
+		char name[32];
+		snprintf(name, sizeof(name), "%.2f ms", budget);
+		const std::string names[] = { name, std::to_string(expansions) + " expansions", "none (8 facts)" };
+		const StressResult* results[] = { &timed, &expanded, &exhausted };
+		bool ok = true;
+		for (int r = 0; r < 3; r++)
+		{
+			const StressResult& result = *results[r];
+			printf("%-18s %9d %8d %9d %11d %11d %8.3f %9.3f\n", names[r].c_str(), result.searches, result.partial, result.notFound,
+				result.exceptions, result.inoperable, result.maxMs, result.worstMs);
+			ok = ok && result.exceptions == 0 && result.inoperable == 0;
+		}
+		ok = ok && timed.partial == timed.searches && timed.maxMs <= budget + 1.0 && expanded.partial == expanded.searches &&
+			exhausted.notFound == exhausted.searches;
+		printf("%s\n", ok ? "bounded searches, no exception" : "FAILED");
+		return ok ? 0 : 1;
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	int domains = 20;
+	bool allocations = false;
+	int replans = 1000;
+	int agents = 0;
+	int ticks = 0;
+	int workers = 0;
+	bool cache = false;
+	bool repair = false;
+	bool unreachable = false;
+	float budget = 2.f;
+	int expansions = 8192;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--domains") && i + 1 < argc) domains = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--allocations")) allocations = true;
+		else if (!strcmp(argv[i], "--replans") && i + 1 < argc) replans = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--agents") && i + 1 < argc) agents = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--workers") && i + 1 < argc) workers = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--cache")) cache = true;
+		else if (!strcmp(argv[i], "--repair")) repair = true;
+		else if (!strcmp(argv[i], "--unreachable")) unreachable = true;
+		else if (!strcmp(argv[i], "--budget") && i + 1 < argc) budget = std::max(0.01f, (float)atof(argv[++i]));
+		else if (!strcmp(argv[i], "--expansions") && i + 1 < argc) expansions = std::max(1, atoi(argv[++i]));
+	}
+
+	if (unreachable)
+	{
+		return unreachableBenchmark(domains, budget, expansions);
+	}
+
+	if (repair)
+	{
+		return repairBenchmark(agents ? agents : 1000, ticks ? ticks : 200);
+	}
+
+	if (cache)
+	{
+		return cacheBenchmark(agents ? agents : 1000, ticks ? ticks : 200);
+	}
+
+	if (agents)
+	{
+		return agentBenchmark(agents, ticks ? ticks : 50, workers);
+	}
+
+	if (allocations)
+	{
+		return allocationBenchmark(replans);
+	}
+
+	return searchBenchmark(domains);
+}
+
+#endif
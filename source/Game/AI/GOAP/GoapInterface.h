@@ -38,6 +38,8 @@
 #include <thread>
 #include "Action.h"
 #include "WorldState.h"
+#include "GoapPlanner.h"
+#include "GoapTrace.h"
 
 namespace goap
 {
@@ -60,6 +62,11 @@ namespace goap
 		virtual void onUpdatePlan(std::vector<Action>& the_plan) = 0;
 		// called when the planer 
 		void computePlan();
+		// store a plan computed elsewhere (e.g. by a PlanningService) and notify it
+		void updatePlan(const std::vector<Action>& the_plan);
+		// keep the current plan if it still reaches the goal from initial_state, or repair it
+		// (notifying onUpdatePlan); returns false if a new plan must be computed
+		bool checkPlan();
 		// initialize the Goap planner
 		void initialize()
 		{
@@ -70,6 +77,12 @@ namespace goap
 		WorldState initial_state;
 		WorldState goal_win;
 		std::vector<Action> all_actions;
+		// planner reused by every computePlan (owns its node arena, not shared between instances)
+		Planner planner;
+		// last computed plan, in reverse order (storage reused between plans)
+		std::vector<Action> current_plan;
+		// optional receiver of the planner diagnostics (debug builds only)
+		TraceSink trace_sink = nullptr;
 		
 	};
 	
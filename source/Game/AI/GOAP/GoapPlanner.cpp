@@ -1,153 +1,257 @@
 #include "GoapPlanner.h"
 #include "GoapInterface.h"
+#include "GoapTrace.h"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
 
-goap::Planner::Planner() {
+goap::Planner::Planner() : states_count_(0), max_expansions_(0), max_milliseconds_(0.f), heuristic_weight_(1.f) {
 }
 
 void goap::GOAPInterface::computePlan()
 {
-	goap::Planner as;
-	try {
-		std::vector<Action> the_plan;
-		the_plan = as.plan(initial_state, goal_win, all_actions);
-		std::cout << "Found a path!\n";
-		for (std::vector<Action>::reverse_iterator rit = the_plan.rbegin(); rit != the_plan.rend(); ++rit) {
-			std::cout << rit->name() << std::endl;
-		}
-		onUpdatePlan(the_plan);
+	const PlanStatus status = planner.plan(initial_state, goal_win, all_actions, current_plan);
+	if (status == PlanStatus::NotFound) {
+		GOAPTrace(trace_sink, "Sorry, could not find a path!");
+		return;
 	}
-	catch (const std::exception&) {
-		std::cout << "Sorry, could not find a path!\n";
+	GOAPTrace(trace_sink, status == PlanStatus::Found ? "Found a path!" : "Out of budget, partial path:");
+	for (std::vector<Action>::reverse_iterator rit = current_plan.rbegin(); rit != current_plan.rend(); ++rit) {
+		GOAPTrace(trace_sink, "%s", rit->name().c_str());
 	}
+	onUpdatePlan(current_plan);
+}
+
+void goap::GOAPInterface::updatePlan(const std::vector<Action>& the_plan)
+{
+	current_plan = the_plan;
+	onUpdatePlan(current_plan);
+}
+
+bool goap::GOAPInterface::checkPlan()
+{
+	if (Planner::validate(initial_state, goal_win, current_plan)) {
+		return true;
+	}
+	if (!planner.repair(initial_state, goal_win, all_actions, current_plan)) {
+		return false;
+	}
+	GOAPTrace(trace_sink, "Repaired the plan, %d steps", (int)current_plan.size());
+	onUpdatePlan(current_plan);
+	return true;
 }
 
 int goap::Planner::calculateHeuristic(const WorldState& now, const WorldState& goal) const {
-    return now.distanceTo(goal);
+    const int distance = now.distanceTo(goal);
+    return heuristic_weight_ == 1.f ? distance : static_cast<int>(heuristic_weight_ * distance + 0.5f);
 }
 
-void goap::Planner::addToOpenList(Node&& n) {
-    // insert maintaining sort order
-    auto it = std::lower_bound(begin(open_),
-                               end(open_),
-                               n);
-    open_.emplace(it, std::move(n));
+// Heap ordering: lowest F on top, ties broken on the lowest H, then on the most
+// recently created node (as the former sorted insert did)
+static bool worseThan(const goap::Node& lhs, const goap::Node& rhs) {
+    if (lhs.f() != rhs.f()) {
+        return lhs.f() > rhs.f();
+    }
+    if (lhs.h_ != rhs.h_) {
+        return lhs.h_ > rhs.h_;
+    }
+    return lhs.id_ < rhs.id_;
 }
 
-goap::Node& goap::Planner::popAndClose() {
-    assert(!open_.empty());
-    closed_.push_back(std::move(open_.front()));
-    open_.erase(open_.begin());
+void goap::Planner::reset() {
+    nodes_.clear();
+    open_.clear();
+    std::fill(begin(states_), end(states_), -1);
+    states_count_ = 0;
+}
 
-    return closed_.back();
+int& goap::Planner::stateSlot(const WorldState& ws) {
+    const std::size_t mask = states_.size() - 1;
+    std::size_t i = WorldStateHash()(ws) & mask;
+    while (states_[i] != -1 && !(nodes_[states_[i]].ws_ == ws)) {
+        i = (i + 1) & mask;
+    }
+    return states_[i];
 }
 
-bool goap::Planner::memberOfClosed(const WorldState& ws) const {
-    if (std::find_if(begin(closed_), end(closed_), [&](const Node & n) { return n.ws_ == ws; }) == end(closed_)) {
-        return false;
+void goap::Planner::reserveStateSlot() {
+    if ((states_count_ + 1) * 2 <= states_.size()) {
+        return;
     }
-    return true;
+    std::vector<int> previous(states_.size() < 64 ? 64 : states_.size() * 2, -1);
+    previous.swap(states_);
+    for (int id : previous) {
+        if (id != -1) {
+            stateSlot(nodes_[id].ws_) = id;
+        }
+    }
+}
+
+int goap::Planner::addToOpenList(const WorldState& ws, int g, int h, int parent_id, const Action* action) {
+    const int id = static_cast<int>(nodes_.size());
+    nodes_.emplace_back(ws, id, g, h, parent_id, action);
+    open_.push_back(id);
+    std::push_heap(begin(open_), end(open_), [this](int lhs, int rhs) { return worseThan(nodes_[lhs], nodes_[rhs]); });
+    return id;
 }
 
-std::vector<goap::Node>::iterator goap::Planner::memberOfOpen(const WorldState& ws) {
-    return std::find_if(begin(open_), end(open_), [&](const Node & n) { return n.ws_ == ws; });
+int goap::Planner::popAndClose() {
+    while (!open_.empty()) {
+        std::pop_heap(begin(open_), end(open_), [this](int lhs, int rhs) { return worseThan(nodes_[lhs], nodes_[rhs]); });
+        const int id = open_.back();
+        open_.pop_back();
+
+        // Skip entries superseded by a cheaper path to the same worldstate
+        if (stateSlot(nodes_[id].ws_) != id) {
+            continue;
+        }
+        nodes_[id].closed_ = true;
+        return id;
+    }
+    return -1;
 }
 
 void goap::Planner::printOpenList() const {
-    for (const auto& n : open_) {
-        std::cout << n << std::endl;
+    for (int id : open_) {
+        std::cout << nodes_[id] << std::endl;
     }
 }
 
 void goap::Planner::printClosedList() const {
-    for (const auto& n : closed_) {
-        std::cout << n << std::endl;
+    for (const auto& n : nodes_) {
+        if (n.closed_) {
+            std::cout << n << std::endl;
+        }
     }
 }
 
 std::vector<goap::Action> goap::Planner::plan(const WorldState& start, const WorldState& goal, const std::vector<Action>& actions) {
+    std::vector<goap::Action> the_plan;
+    if (plan(start, goal, actions, the_plan) != PlanStatus::Found) {
+        throw std::runtime_error("A* planner could not find a path from start to goal");
+    }
+    return the_plan;
+}
+
+goap::PlanStatus goap::Planner::plan(const WorldState& start, const WorldState& goal, const std::vector<Action>& actions, std::vector<Action>& the_plan) {
+    the_plan.clear();
     if (start.meetsGoal(goal)) {
         //throw std::runtime_error("Planner cannot plan when the start state and the goal state are the same!");
-        return std::vector<goap::Action>();
+        return PlanStatus::Found;
     }
 
-    // Feasible we'd re-use a planner, so clear out the prior results
-    open_.clear();
-    closed_.clear();
-
-    Node starting_node(start, 0, calculateHeuristic(start, goal), 0, nullptr);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<long long>(max_milliseconds_ * 1000.f));
+    int expansions = 0;
+    int best = -1; // the closed node nearest to the goal, the end of a partial plan
 
-    open_.push_back(std::move(starting_node));
+    // Feasible we'd re-use a planner, so clear out the prior results
+    reset();
 
-    //int iters = 0;
-    while (open_.size() > 0) {
-        //++iters;
-        //std::cout << "\n-----------------------\n";
-        //std::cout << "Iteration " << iters << std::endl;
+    // Nodes only carry the state bits, not the (possibly heap-allocated) name
+    WorldState start_bits;
+    start_bits.vars_ = start.vars_;
+    start_bits.care_ = start.care_;
+    reserveStateSlot();
+    stateSlot(start_bits) = addToOpenList(start_bits, 0, calculateHeuristic(start, goal), -1, nullptr);
+    ++states_count_;
 
-        // Look for Node with the lowest-F-score on the open list. Switch it to closed,
-        // and hang onto it -- this is our latest node.
-        Node& current(popAndClose());
+    // Look for Node with the lowest-F-score on the open list. Switch it to closed,
+    // and hang onto it -- this is our latest node. Nodes are referred to by ID:
+    // the arena may reallocate while we expand the current one.
+    int current;
+    while ((current = popAndClose()) != -1) {
+        // Is our current state the goal state? If so, we've found a path, yay.
+        if (nodes_[current].ws_.meetsGoal(goal)) {
+            buildPlan(current, the_plan);
+            return PlanStatus::Found;
+        }
 
-        //std::cout << "Open list\n";
-        //printOpenList();
-        //std::cout << "Closed list\n";
-        //printClosedList();
-        //std::cout << "\nCurrent is " << current << " : " << (current.action_ == nullptr ? "" : current.action_->name()) << std::endl;
+        if (best == -1 || nodes_[current].h_ < nodes_[best].h_ ||
+            (nodes_[current].h_ == nodes_[best].h_ && nodes_[current].g_ < nodes_[best].g_)) {
+            best = current;
+        }
 
-        // Is our current state the goal state? If so, we've found a path, yay.
-        if (current.ws_.meetsGoal(goal)) {
-            std::vector<Action> the_plan;
-            do {
-                the_plan.push_back(*current.action_);
-                auto itr = std::find_if(begin(open_), end(open_), [&](const Node & n) { return n.id_ == current.parent_id_; });
-                if (itr == end(open_)) {
-                    itr = std::find_if(begin(closed_), end(closed_), [&](const Node & n) { return n.id_ == current.parent_id_; });
-                }
-                current = *itr;
-            } while (current.parent_id_ != 0);
-            return the_plan;
+        // Out of budget: settle for the path to the closest state explored so far
+        ++expansions;
+        if ((max_expansions_ > 0 && expansions >= max_expansions_) ||
+            (max_milliseconds_ > 0.f && std::chrono::steady_clock::now() >= deadline)) {
+            buildPlan(best, the_plan);
+            return PlanStatus::Partial;
         }
 
         // Check each node REACHABLE from current -- in other words, where can we go from here?
         for (const auto& potential_action : actions) {
-            if (potential_action.operableOn(current.ws_)) {
-                WorldState outcome = potential_action.actOn(current.ws_);
+            if (potential_action.operableOn(nodes_[current].ws_)) {
+                WorldState outcome = potential_action.actOn(nodes_[current].ws_);
 
-                // Skip if already closed
-                if (memberOfClosed(outcome)) {
+                // Look for a Node with this WorldState. Skip it if already closed; only
+                // (re)open it when there is none yet or the current G is better than the recorded G
+                const int g = nodes_[current].g_ + potential_action.cost();
+                reserveStateSlot();
+                int& slot = stateSlot(outcome);
+                if (slot == -1) {
+                    ++states_count_;
+                } else if (nodes_[slot].closed_ || g >= nodes_[slot].g_) {
                     continue;
                 }
-
-                //std::cout << potential_action.name() << " will get us to " << outcome << std::endl;
-
-                // Look for a Node with this WorldState on the open list.
-                auto p_outcome_node = memberOfOpen(outcome);
-                if (p_outcome_node == end(open_)) { // not a member of open list
-                    // Make a new node, with current as its parent, recording G & H
-                    Node found(outcome, current.g_ + potential_action.cost(), calculateHeuristic(outcome, goal), current.id_, &potential_action);
-                    // Add it to the open list (maintaining sort-order therein)
-                    addToOpenList(std::move(found));
-                } else { // already a member of the open list
-                    // check if the current G is better than the recorded G
-                    if (current.g_ + potential_action.cost() < p_outcome_node->g_) {
-                        //std::cout << "My path to " << p_outcome_node->ws_ << " using " << potential_action.name() << " (combined cost " << current.g_ + potential_action.cost() << ") is better than existing (cost " <<  p_outcome_node->g_ << "\n";
-                        p_outcome_node->parent_id_ = current.id_;                  // make current its parent
-                        p_outcome_node->g_ = current.g_ + potential_action.cost(); // recalc G & H
-                        p_outcome_node->h_ = calculateHeuristic(outcome, goal);
-                        p_outcome_node->action_ = &potential_action;
-
-                        // resort open list to account for the new F
-                        // sorting likely invalidates the p_outcome_node iterator, but we don't need it anymore
-                        std::sort(begin(open_), end(open_));
-                    }
-                }
+                // Make a new node, with current as its parent, recording G & H
+                slot = addToOpenList(outcome, g, calculateHeuristic(outcome, goal), current, &potential_action);
             }
         }
     }
 
     // If there's nothing left to evaluate, then we have no possible path left
-    throw std::runtime_error("A* planner could not find a path from start to goal");
+    return PlanStatus::NotFound;
+}
+
+void goap::Planner::buildPlan(int id, std::vector<Action>& the_plan) const {
+    for (; nodes_[id].parent_id_ != -1; id = nodes_[id].parent_id_) {
+        the_plan.push_back(*nodes_[id].action_);
+    }
+}
+
+bool goap::Planner::validate(const WorldState& start, const WorldState& goal, const std::vector<Action>& the_plan) {
+    return validate(start, goal, the_plan, the_plan.size());
+}
+
+bool goap::Planner::validate(const WorldState& start, const WorldState& goal, const std::vector<Action>& the_plan, std::size_t steps) {
+    WorldState state;
+    state.vars_ = start.vars_;
+    state.care_ = start.care_;
+    // REVERSE ORDER: the next step is the last one
+    for (std::size_t i = steps; i-- > 0; ) {
+        if (!the_plan[i].operableOn(state)) {
+            return false;
+        }
+        state = the_plan[i].actOn(state);
+    }
+    return state.meetsGoal(goal);
+}
+
+bool goap::Planner::repair(const WorldState& start, const WorldState& goal, const std::vector<Action>& actions, std::vector<Action>& the_plan, int max_skipped) {
+    const std::size_t steps = the_plan.size();
+    for (std::size_t skipped = 0; skipped <= static_cast<std::size_t>(max_skipped) && skipped < steps; ++skipped) {
+        // The remaining chain is the_plan[0, kept), its next step the_plan[kept - 1]
+        const std::size_t kept = steps - skipped;
+        if (plan(start, the_plan[kept - 1].preconditions(), actions, repair_) != PlanStatus::Found) {
+            continue;
+        }
+
+        WorldState state;
+        state.vars_ = start.vars_;
+        state.care_ = start.care_;
+        for (auto rit = repair_.rbegin(); rit != repair_.rend(); ++rit) {
+            state = rit->actOn(state);
+        }
+        if (!validate(state, goal, the_plan, kept)) {
+            continue;
+        }
+
+        the_plan.resize(kept);
+        the_plan.insert(the_plan.end(), repair_.begin(), repair_.end());
+        return true;
+    }
+    return false;
 }
@@ -12,8 +12,8 @@
 #include "Node.h"
 #include "WorldState.h"
 
+#include <cstddef>
 #include <ostream>
-#include <unordered_map>
 #include <vector>
 
 // To support Google Test for private members
@@ -22,40 +22,67 @@
 #endif
 
 namespace goap {
+    /**
+     Outcome of Planner::plan.
+     */
+    enum class PlanStatus {
+        Found,      // the plan reaches the goal
+        Partial,    // the budget ran out: the plan leads to the explored state closest to the goal
+        NotFound    // the goal cannot be reached with the available actions
+    };
+
     class Planner {
     private:
-        std::vector<Node> open_;   // The A* open list
-        std::vector<Node> closed_; // The A* closed list
+        // Node arena: every node created by the current plan, indexed by node ID.
+        // All the storage below is cleared (not freed) between plans, so a planner
+        // that is reused stops allocating once it has seen its largest search.
+        std::vector<Node> nodes_;
+
+        std::vector<int> open_;    // The A* open list: a binary min-heap on F of node IDs
+
+        // Open-addressing hash table (linear probing, power-of-two size) mapping a
+        // worldstate to the ID of the best node reaching it, -1 for empty slots.
+        // An improved path overwrites the slot, and the superseded node is skipped
+        // when popped from the open list.
+        std::vector<int> states_;
+        std::size_t states_count_;
+
+        std::vector<Action> repair_; // The sub-plan spliced by repair()
+
+        int max_expansions_;        // Maximum number of nodes expanded by one plan, 0 for no limit
+        float max_milliseconds_;    // Maximum duration of one plan, 0 for no limit
+        float heuristic_weight_;    // Weight of the heuristic: 1 for A*, above 1 for a faster weighted A*
 
         /**
-         Is the given worldstate a member of the closed list? (And by that we mean,
-         does any node on the closed list contain an equal worldstate.)
-         @param ws the worldstate in question
-         @return true if it's been closed, false if not
+         Clears the results of a prior plan, keeping the allocated storage.
          */
-        bool memberOfClosed(const WorldState& ws) const;
+        void reset();
 
         /**
-         Is the given worldstate a member of the open list? (And by that we mean,
-         does any node on the open list contain an equal worldstate.)
+         Finds the slot of the given worldstate in the state table: either the slot
+         holding the ID of the node reaching it, or the empty slot where it belongs.
          @param ws the worldstate in question
-         @return a pointer to the note if found, end(open_) if not
+         @return a reference to the slot
          */
-        std::vector<goap::Node>::iterator memberOfOpen(const WorldState& ws);
+        int& stateSlot(const WorldState& ws);
 
         /**
-         Pops the first Node from the 'open' list, moves it to the 'closed' list, and
-         returns a reference to this newly-closed Node. Its behavior is undefined if
-         you call on an empty list.
-         @return a reference to the newly closed Node
+         Doubles the state table when it is half full, rehashing the nodes it holds.
          */
-        Node& popAndClose();
+        void reserveStateSlot();
 
         /**
-         Moves the given Node (an rvalue reference) into the 'open' list.
-         @param an rvalue reference to a Node that will be moved to the open list
+         Pops the lowest-F Node from the 'open' list, skipping entries superseded by a
+         cheaper path, and marks it closed.
+         @return the ID of the newly closed Node, -1 if the open list ran dry
          */
-        void addToOpenList(Node&&);
+        int popAndClose();
+
+        /**
+         Creates a node in the arena and pushes it onto the 'open' list.
+         @return the ID of the new node
+         */
+        int addToOpenList(const WorldState& ws, int g, int h, int parent_id, const Action* action);
 
         /**
          Given two worldstates, calculates an estimated distance (the A* 'heuristic')
@@ -66,9 +93,36 @@ namespace goap {
          */
         int calculateHeuristic(const WorldState& now, const WorldState& goal) const;
 
+        /**
+         Walks back from the given node to the start node.
+         @param id the ID of the last node of the path
+         @param the_plan receives the Actions of the path in REVERSE ORDER
+         */
+        void buildPlan(int id, std::vector<Action>& the_plan) const;
+
     public:
         Planner();
 
+        /**
+         Bounds the work of each plan. When a bound is hit, plan() stops and returns the
+         path to the explored worldstate closest to the goal (PlanStatus::Partial).
+         @param max_expansions the maximum number of expanded nodes, 0 for no limit
+         @param max_milliseconds the maximum duration, 0 for no limit
+         */
+        void setBudget(int max_expansions, float max_milliseconds = 0.f) {
+            max_expansions_ = max_expansions;
+            max_milliseconds_ = max_milliseconds;
+        }
+
+        /**
+         Sets the weight of the heuristic (weighted A*). Above 1, the search expands far
+         fewer nodes but the plans may cost up to 'weight' times the optimal cost.
+         @param weight the weight, 1 by default
+         */
+        void setHeuristicWeight(float weight) {
+            heuristic_weight_ = weight;
+        }
+
         /**
          Useful when you're debugging a GOAP plan: simply dumps the open list to stdout.
         */
@@ -86,10 +140,47 @@ namespace goap {
          @param goal the goal worldstate
          @param actions the available action pool
          @return a vector of Actions in REVERSE ORDER - use a reverse_iterator on this to get stepwise-order
-         @exception std::runtime_error if no plan could be made with the available actions and states
+         @exception std::runtime_error if no complete plan could be made with the available actions and states (or within the budget)
          */
         std::vector<Action> plan(const WorldState& start, const WorldState& goal, const std::vector<Action>& actions);
 
+        /**
+         Same as above, but writes the plan into the caller's vector, so its storage can
+         be reused from one plan to the next, and reports a failure without throwing.
+         @param the_plan receives the Actions in REVERSE ORDER (empty if not found)
+         @return Found, Partial if the budget ran out, or NotFound
+         */
+        PlanStatus plan(const WorldState& start, const WorldState& goal, const std::vector<Action>& actions, std::vector<Action>& the_plan);
+
+        /**
+         Checks that a plan still leads from start to goal: the preconditions of each
+         step hold once the previous steps are applied, and the last one reaches the goal.
+         @param start the present worldstate
+         @param goal the goal worldstate
+         @param the_plan the Actions in REVERSE ORDER, as returned by plan()
+         @return true if the plan is still valid
+         */
+        static bool validate(const WorldState& start, const WorldState& goal, const std::vector<Action>& the_plan);
+
+        /**
+         Same as above, for the first 'steps' entries of the vector only: the tail of the
+         plan once its (the_plan.size() - steps) next Actions are skipped.
+         */
+        static bool validate(const WorldState& start, const WorldState& goal, const std::vector<Action>& the_plan, std::size_t steps);
+
+        /**
+         Repairs a plan which no longer validates: finds the first step (skipping at most
+         max_skipped steps) that a short sub-plan from start can make operable while the
+         rest of the chain still reaches the goal, and splices that sub-plan in front of it.
+         @param start the present worldstate
+         @param goal the goal worldstate
+         @param actions the available action pool
+         @param the_plan the plan to repair, in REVERSE ORDER; only modified on success
+         @param max_skipped the maximum number of leading steps that may be dropped
+         @return true if the plan was repaired, false if it has to be replanned
+         */
+        bool repair(const WorldState& start, const WorldState& goal, const std::vector<Action>& actions, std::vector<Action>& the_plan, int max_skipped = 2);
+
         TEST_FRIENDS;
     };
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+// ----------------------------------------------------------------------------
+//
+//
+//	Goal Oriented Action Planning - diagnostics
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <cstdio>
+
+namespace goap
+{
+	// receives one formatted diagnostic line of a planner
+	typedef void(*TraceSink)(const char* message);
+}
+
+// format into a stack buffer and forward to the sink (if any); compiled out in release
+#if defined NDEBUG
+#define GOAPTrace(sink, format, ... )
+#else
+#define GOAPTrace(sink, format, ... )   do { if (sink) { char goap_trace_buffer[256]; snprintf(goap_trace_buffer, sizeof(goap_trace_buffer), format, ##__VA_ARGS__); sink(goap_trace_buffer); } } while (0)
+#endif
@@ -1,13 +1,10 @@
 #include "Node.h"
 #include <iostream>
-int goap::Node::last_id_ = 0;
 
-goap::Node::Node() : g_(0), h_(0) {
-    id_ = ++last_id_;
+goap::Node::Node() : id_(-1), parent_id_(-1), g_(0), h_(0), action_(nullptr), closed_(false) {
 }
-goap::Node::Node(const WorldState state, int g, int h, int parent_id, const Action* action) :
-    ws_(state), g_(g), h_(h), parent_id_(parent_id), action_(action) {
-    id_ = ++last_id_;
+goap::Node::Node(const WorldState& state, int id, int g, int h, int parent_id, const Action* action) :
+    ws_(state), id_(id), parent_id_(parent_id), g_(g), h_(h), action_(action), closed_(false) {
 }
 
 bool goap::operator<(const goap::Node& lhs, const goap::Node& rhs) {
@@ -13,17 +13,16 @@
 
 namespace goap {
     struct Node {
-        static int last_id_; // a static that lets us assign incrementing, unique IDs to nodes
-
         WorldState ws_;      // The state of the world at this node.
-        int id_;             // the unique ID of this node
-        int parent_id_;      // the ID of this node's immediate predecessor
+        int id_;             // the ID of this node, unique within (and assigned by) its planner
+        int parent_id_;      // the ID of this node's immediate predecessor, -1 for the start node
         int g_;              // The A* cost from 'start' to 'here'
         int h_;              // The estimated remaining cost to 'goal' form 'here'
         const Action* action_;     // The action that got us here (for replay purposes)
+        bool closed_;        // true once the node has been expanded
 
         Node();
-        Node(const WorldState state, int g, int h, int parent_id, const Action* action);
+        Node(const WorldState& state, int id, int g, int h, int parent_id, const Action* action);
 
         // F -- which is simply G+H -- is autocalculated
         int f() const {
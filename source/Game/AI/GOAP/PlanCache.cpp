@@ -0,0 +1,80 @@
+#include "PlanCache.h"
+
+#include <functional>
+#include <iterator>
+
+std::size_t goap::PlanCache::KeyHash::operator()(const Key& key) const {
+    std::hash<StateBits> hasher;
+    std::size_t h = hasher(key.start_vars_);
+    h = h * 31 + hasher(key.start_care_);
+    h = h * 31 + hasher(key.goal_vars_);
+    h = h * 31 + hasher(key.goal_care_);
+    return h * 31 + key.actions_hash_;
+}
+
+goap::PlanCache::PlanCache(std::size_t capacity) : capacity_(capacity > 0 ? capacity : 1), hits_(0), misses_(0) {
+    index_.reserve(capacity_);
+}
+
+goap::PlanCache::Key goap::PlanCache::makeKey(const WorldState& start, const WorldState& goal, std::size_t actions_hash) {
+    Key key;
+    key.start_vars_ = start.vars_;
+    key.start_care_ = start.care_;
+    key.goal_vars_ = goal.vars_;
+    key.goal_care_ = goal.care_;
+    key.actions_hash_ = actions_hash;
+    return key;
+}
+
+const std::vector<goap::Action>* goap::PlanCache::find(const WorldState& start, const WorldState& goal,
+                                                       std::size_t actions_hash, bool& found) {
+    auto it = index_.find(makeKey(start, goal, actions_hash));
+    if (it == index_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+    ++hits_;
+    // move to the front: most recently used
+    entries_.splice(entries_.begin(), entries_, it->second);
+    found = it->second->found_;
+    return &it->second->plan_;
+}
+
+void goap::PlanCache::insert(const WorldState& start, const WorldState& goal, std::size_t actions_hash,
+                             bool found, const std::vector<Action>& plan) {
+    const Key key = makeKey(start, goal, actions_hash);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+    }
+    else {
+        if (entries_.size() >= capacity_) {
+            // recycle the least recently used entry (and its plan storage)
+            index_.erase(entries_.back().key_);
+            entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+        }
+        else {
+            entries_.emplace_front();
+        }
+        entries_.front().key_ = key;
+        index_.emplace(key, entries_.begin());
+    }
+    Entry& entry = entries_.front();
+    entry.found_ = found;
+    if (found) {
+        entry.plan_ = plan;
+    }
+    else {
+        entry.plan_.clear();
+    }
+}
+
+void goap::PlanCache::clear() {
+    index_.clear();
+    entries_.clear();
+}
+
+float goap::PlanCache::hitRate() const {
+    const std::size_t lookups = hits_ + misses_;
+    return lookups ? static_cast<float>(hits_) / lookups : 0.f;
+}
@@ -0,0 +1,100 @@
+/**
+ * @class PlanCache
+ * @brief Least-recently-used cache of plans, keyed by start state, goal and action pool.
+ *
+ * @date July 2014
+ * @copyright (c) 2014 Prylis Inc. All rights reserved.
+ */
+
+#pragma once
+
+#include "Action.h"
+#include "WorldState.h"
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// To support Google Test for private members
+#ifndef TEST_FRIENDS
+#define TEST_FRIENDS
+#endif
+
+namespace goap {
+    class PlanCache {
+    private:
+        struct Key {
+            StateBits start_vars_, start_care_;
+            StateBits goal_vars_, goal_care_;
+            std::size_t actions_hash_; // see hashActions(): changes with any action cost, precondition or effect
+
+            bool operator==(const Key& other) const {
+                return actions_hash_ == other.actions_hash_ &&
+                       start_vars_ == other.start_vars_ && start_care_ == other.start_care_ &&
+                       goal_vars_ == other.goal_vars_ && goal_care_ == other.goal_care_;
+            }
+        };
+
+        struct KeyHash {
+            std::size_t operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            Key key_;
+            bool found_;                    // false if the goal is unreachable from the start state
+            std::vector<Action> plan_;      // in reverse order, as returned by Planner::plan
+        };
+
+        std::size_t capacity_;
+        std::list<Entry> entries_;          // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+
+        std::size_t hits_;
+        std::size_t misses_;
+
+        static Key makeKey(const WorldState& start, const WorldState& goal, std::size_t actions_hash);
+
+    public:
+        /**
+         @param capacity the maximum number of plans kept
+         */
+        PlanCache(std::size_t capacity = 1024);
+
+        /**
+         Looks up the plan from start to goal with the given action pool, and marks it
+         as the most recently used.
+         @param start the starting worldstate
+         @param goal the goal worldstate
+         @param actions_hash the hash of the action pool (see hashActions)
+         @param found set to false if the cached result is "no path"
+         @return the cached plan (in reverse order), nullptr on a miss
+         */
+        const std::vector<Action>* find(const WorldState& start, const WorldState& goal,
+                                        std::size_t actions_hash, bool& found);
+
+        /**
+         Stores the result of a plan, evicting the least recently used one when full.
+         @param found false if the planner found no path
+         @param plan the plan (ignored if not found)
+         */
+        void insert(const WorldState& start, const WorldState& goal, std::size_t actions_hash,
+                    bool found, const std::vector<Action>& plan);
+
+        /**
+         Forgets every plan (the statistics are kept).
+         */
+        void clear();
+
+        std::size_t size() const { return entries_.size(); }
+        std::size_t hits() const { return hits_; }
+        std::size_t misses() const { return misses_; }
+
+        /**
+         @return the ratio of lookups that were hits, in [0, 1]
+         */
+        float hitRate() const;
+
+        TEST_FRIENDS;
+    };
+}
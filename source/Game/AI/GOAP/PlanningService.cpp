@@ -0,0 +1,245 @@
+// ----------------------------------------------------------------------------
+//
+//
+//	Goal Oriented Action Planning - batched planning service
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#include "PlanningService.h"
+#include "GoapInterface.h"
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+
+using namespace goap;
+
+// ----------------------------------------------------------------------------
+
+
+PlanningService::PlanningService(int worker_count)
+	: _next_job(0), _batch_jobs(0), _remaining_jobs(0), _busy_workers(0), _batch(0), _max_expansions(0), _max_milliseconds(0.f)
+{
+	if (worker_count <= 0)
+	{
+		worker_count = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+	for (int i = 0; i < worker_count; i++)
+	{
+		_workers.push_back(std::thread(&PlanningService::run, this));
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+PlanningService::~PlanningService()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop_thread = true;
+	}
+	_wake_workers.notify_all();
+	for (std::thread& worker : _workers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+
+int PlanningService::findPending(std::size_t key, const WorldState& start, const WorldState& goal, const std::vector<Action>& actions) const
+{
+	auto range = _pending_index.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const Job& job = _pending[it->second];
+		if (job.start == start && job.goal == goal && (job.actions == &actions || *job.actions == actions))
+			return it->second;
+	}
+	return -1;
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanningService::request(GOAPInterface* requester)
+{
+	const std::size_t actions_hash = hashActions(requester->all_actions);
+
+	// a plan already solved for the same inputs is delivered right away
+	bool found = false;
+	const std::vector<Action>* cached = _cache.find(requester->initial_state, requester->goal_win, actions_hash, found);
+	if (cached)
+	{
+		if (found) requester->updatePlan(*cached);
+		return;
+	}
+
+	const WorldStateHash state_hash;
+	const std::size_t key = (state_hash(requester->initial_state) * 31 + state_hash(requester->goal_win)) * 31 + actions_hash;
+
+	// identical requests share the same job
+	int index = findPending(key, requester->initial_state, requester->goal_win, requester->all_actions);
+	if (index == -1)
+	{
+		index = (int)_pending.size();
+		_pending.push_back(Job());
+		Job& job = _pending.back();
+		// the job only needs the state bits
+		job.start.vars_ = requester->initial_state.vars_;
+		job.start.care_ = requester->initial_state.care_;
+		job.goal.vars_ = requester->goal_win.vars_;
+		job.goal.care_ = requester->goal_win.care_;
+		job.actions = &requester->all_actions;
+		job.actions_hash = actions_hash;
+		job.status = PlanStatus::NotFound;
+		_pending_index.insert(std::make_pair(key, index));
+	}
+	_pending[index].requesters.push_back(requester);
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanningService::cancel(GOAPInterface* requester)
+{
+	// the workers may be reading the action pool of this requester
+	waitBatch();
+
+	for (std::vector<Job>* jobs : { &_pending, &_in_flight })
+	{
+		for (Job& job : *jobs)
+		{
+			job.requesters.erase(std::remove(job.requesters.begin(), job.requesters.end(), requester), job.requesters.end());
+			if (job.actions != &requester->all_actions) continue;
+			// borrow the (identical) action pool of another requester, or drop the job
+			job.actions = job.requesters.empty() ? nullptr : &job.requesters.front()->all_actions;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanningService::setBudget(int max_expansions, float max_milliseconds)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_max_expansions = max_expansions;
+	_max_milliseconds = max_milliseconds;
+}
+
+// ----------------------------------------------------------------------------
+
+
+void PlanningService::dispatch()
+{
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		// the previous batch must be solved (and collected) before it is replaced
+		_batch_done.wait(lock, [this] { return _remaining_jobs == 0 && _busy_workers == 0; });
+		_in_flight.swap(_pending);
+		_pending.clear();
+		_pending_index.clear();
+		_next_job = 0;
+		_batch_jobs = _in_flight.size();
+		_remaining_jobs = _batch_jobs;
+		++_batch;
+	}
+	_wake_workers.notify_all();
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanningService::collect()
+{
+	{
+		// a worker waking up late for this batch only reads _batch_jobs, never the jobs themselves
+		std::unique_lock<std::mutex> lock(_mutex);
+		_batch_done.wait(lock, [this] { return _remaining_jobs == 0 && _busy_workers == 0; });
+		_collected.swap(_in_flight);
+	}
+	for (Job& job : _collected)
+	{
+		if (!job.actions) continue;
+		// a partial plan only reflects the budget, the next request will search again
+		if (job.status != PlanStatus::Partial)
+			_cache.insert(job.start, job.goal, job.actions_hash, job.status == PlanStatus::Found, job.plan);
+		if (job.status == PlanStatus::NotFound) continue;
+		for (GOAPInterface* requester : job.requesters)
+		{
+			requester->updatePlan(job.plan);
+		}
+	}
+	_collected.clear();
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanningService::waitBatch()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_batch_done.wait(lock, [this] { return _remaining_jobs == 0 && _busy_workers == 0; });
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanningService::run()
+{
+	// each worker reuses its own planner (and its node storage)
+	Planner planner;
+	unsigned long seen_batch = 0;
+
+	while (true)
+	{
+		std::size_t job_count;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake_workers.wait(lock, [&] { return _stop_thread || _batch != seen_batch; });
+			if (_stop_thread) return;
+			seen_batch = _batch;
+			job_count = _batch_jobs;
+			planner.setBudget(_max_expansions, _max_milliseconds);
+			++_busy_workers;
+		}
+
+		std::size_t solved = 0;
+		for (std::size_t i = _next_job++; i < job_count; i = _next_job++)
+		{
+			Job& job = _in_flight[i];
+			if (job.actions)
+			{
+				job.status = planner.plan(job.start, job.goal, *job.actions, job.plan);
+			}
+			++solved;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_remaining_jobs -= solved;
+			--_busy_workers;
+			if (_remaining_jobs == 0 && _busy_workers == 0)
+				_batch_done.notify_all();
+		}
+	}
+}
@@ -0,0 +1,142 @@
+
+// ----------------------------------------------------------------------------
+//
+//
+//	Goal Oriented Action Planning - batched planning service
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "Action.h"
+#include "WorldState.h"
+#include "GoapPlanner.h"
+#include "PlanCache.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+#include <unordered_map>
+
+namespace goap
+{
+	struct GOAPInterface;
+
+	// Collects the plan requests of many GOAP interfaces during a tick, solves each
+	// distinct (start state, goal, action pool) once on a fixed pool of worker
+	// threads, and hands the plans back to the requesters at the next tick.
+	// Requests already solved during a previous tick are answered at once from an
+	// LRU plan cache (see PlanCache).
+	//
+	// All the public methods must be called from the same (game) thread:
+	//		collect();		// deliver the plans solved since the last tick
+	//		request(...);	// for each agent which needs a plan
+	//		dispatch();		// start solving the requests of this tick
+	class PlanningService
+	{
+	public:
+		// start the workers (0 means one per hardware thread, minus the calling one)
+		PlanningService(int worker_count = 0);
+		~PlanningService();
+		PlanningService(const PlanningService&) = delete;
+		PlanningService& operator=(const PlanningService&) = delete;
+
+		// queue a plan request for the current state, goal and actions of the requester
+		void request(GOAPInterface* requester);
+		// forget every pending or in-flight request of the requester (call before destroying it)
+		void cancel(GOAPInterface* requester);
+		// start solving the requests queued since the last dispatch
+		void dispatch();
+		// wait for the dispatched requests and deliver their plans to the requesters
+		void collect();
+		// bound the search of each request (see Planner::setBudget), applied from the next dispatch
+		void setBudget(int max_expansions, float max_milliseconds = 0.f);
+		// number of worker threads
+		int workerCount() const { return (int)_workers.size(); }
+		// plans solved during the previous ticks, reused for identical requests
+		PlanCache& cache() { return _cache; }
+
+	protected:
+		// a distinct plan request and its result
+		struct Job
+		{
+			WorldState start;
+			WorldState goal;
+			const std::vector<Action>* actions;
+			std::size_t actions_hash;
+			// agents waiting for this plan (only touched by the game thread)
+			std::vector<GOAPInterface*> requesters;
+			// result
+			std::vector<Action> plan;
+			PlanStatus status;
+		};
+
+		// worker thread method
+		void run();
+		// block until the in-flight batch is solved
+		void waitBatch();
+		// index of the pending job with the same inputs, -1 if none
+		int findPending(std::size_t key, const WorldState& start, const WorldState& goal, const std::vector<Action>& actions) const;
+
+	protected:
+		// requests queued during the current tick
+		std::vector<Job> _pending;
+		// pending job indices by hash of their inputs
+		std::unordered_multimap<std::size_t, int> _pending_index;
+		// solved plans (only touched by the game thread)
+		PlanCache _cache;
+		// requests being solved by the workers
+		std::vector<Job> _in_flight;
+		// solved jobs being delivered by collect (only touched by the game thread)
+		std::vector<Job> _collected;
+		// next in-flight job to solve
+		std::atomic<std::size_t> _next_job;
+		// number of jobs of the in-flight batch (set by dispatch)
+		std::size_t _batch_jobs;
+		// number of in-flight jobs not solved yet
+		std::size_t _remaining_jobs;
+		// number of workers currently taking jobs from the in-flight batch
+		int _busy_workers;
+		// incremented on each dispatch, wakes up the workers
+		unsigned long _batch;
+		// worker threads, each one with its own planner
+		std::vector<std::thread> _workers;
+		// protects _batch, _batch_jobs, _remaining_jobs, _busy_workers, _stop_thread, the budget and the swap of the batches
+		std::mutex _mutex;
+		// signaled on dispatch and on stop
+		std::condition_variable _wake_workers;
+		// signaled when the last in-flight job is solved
+		std::condition_variable _batch_done;
+		// if true, quit the workers
+		bool _stop_thread = false;
+		// search budget of the workers' planners
+		int _max_expansions;
+		float _max_milliseconds;
+	};
+
+}
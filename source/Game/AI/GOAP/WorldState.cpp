@@ -1,45 +1,21 @@
 #include "WorldState.h"
 
+#include <cassert>
+#include <stdexcept>
+
 goap::WorldState::WorldState(const std::string name) : priority_(0), name_(name) {
     //nop
 }
 
 void goap::WorldState::setVariable(const int var_id, const bool value) {
-    vars_[var_id] = value;
+    assert(var_id >= 0 && var_id < GOAP_MAX_VARS);
+    care_.set(var_id);
+    vars_.set(var_id, value);
 }
 
 bool goap::WorldState::getVariable(const int var_id) const {
-    return vars_.at(var_id);
-}
-
-
-bool goap::WorldState::operator==(const WorldState& other) const {
-    return (vars_ == other.vars_);
-}
-
-bool goap::WorldState::meetsGoal(const WorldState& goal_state) const {
-    for (const auto& kv : goal_state.vars_) {
-        try {
-            if (vars_.at(kv.first) != kv.second) {
-                return false;
-            }
-        }
-        catch (const std::out_of_range&) {
-            return false;
-        }
+    if (!care_.test(var_id)) {
+        throw std::out_of_range("WorldState::getVariable : variable is not set");
     }
-    return true;
+    return vars_.test(var_id);
 }
-
-int goap::WorldState::distanceTo(const WorldState& goal_state) const {
-    int result = 0;
-
-    for (const auto& kv : goal_state.vars_) {
-        auto itr = vars_.find(kv.first);
-        if (itr == end(vars_) || itr->second != kv.second) {
-            ++result;
-        }
-    }
-
-    return result;
-}
\ No newline at end of file
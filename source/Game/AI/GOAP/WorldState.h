@@ -8,21 +8,31 @@
 
 #pragma once
 
+#include <bitset>
+#include <cstddef>
+#include <functional>
 #include <ostream>
 #include <string>
-#include <map>
+
+// Number of distinct state variables a worldstate can describe (ids 0..GOAP_MAX_VARS-1)
+#ifndef GOAP_MAX_VARS
+#define GOAP_MAX_VARS 128
+#endif
 
 namespace goap {
+    typedef std::bitset<GOAP_MAX_VARS> StateBits;
+
     struct WorldState {
         float priority_; // useful if this is a goal state, to distinguish from other possible goals
         std::string name_; // the human-readable name of the state
-        std::map<int, bool> vars_; // the variables that in aggregate describe a worldstate
+        StateBits vars_; // the values of the variables that in aggregate describe a worldstate
+        StateBits care_; // which variables are actually set (the "care" mask); bits of vars_ outside it are always 0
 
         WorldState(const std::string name="");
 
         /**
          Set a world state variable, e.g. "gunLoaded" / true
-         @param var_id the unique ID of the state variable
+         @param var_id the unique ID of the state variable, in [0, GOAP_MAX_VARS)
          @param value the boolean value of the variable
          */
         void setVariable(const int var_id, const bool value);
@@ -31,9 +41,17 @@ namespace goap {
          Retrieve the current value of the given variable.
          @param var_id the unique ID of the state variable
          @return the value of the variable
+         @exception std::out_of_range if the variable was never set
         */
         bool getVariable(const int var_id) const;
 
+        /**
+         Is the given variable set in this worldstate?
+         @param var_id the unique ID of the state variable
+         @return true if the variable has a value
+        */
+        bool hasVariable(const int var_id) const { return care_.test(var_id); }
+
         /**
          Useful if this state is a goal state. It asks, does state 'other'
          meet the requirements of this goal? Takes into account not only this goal's
@@ -41,7 +59,9 @@ namespace goap {
          @param other the state you are testing as having met this goal state
          @return true if it meets this goal state, false otherwise
          */
-        bool meetsGoal(const WorldState& goal_state) const;
+        bool meetsGoal(const WorldState& goal_state) const {
+            return (goal_state.care_ & ~care_).none() && ((vars_ ^ goal_state.vars_) & goal_state.care_).none();
+        }
 
         /**
          Given the other state -- and what 'matters' to the other state -- how many
@@ -49,14 +69,18 @@ namespace goap {
          @param other the goal state to compare against
          @return the number of state-var differences between us and them
          */
-        int distanceTo(const WorldState& goal_state) const;
+        int distanceTo(const WorldState& goal_state) const {
+            return static_cast<int>((((vars_ ^ goal_state.vars_) | ~care_) & goal_state.care_).count());
+        }
 
         /**
          Equality operator
          @param other the other worldstate to compare to
          @return true if they are equal, false if not
          */
-        bool operator==(const WorldState& other) const;
+        bool operator==(const WorldState& other) const {
+            return vars_ == other.vars_ && care_ == other.care_;
+        }
 
         // A friend function of a class is defined outside that class' scope but it has the
         // right to access all private and protected members of the class. Even though the
@@ -65,13 +89,23 @@ namespace goap {
         friend std::ostream& operator<<(std::ostream& out, const WorldState& n);
     };
 
+    // Hashes a worldstate on its state bits, so it can key unordered containers
+    struct WorldStateHash {
+        std::size_t operator()(const WorldState& ws) const {
+            std::hash<StateBits> hasher;
+            return hasher(ws.vars_) * 31 + hasher(ws.care_);
+        }
+    };
+
     inline std::ostream& operator<<(std::ostream& out, const WorldState& n) {
         out << "WorldState { ";
-        for (const auto& kv : n.vars_) {
-            out << kv.second << " ";
+        for (std::size_t i = 0; i < n.care_.size(); ++i) {
+            if (n.care_.test(i)) {
+                out << n.vars_.test(i) << " ";
+            }
         }
         out << "}";
         return out;
     }
 
-}
\ No newline at end of file
+}
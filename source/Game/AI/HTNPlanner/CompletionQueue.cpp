@@ -0,0 +1,133 @@
+ 
+// ----------------------------------------------------------------------------
+//
+//
+//	Hierarchical Task Networks - HTN Implementation in C++
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+#include "CompletionQueue.h"
+
+// ----------------------------------------------------------------------------
+
+using namespace HTN;
+
+// ----------------------------------------------------------------------------
+// OperationHandle
+// ----------------------------------------------------------------------------
+
+void OperationHandle::complete(bool success)
+{
+	int flags = _flags.load(std::memory_order_relaxed);
+	do
+	{
+		if (flags & COMPLETED) return;
+	} while (!_flags.compare_exchange_weak(flags, flags | COMPLETED | (success ? SUCCEEDED : 0), std::memory_order_acq_rel));
+	if (flags & ATTACHED)
+	{
+		send();
+	}
+}
+
+void OperationHandle::attach(const std::shared_ptr<CompletionQueue>& queue)
+{
+	// published by the flags
+	_queue = queue;
+	int flags = _flags.fetch_or(ATTACHED, std::memory_order_acq_rel);
+	if (flags & COMPLETED)
+	{
+		send();
+	}
+}
+
+void OperationHandle::send()
+{
+	std::shared_ptr<CompletionQueue> queue = _queue.lock();
+	// the runner is gone
+	if (!queue) return;
+	_self = shared_from_this();
+	queue->push(this);
+}
+
+// ----------------------------------------------------------------------------
+// CompletionQueue
+// ----------------------------------------------------------------------------
+
+CompletionQueue::CompletionQueue()
+	: _head(&_stub), _tail(&_stub)
+{
+
+}
+
+CompletionQueue::~CompletionQueue()
+{
+	// release the handles not popped
+	while (pop());
+}
+
+// ----------------------------------------------------------------------------
+
+void CompletionQueue::insert(OperationHandle* handle)
+{
+	handle->_next.store(nullptr, std::memory_order_relaxed);
+	OperationHandle* previous = _head.exchange(handle, std::memory_order_acq_rel);
+	// until this store, the consumer sees the queue as ending before handle
+	previous->_next.store(handle, std::memory_order_release);
+}
+
+void CompletionQueue::push(OperationHandle* handle)
+{
+	insert(handle);
+	if (Wakeup)
+	{
+		Wakeup();
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+OperationHandlePtr CompletionQueue::pop()
+{
+	OperationHandle* tail = _tail;
+	OperationHandle* next = tail->_next.load(std::memory_order_acquire);
+	if (tail == &_stub)
+	{
+		if (!next) return nullptr;
+		_tail = next;
+		tail = next;
+		next = next->_next.load(std::memory_order_acquire);
+	}
+	if (!next)
+	{
+		// a push is linking its handle : it wakes the runner again once done
+		if (tail != _head.load(std::memory_order_acquire)) return nullptr;
+		// tail is the last handle : the stub takes its place so that it can be removed
+		insert(&_stub);
+		next = tail->_next.load(std::memory_order_acquire);
+		if (!next) return nullptr;
+	}
+	_tail = next;
+	return std::move(tail->_self);
+}
@@ -0,0 +1,116 @@
+ 
+// ----------------------------------------------------------------------------
+//
+//
+//	Hierarchical Task Networks - HTN Implementation in C++
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <functional>
+
+namespace HTN
+{
+
+	class CompletionQueue;
+
+	// an asynchronous operation started by an operator (see AsyncAction). The operation calls
+	// complete once, from any thread : the Runner receives it through its CompletionQueue
+	class OperationHandle : public std::enable_shared_from_this<OperationHandle>
+	{
+	public:
+		OperationHandle() : _next(nullptr), _flags(0) {}
+		// create the handle of a new operation
+		static std::shared_ptr<OperationHandle> create() { return std::make_shared<OperationHandle>(); }
+		// end the operation, only the first call counts
+		void complete(bool success);
+		// true once complete is called
+		bool isCompleted() const { return (_flags.load(std::memory_order_acquire) & COMPLETED) != 0; }
+		// result given to complete
+		bool succeeded() const { return (_flags.load(std::memory_order_acquire) & SUCCEEDED) != 0; }
+		// send the completion to a queue, at once if the operation is already completed (called by the Runner)
+		void attach(const std::shared_ptr<CompletionQueue>& queue);
+
+	protected:
+		friend class CompletionQueue;
+
+		enum
+		{
+			ATTACHED = 1,
+			COMPLETED = 2,
+			SUCCEEDED = 4
+		};
+
+		// push the handle in its queue, if the queue still exists
+		void send();
+
+	protected:
+		// next handle in the queue
+		std::atomic<OperationHandle*> _next;
+		// ATTACHED, COMPLETED and SUCCEEDED : the handle is sent by whichever of attach and complete comes last
+		std::atomic<int> _flags;
+		// queue of the runner, set by attach
+		std::weak_ptr<CompletionQueue> _queue;
+		// keeps the handle alive while it is queued
+		std::shared_ptr<OperationHandle> _self;
+	};
+
+	typedef std::shared_ptr<OperationHandle> OperationHandlePtr;
+
+
+	// completed operations, in completion order. Any thread pushes without locking, only the
+	// thread of the runner pops (intrusive multiple producers, single consumer queue)
+	class CompletionQueue
+	{
+	public:
+		CompletionQueue();
+		~CompletionQueue();
+		// add a completed operation, then call Wakeup
+		void push(OperationHandle* handle);
+		// remove the oldest completed operation, nullptr if there is none yet
+		OperationHandlePtr pop();
+
+		// called after each push, from the thread which completes the operation (set before the first operation)
+		std::function<void()> Wakeup;
+
+	protected:
+		// link a handle after the last one
+		void insert(OperationHandle* handle);
+
+	protected:
+		// last handle pushed
+		std::atomic<OperationHandle*> _head;
+		// next handle to pop
+		OperationHandle* _tail;
+		// placeholder queued when the last handle is popped : the queue is never empty
+		OperationHandle _stub;
+	};
+
+}
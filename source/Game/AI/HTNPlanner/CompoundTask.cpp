@@ -51,12 +51,15 @@ void CompoundTask::free()
 	}
 	 
 	Methods.clear();
+	SortedMethods.clear();
+	Memo.clear();
+	MemoHits = MemoMisses = 0;
 }
 
 // ----------------------------------------------------------------------------
 
 CompoundTask::CompoundTask(Domain* d,const std::string& name,   float cost ,std::initializer_list<std::string> args)
-	: BaseTask(d, name,args,cost)
+	: BaseTask(d, name,args,cost, TASK_COMPOUND), Memoizable(false), MemoHits(0), MemoMisses(0)
 {
 
 }
@@ -76,21 +79,14 @@ Method& CompoundTask::AddMethod(const std::string& name,float cost)
 
 Method* CompoundTask::FindSatisfiedMethod(EvalStack& evalTask, WStates& states)
 {
-	// sort by cost	 
-	std::sort(Methods.begin(), Methods.end(),
-		[](const Method & a, const Method & b) -> bool
+	// by decreasing cost, the order used by the planner
+	for (auto it = SortedMethods.rbegin(); it != SortedMethods.rend(); ++it)
 	{
-		return a.Cost > b.Cost;
-	});
-	 
-
-	// test method pre-conditions
-	for (Method& method : Methods)
-	{
-		HTNTrace(domain->Name, "Trying method named : '%s'", method.Name.c_str());
-		bool satisfied = method.isSatisfied(evalTask,states);
+		Method* method = *it;
+		HTNTrace(domain->Name, "Trying method named : '%s'", method->Name.c_str());
+		bool satisfied = method->isSatisfied(evalTask,states);
 		if (satisfied)
-			return &method;
+			return method;
 	}
 	return nullptr;
 }
@@ -34,6 +34,7 @@
 
 #include "PrimitiveTask.h"
 #include "Method.h"
+#include <unordered_map>
 
 namespace HTN
 {
@@ -65,6 +66,24 @@ namespace HTN
 		// Needed to determine which approach to accomplish a compound task.
 		// Methods are comprised of a set of conditions and tasks
 		std::vector<Method> Methods;
+		// methods by increasing cost (set by Domain::sort, do not add methods after)
+		std::vector<Method*> SortedMethods;
+
+		// methods which may be satisfied, in SortedMethods order, for some values of the states in ReadStates
+		struct MethodMemo
+		{
+			std::vector<StateData> Values;
+			std::vector<bool> Satisfied;
+		};
+		// states read by the preconditions of the methods (set by Domain::compile)
+		std::vector<int> ReadStates;
+		// true if the preconditions of the methods only read states and constants
+		bool Memoizable;
+		// satisfied methods by hash of the values of ReadStates (cleared by Domain::sort)
+		std::unordered_map<size_t, MethodMemo> Memo;
+		// memo lookups found / not found, memoization stops when it is seldom reused
+		size_t MemoHits;
+		size_t MemoMisses;
 		
 		 
 
@@ -30,6 +30,9 @@
 
 
 #include "Domain.h"
+#include <deque>
+#include <typeinfo>
+#include <mutex>
 
 // ----------------------------------------------------------------------------
 
@@ -42,6 +45,9 @@ using namespace HTN;
 void Domain::free()
 {
 	WorldStates.free();
+	TasksById.clear();
+	_compiled = false;
+	_sorted = false;
 	for (BaseTask* task : Tasks)
 	{
 		task->free();
@@ -73,13 +79,328 @@ CompoundTask& Domain::AddCompoundTask(const std::string& name, std::initializer_
 
 // ----------------------------------------------------------------------------
 
-BaseState* Domain::WorldState(const std::string& group, const std::string& state)
+Variant Domain::WorldState(const std::string& group, const std::string& state)
 {
-	return WorldStates.wState(group, state);
+	return WorldStates.wStateAsVariant(group, state);
 }
 
 // ----------------------------------------------------------------------------
 
+namespace
+{
+	// interned string values, and their identifiers (see Domain::intern)
+	struct SymbolTable
+	{
+		std::deque<std::string> Symbols;
+		std::map<std::string, long> Ids;
+		std::mutex Lock;
+	};
+
+	SymbolTable& symbolTable()
+	{
+		static SymbolTable table;
+		return table;
+	}
+}
+
+long Domain::intern(const std::string& symbol)
+{
+	SymbolTable& table = symbolTable();
+	std::lock_guard<std::mutex> lock(table.Lock);
+	auto it = table.Ids.find(symbol);
+	if (it != table.Ids.end()) return it->second;
+	long id = (long)table.Symbols.size();
+	table.Symbols.push_back(symbol);
+	table.Ids[symbol] = id;
+	return id;
+}
+
+const std::string& Domain::symbol(long id)
+{
+	SymbolTable& table = symbolTable();
+	std::lock_guard<std::mutex> lock(table.Lock);
+	return table.Symbols[id];
+}
+
+int Domain::variableSlot(const std::string& variable)
+{
+	std::lock_guard<std::mutex> lock(_variableLock);
+	auto it = _variableSlots.find(variable);
+	if (it != _variableSlots.end()) return it->second;
+	int slot = (int)_variableSlots.size();
+	_variableSlots[variable] = slot;
+	return slot;
+}
+
+// ----------------------------------------------------------------------------
+
+
+int Domain::stateId(const std::string& group, const std::string& state) const
+{
+	auto git = GroupIds.find(group);
+	if (git == GroupIds.end()) return -1;
+	const std::map<std::string, int>& states = StateIds[git->second];
+	auto sit = states.find(state);
+	return sit != states.end() ? sit->second : -1;
+}
+
+// ----------------------------------------------------------------------------
+
+void Domain::resolve(DefState& state)
+{
+	auto git = GroupIds.find(state.Group);
+	state.Id = stateId(state.Group, state.State);
+	if (state.Id < 0)
+	{
+		throw std::domain_error("Domain::compile : state does not exist : " + state.Group + "." + state.State);
+	}
+	state.GroupId = git->second;
+}
+
+void Domain::resolve(BaseValue* value)
+{
+	StateValue* sv = dynamic_cast<StateValue*>(value);
+	if (sv)
+	{
+		resolve(sv->state);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+void Domain::compile()
+{
+	if (_compiled) return;
+
+	// states: one identifier per (group, state), in declaration map order
+	GroupIds.clear();
+	StateIds.clear();
+	StatesById.clear();
+	for (auto& group : WorldStates.CurrentWorldState)
+	{
+		int groupId = (int)StateIds.size();
+		GroupIds[group.first] = groupId;
+		StateIds.push_back(std::map<std::string, int>());
+		for (auto& state : group.second.States)
+		{
+			DefState ds(group.first, state.first);
+			ds.GroupId = groupId;
+			ds.Id = (int)StatesById.size();
+			StateIds.back()[state.first] = ds.Id;
+			StatesById.push_back(ds);
+		}
+	}
+
+	// tasks: identifier is the declaration order
+	TasksById = Tasks;
+	for (size_t id = 0; id < TasksById.size(); id++)
+	{
+		TasksById[id]->Id = (int)id;
+	}
+
+	// rewrite preconditions, effects and subtasks
+	bool cacheable = true;
+	for (BaseTask* task : TasksById)
+	{
+		if (task->Kind == TASK_PRIMITIVE)
+		{
+			PrimitiveTask* primitive = static_cast<PrimitiveTask*>(task);
+			for (Precondition& pre : primitive->Preconditions)
+			{
+				resolve(pre.Condition);
+				resolve(pre.Value);
+				cacheable = cacheable && !isFunction(pre.Value);
+			}
+			for (Effect& effect : primitive->Effects)
+			{
+				resolve(effect.State);
+				resolve(effect.Value);
+				cacheable = cacheable && !isFunction(effect.Value);
+			}
+			continue;
+		}
+		if (task->Kind != TASK_COMPOUND) continue;
+		CompoundTask* compound = static_cast<CompoundTask*>(task);
+		compound->ReadStates.clear();
+		compound->Memoizable = true;
+		for (Method& method : compound->Methods)
+		{
+			for (Precondition& pre : method.Preconditions)
+			{
+				resolve(pre.Condition);
+				resolve(pre.Value);
+				cacheable = cacheable && !isFunction(pre.Value);
+				compound->Memoizable = compound->Memoizable && !isFunction(pre.Value) && !isVariable(pre.Value);
+				compound->ReadStates.push_back(pre.Condition.Id);
+				const StateValue* sv = dynamic_cast<const StateValue*>(pre.Value);
+				if (sv) compound->ReadStates.push_back(sv->state.Id);
+			}
+			for (TaskRef& ref : method.Tasks)
+			{
+				BaseTask* subtask = findTask(ref.Name);
+				if (!subtask)
+				{
+					throw std::domain_error("Domain::compile : subtask does not exist in the domain : " + ref.Name);
+				}
+				ref.TaskId = subtask->Id;
+			}
+		}
+	}
+
+	// states read by the methods of each compound task, once
+	for (BaseTask* task : TasksById)
+	{
+		if (task->Kind != TASK_COMPOUND) continue;
+		std::vector<int>& ids = static_cast<CompoundTask*>(task)->ReadStates;
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+	}
+	Cacheable = cacheable;
+
+	WorldStates.compile(StatesById);
+
+	// preconditions and effects, now that the type of each state is known
+	for (BaseTask* task : TasksById)
+	{
+		if (task->Kind == TASK_PRIMITIVE)
+		{
+			PrimitiveTask* primitive = static_cast<PrimitiveTask*>(task);
+			for (Precondition& pre : primitive->Preconditions)
+			{
+				pre.Code = WorldStates.compile(pre.Condition, pre.Fct, pre.Value);
+			}
+			for (Effect& effect : primitive->Effects)
+			{
+				effect.Code = WorldStates.compile(effect.State, effect.Fct, effect.Value);
+			}
+			continue;
+		}
+		if (task->Kind != TASK_COMPOUND) continue;
+		for (Method& method : static_cast<CompoundTask*>(task)->Methods)
+		{
+			for (Precondition& pre : method.Preconditions)
+			{
+				pre.Code = WorldStates.compile(pre.Condition, pre.Fct, pre.Value);
+			}
+		}
+	}
+	sort();
+	_compiled = true;
+}
+
+// ----------------------------------------------------------------------------
+
+void Domain::sort()
+{
+	// stable : tasks of same cost keep their declaration order, which is the tie-break of findPlan when several
+	// compound tasks could be the root. The former std::sort on each findPlan left them in an unspecified order (with
+	// libstdc++, the declaration order up to 16 tasks only), so a domain with more ties may get a different plan.
+	std::stable_sort(Tasks.begin(), Tasks.end(),
+		[](const BaseTask* a, const BaseTask*  b) -> bool
+	{
+		return a->Cost < b->Cost;
+	});
+	for (BaseTask* task : Tasks)
+	{
+		if (task->Kind != TASK_COMPOUND) continue;
+		CompoundTask* compound = static_cast<CompoundTask*>(task);
+		compound->SortedMethods.clear();
+		for (Method& method : compound->Methods)
+		{
+			compound->SortedMethods.push_back(&method);
+		}
+		std::stable_sort(compound->SortedMethods.begin(), compound->SortedMethods.end(),
+			[](const Method* a, const Method* b) -> bool
+		{
+			return a->Cost < b->Cost;
+		});
+		// memoized results follow the order of the methods
+		compound->Memo.clear();
+		compound->MemoHits = compound->MemoMisses = 0;
+	}
+	updateVersion();
+	_sorted = true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool Domain::isFunction(const BaseValue* value)
+{
+	return dynamic_cast<const FctBoolValue*>(value) || dynamic_cast<const FctLongValue*>(value)
+		|| dynamic_cast<const FctFloatValue*>(value) || dynamic_cast<const FctStringValue*>(value)
+		|| dynamic_cast<const FctPointValue*>(value) || dynamic_cast<const FctVariantValue*>(value);
+}
+
+bool Domain::isVariable(const BaseValue* value)
+{
+	return dynamic_cast<const BooleanVar*>(value) || dynamic_cast<const LongVar*>(value)
+		|| dynamic_cast<const FloatVar*>(value) || dynamic_cast<const StringVar*>(value)
+		|| dynamic_cast<const PointVar*>(value) || dynamic_cast<const VariantVar*>(value);
+}
+
+size_t Domain::hashValue(size_t seed, const BaseValue* value)
+{
+	size_t h = hashString(seed, typeid(*value).name());
+	if (const StateValue* v = dynamic_cast<const StateValue*>(value)) return HTN::hashValue(h, v->state.Id);
+	if (const FloatValue* v = dynamic_cast<const FloatValue*>(value)) return HTN::hashValue(h, v->Value);
+	if (const PointValue* v = dynamic_cast<const PointValue*>(value)) return HTN::hashValue(HTN::hashValue(HTN::hashValue(h, v->Value.X), v->Value.Y), v->Value.Z);
+	if (const VariantValue* v = dynamic_cast<const VariantValue*>(value)) return v->Value.hash(h);
+	// functions can not be compared (see Cacheable)
+	if (isFunction(value)) return HTN::hashValue(h, value);
+	// other constants and variables
+	return hashString(h, value->toString());
+}
+
+void Domain::updateVersion()
+{
+	size_t h = HTN::hashValue(0, StatesById.size());
+	for (const DefState& ds : StatesById)
+	{
+		h = hashString(hashString(h, ds.Group), ds.State);
+	}
+	for (BaseTask* task : TasksById)
+	{
+		h = HTN::hashValue(HTN::hashValue(hashString(h, task->Name), (int)task->Kind), task->Cost);
+		if (task->Kind == TASK_PRIMITIVE)
+		{
+			PrimitiveTask* primitive = static_cast<PrimitiveTask*>(task);
+			for (Precondition& pre : primitive->Preconditions)
+			{
+				h = hashValue(HTN::hashValue(HTN::hashValue(h, pre.Condition.Id), (int)pre.Fct), pre.Value);
+			}
+			for (Effect& effect : primitive->Effects)
+			{
+				h = hashValue(HTN::hashValue(HTN::hashValue(h, effect.State.Id), (int)effect.Fct), effect.Value);
+			}
+			continue;
+		}
+		if (task->Kind != TASK_COMPOUND) continue;
+		for (Method* method : static_cast<CompoundTask*>(task)->SortedMethods)
+		{
+			h = HTN::hashValue(hashString(h, method->Name), method->Cost);
+			for (Precondition& pre : method->Preconditions)
+			{
+				h = hashValue(HTN::hashValue(HTN::hashValue(h, pre.Condition.Id), (int)pre.Fct), pre.Value);
+			}
+			for (TaskRef& ref : method->Tasks)
+			{
+				h = HTN::hashValue(h, ref.TaskId);
+			}
+		}
+	}
+	Version = h;
+}
+
+// ----------------------------------------------------------------------------
+
+void Domain::setCost(BaseTask* task, float cost)
+{
+	if (task->Cost == cost) return;
+	task->Cost = cost;
+	_sorted = false;
+}
+
+// ----------------------------------------------------------------------------
 
 BaseTask* Domain::findTask(const std::string& name)
 {
@@ -35,6 +35,9 @@
 #include "PrimitiveTask.h"
 #include "CompoundTask.h"
 #include "EvalStack.h"
+#include "HTNPlanCache.h"
+#include <map>
+#include <mutex>
 
 namespace HTN
 {
@@ -43,16 +46,38 @@ namespace HTN
 	// HTN Domain 
 	struct Domain
 	{
-		Domain()  : EvalTask(*this), WorldStates(*this){}
+		Domain()  : EvalTask(*this), WorldStates(*this), Version(0), Cacheable(false), Cache(nullptr), _compiled(false), _sorted(false){}
 		void free();
 		// add compound task
 		CompoundTask& AddCompoundTask(const std::string& name, std::initializer_list<std::string> args = {},float cost=0);
 		// add primitive task to the domain
 		PrimitiveTask& AddPrimitiveTask(const std::string& name, std::initializer_list<std::string> args = {});
-		// Gets a state for a given group
-		BaseState* WorldState(const std::string& group, const std::string& state);
+		// Gets the value of a state for a given group
+		Variant WorldState(const std::string& group, const std::string& state);
 		// search a task by its name
 		BaseTask* findTask(const std::string& name);
+		// gets a task from its interned identifier
+		BaseTask* findTask(int id) { return TasksById[id]; }
+		// intern every group, state and task name to dense identifiers, and resolve
+		// the preconditions, effects and method subtasks to them (once, before planning)
+		void compile();
+		// true once compile is done
+		bool isCompiled() const { return _compiled; }
+		// sort the tasks and the methods of compound tasks by increasing cost, ties in declaration order (done by compile)
+		void sort();
+		// true if the tasks and methods are sorted
+		bool isSorted() const { return _sorted; }
+		// change the cost of a task or a method, they are sorted again before the next plan
+		void setCost(BaseTask* task, float cost);
+		// identifier of a state, -1 if it does not exist
+		int stateId(const std::string& group, const std::string& state) const;
+		// identifier of a string value held by the world states (added if not known yet).
+		// The table is shared by all the domains, so that equal strings have equal identifiers
+		static long intern(const std::string& symbol);
+		// string value of an identifier returned by intern
+		static const std::string& symbol(long id);
+		// slot of a variable in the evaluation stacks of this domain (added if not known yet)
+		int variableSlot(const std::string& variable);
 		// print the domain
 		void dump();
 
@@ -60,10 +85,44 @@ namespace HTN
 		EvalStack EvalTask;
 		// World states
 		WorldStateProperties WorldStates;
-		// tasks
+		// tasks, by increasing cost once sorted
 		std::vector<BaseTask*> Tasks;
+		// tasks indexed by their identifier (declaration order)
+		std::vector<BaseTask*> TasksById;
+		// states indexed by their identifier
+		std::vector<DefState> StatesById;
+		// group identifiers by name
+		std::map<std::string, int> GroupIds;
+		// state identifiers by name, for each group identifier
+		std::vector<std::map<std::string, int>> StateIds;
 		// name of this domain
 		std::string Name;
+		// hash of the states, tasks, methods and costs : domains with the same version give the same plans
+		size_t Version;
+		// true if no precondition or effect uses a function value, so that plans can be cached
+		bool Cacheable;
+		// plans already found for this version of the domain (none by default)
+		PlanCache* Cache;
+	protected:
+		// resolve a state definition, throw if it does not exist
+		void resolve(DefState& state);
+		// resolve a state used as a value, if any
+		void resolve(BaseValue* value);
+		// hash of a value used in a precondition or an effect
+		static size_t hashValue(size_t seed, const BaseValue* value);
+		// true if the value is a function
+		static bool isFunction(const BaseValue* value);
+		// true if the value is a variable
+		static bool isVariable(const BaseValue* value);
+		// compute Version
+		void updateVersion();
+		// set by compile
+		bool _compiled;
+		// set by sort, reset by setCost
+		bool _sorted;
+		// see variableSlot
+		std::map<std::string, int> _variableSlots;
+		std::mutex _variableLock;
 	};
 
 }
@@ -30,6 +30,7 @@
 
 #include "Effect.h"
 #include "HTNTrace.h"
+#include <cstring>
 
 // ----------------------------------------------------------------------------
 
@@ -41,6 +42,7 @@ using namespace HTN;
 Effect::Effect(const DefState& state, FCT fct, BaseValue* value)
 	: State(state), Fct(fct), Value(value)
 {
+	memset(&Code, 0, sizeof(Code));
 
 }
 
@@ -55,10 +57,12 @@ Effect::~Effect()
 
 // ----------------------------------------------------------------------------
 
-void Effect::apply(EvalStack&, WStates& state)
+void Effect::apply(EvalStack& evalTask, WStates& state)
 {
-
-	state.wSetState(State.Group, State.State, Fct, *Value);
+	if (Code.Op == OP_GENERIC || !state.wSetState(evalTask, Code))
+	{
+		state.wSetState(State, Fct, *Value);
+	}
  
 }
 
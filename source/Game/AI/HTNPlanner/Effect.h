@@ -57,6 +57,8 @@ namespace HTN
 		FCT Fct;
 		// operand
 		BaseValue* Value;
+		// compiled by Domain::compile
+		Instruction Code;
 
 	};
 
@@ -30,6 +30,8 @@
 // ----------------------------------------------------------------------------
 
 #include "EvalStack.h"
+#include "Domain.h"
+#include <cstring>
 // ----------------------------------------------------------------------------
 
 using namespace HTN;
@@ -40,33 +42,63 @@ using namespace HTN;
 void EvalStack::push(const std::string& variable, long value)
 {
 	_stack.push_front(Variant(variable, value));
+	pushSlot(_stack.front());
 }
 
 
 void EvalStack::push(const std::string& variable, float value)
 {
 	_stack.push_front(Variant(variable, value));
+	pushSlot(_stack.front());
 }
 
 
 void EvalStack::push(const std::string& variable, const std::string& value)
 {
 	_stack.push_front(Variant(variable, value));
+	pushSlot(_stack.front());
 }
 
 
 void EvalStack::push(const std::string& variable, const Point& value)
 {
 	_stack.push_front(Variant(variable, value));
+	pushSlot(_stack.front());
 }
 
 Variant EvalStack::pop()
 {
 	Variant v = _stack.front();
 	_stack.pop_front();
+	const StateUndo& u = _shadowed.back();
+	_slots[u.Id] = u.Value;
+	_shadowed.pop_back();
 	return v;
 }
 
+void EvalStack::pushSlot(const Variant& variant)
+{
+	int slot = _domain.variableSlot(variant.variable);
+	if (slot >= (int)_slots.size())
+	{
+		StateData empty;
+		memset(&empty, 0, sizeof(empty));
+		_slots.resize(slot + 1, empty);
+	}
+	_shadowed.push_back({ slot, _slots[slot] });
+	_slots[slot] = _domain.WorldStates.toData(variant);
+}
+
+size_t EvalStack::hash() const
+{
+	size_t h = hashValue(0, _stack.size());
+	for (const Variant& variant : _stack)
+	{
+		h = variant.hash(h);
+	}
+	return h;
+}
+
 Variant EvalStack::varAsVariant(const std::string& variable)
 {
 	for (const Variant& variant : _stack)
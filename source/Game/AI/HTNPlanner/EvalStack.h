@@ -34,6 +34,7 @@
 #include <string>
 #include <deque>
 #include "Variant.h"
+#include "WorldStateProperties.h"
 
 namespace HTN
 {
@@ -60,9 +61,20 @@ namespace HTN
 		bool varAsString(const std::string& variable, std::string& value);
 		bool varAsPoint(const std::string& variable, Point& value);
 		bool varAsVariant(const std::string& variable, Variant& value);
+		// hash of all the variables and their values
+		size_t hash() const;
+		// value of a variable from its slot (see Domain::variableSlot), nullptr if it was never pushed
+		const StateData* slot(int slot) const { return slot < (int)_slots.size() ? &_slots[slot] : nullptr; }
 
 	private:
+		// keep the slot of a pushed variable up to date
+		void pushSlot(const Variant& variant);
+
 		std::deque< Variant> _stack;
+		// most recent value of each variable, by slot
+		std::vector<StateData> _slots;
+		// previous value of the slot of each pushed variable, restored by pop
+		std::vector<StateUndo> _shadowed;
 		Domain& _domain;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+ 
+// ----------------------------------------------------------------------------
+//
+//
+//	Hierarchical Task Networks - HTN Implementation in C++
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+#include "HTNPlanCache.h"
+
+// ----------------------------------------------------------------------------
+
+using namespace HTN;
+
+// ----------------------------------------------------------------------------
+
+
+PlanCache& PlanCache::instance()
+{
+	static PlanCache cache;
+	return cache;
+}
+
+// ----------------------------------------------------------------------------
+
+PlanCache::PlanCache(size_t capacity)
+	: _capacity(capacity)
+{
+
+}
+
+// ----------------------------------------------------------------------------
+
+size_t PlanCache::hash(size_t version, int root, const std::vector<StateData>& states, size_t variables)
+{
+	size_t h = hashValue(hashValue(hashValue(0, version), root), variables);
+	h = hashValue(h, states.size());
+	for (const StateData& data : states)
+	{
+		h = WorldStateProperties::hash(h, data);
+	}
+	return h;
+}
+
+bool PlanCache::matches(const Entry& entry, size_t version, int root, const std::vector<StateData>& states, size_t variables)
+{
+	if (entry.Version != version || entry.Root != root || entry.Variables != variables) return false;
+	if (entry.States.size() != states.size()) return false;
+	for (size_t id = 0; id < states.size(); id++)
+	{
+		if (!WorldStateProperties::equals(entry.States[id], states[id])) return false;
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool PlanCache::find(size_t h, size_t version, int root, const std::vector<StateData>& states, size_t variables, std::vector<int>& plan)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _index.find(h);
+	if (it == _index.end() || !matches(*it->second, version, root, states, variables))
+	{
+		_misses++;
+		return false;
+	}
+	// most recently used
+	_entries.splice(_entries.begin(), _entries, it->second);
+	plan = it->second->Plan;
+	_hits++;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanCache::insert(size_t h, size_t version, int root, const std::vector<StateData>& states, size_t variables, const std::vector<int>& plan)
+{
+	if (_capacity == 0) return;
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _index.find(h);
+	if (it != _index.end())
+	{
+		// same key, or a collision : the newest plan wins
+		_entries.splice(_entries.begin(), _entries, it->second);
+	}
+	else if (_entries.size() >= _capacity)
+	{
+		// the least recently used entry is reused, its vectors keep their memory
+		_index.erase(_entries.back().Hash);
+		_entries.splice(_entries.begin(), _entries, std::prev(_entries.end()));
+		_index[h] = _entries.begin();
+	}
+	else
+	{
+		_entries.emplace_front();
+		_index[h] = _entries.begin();
+	}
+	Entry& entry = _entries.front();
+	entry.Hash = h;
+	entry.Version = version;
+	entry.Root = root;
+	entry.Variables = variables;
+	entry.States.assign(states.begin(), states.end());
+	entry.Plan.assign(plan.begin(), plan.end());
+}
+
+// ----------------------------------------------------------------------------
+
+void PlanCache::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.clear();
+	_index.clear();
+}
@@ -0,0 +1,94 @@
+ 
+// ----------------------------------------------------------------------------
+//
+//
+//	Hierarchical Task Networks - HTN Implementation in C++
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "WorldStateProperties.h"
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <vector>
+
+namespace HTN
+{
+
+	// Plans already found, shared by all the planners : units which use the same domain and
+	// are in the same world states get the same plan without searching it again.
+	// Plans are kept as task identifiers, so they can be used by any instance of the domain
+	class PlanCache
+	{
+	public:
+		// shared cache, created on first use
+		static PlanCache& instance();
+
+		PlanCache(size_t capacity = 4096);
+		// hash of a key : plan of a root task, -1 for the whole search (version is Domain::Version, variables is EvalStack::hash)
+		static size_t hash(size_t version, int root, const std::vector<StateData>& states, size_t variables);
+		// search the plan of a key (h is its hash), returns false if it is not known
+		bool find(size_t h, size_t version, int root, const std::vector<StateData>& states, size_t variables, std::vector<int>& plan);
+		// store the plan of a key (h is its hash), the least recently used plan is replaced when the cache is full
+		void insert(size_t h, size_t version, int root, const std::vector<StateData>& states, size_t variables, const std::vector<int>& plan);
+		// remove all the plans
+		void clear();
+		// number of plans found in the cache
+		size_t hits() const { return _hits; }
+		// number of plans not found in the cache
+		size_t misses() const { return _misses; }
+
+	protected:
+		// a plan with its key
+		struct Entry
+		{
+			size_t Hash;
+			size_t Version;
+			int Root;
+			size_t Variables;
+			std::vector<StateData> States;
+			std::vector<int> Plan;
+		};
+
+		// true if the entry has this key
+		static bool matches(const Entry& entry, size_t version, int root, const std::vector<StateData>& states, size_t variables);
+
+	protected:
+		// maximum number of plans
+		size_t _capacity;
+		// plans, most recently used first
+		std::list<Entry> _entries;
+		// plans by hash of their key
+		std::unordered_map<size_t, std::list<Entry>::iterator> _index;
+		// lock the data
+		std::mutex _mutex;
+		size_t _hits = 0;
+		size_t _misses = 0;
+	};
+
+}
@@ -33,6 +33,7 @@
 #include "CompoundTask.h"
 #include "Planner.h"
 #include "Runner.h"
+#include "Scheduler.h"
 #include "HTNTrace.h"
 #include <iostream>
 
@@ -47,7 +48,7 @@ using namespace HTN;
  
 
 HTNPlanner::HTNPlanner()
-	: _domain(new Domain()), _planner(new Planner(*_domain)), _use_thread(true),
+	: _domain(new Domain()), _planner(new Planner(*_domain)), _use_thread(false),
 	_runner(new Runner(*_domain)), _stop_thread(false), _wait_cycle_ms(1000)
 {
 	 
@@ -58,15 +59,7 @@ HTNPlanner::HTNPlanner()
 
 HTNPlanner::~HTNPlanner()
 {
-	_stop_thread = true;
-	
-	if (_use_thread)
-	{
-		if (_thread.joinable())
-		{
-			_thread.join();
-		}
-	}
+	stop();
 	
 	_domain->free();
 	delete _domain;
@@ -92,14 +85,51 @@ void HTNPlanner::initialize(const std::string& name, bool use_thread, int wait_c
 	_domain->WorldStates.setIsModified(false);
 	initDomainHandler(*_domain);
 	initVariables(*_domain);
+	// units with the same domain share their plans
+	_domain->Cache = &PlanCache::instance();
+	try
+	{
+		_domain->compile();
+	}
+	catch (const std::domain_error& e)
+	{
+		// reported again by the planner on each findPlan
+		HTNTrace(_domain->Name, "Catch domain_error : '%s'", e.what());
+	}
 
+	_last_step = std::chrono::steady_clock::now();
 	if (!_use_thread)
 	{
 		HTNPlanner::run();
 	}
 	else
 	{
-		_thread = std::thread(&HTNPlanner::run, this);
+		// asynchronous operations step the planner when they complete
+		_runner->setWakeup([this]() { Scheduler::instance().wakeup(this); });
+		// let the owner finish its initialization before the first step
+		Scheduler::instance().add(this, 1000);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+void HTNPlanner::wakeup()
+{
+	_replan = true;
+	if (_use_thread)
+	{
+		Scheduler::instance().wakeup(this);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+void HTNPlanner::stop()
+{
+	_stop_thread = true;
+	if (_use_thread)
+	{
+		Scheduler::instance().remove(this);
 	}
 }
  
@@ -110,38 +140,61 @@ void HTNPlanner::run()
 {
 	 
 	std::this_thread::sleep_for(std::chrono::seconds(1));
-	std::chrono::system_clock::time_point dt_started;
+	while (!_stop_thread)
+	{
+		int delay_ms = step();
+		std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+	}
+}
 
-	RunningStatus state = RunningStatus::RunningWaiting;
+// ----------------------------------------------------------------------------
 
-	while (!_stop_thread)
+int HTNPlanner::step()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - _last_step).count();
+	_last_step = now;
+	try
 	{
-			auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - dt_started).count();	
-			try
-			{
-				if (state == RunningStatus::RunningWaiting)
-				{
-					std::vector<BaseTask*> plan = _planner->findPlan();
-					//std::this_thread::sleep_for(std::chrono::seconds(44));
-
-					_runner->loadPlan(plan);
-				}
-				state = _runner->update((float)elapsed_ms);
-				if (state == RunningStatus::RunningFailure || state == RunningStatus::RunningSuccess)
-				{
-					state = RunningStatus::RunningWaiting;
-					//_stop_thread = true;
-				}
-				sensorUpdate(_domain->WorldStates, (float)elapsed_ms);
-
-				
-			}
-			catch (const std::domain_error& e)
+		sensorUpdate(_domain->WorldStates, (float)elapsed_ms);
+		// a new plan only when something changed since the last search
+		if (_running_status == RunningStatus::RunningWaiting && (_replan.exchange(false) || _domain->WorldStates.isModified()))
+		{
+			_domain->WorldStates.setIsModified(false);
+			std::vector<BaseTask*> plan = _planner->findPlan();
+			if (plan.empty())
 			{
-				HTNTrace(_domain->Name, "Catch domain_error : '%s'", e.what());
-
+				// function values read data outside of the world states, which are not marked as modified when
+				// it changes : the search is done again at each cycle, as long as it finds no plan
+				_replan = !_domain->Cacheable;
+				return _wait_cycle_ms;
 			}
-			dt_started = std::chrono::system_clock::now();
-			std::this_thread::sleep_for(std::chrono::milliseconds(_wait_cycle_ms));
+			_runner->loadPlan(plan);
+			_running_status = RunningStatus::RunningContinue;
+		}
+		if (_running_status == RunningStatus::RunningWaiting)
+		{
+			return _wait_cycle_ms;
+		}
+		_running_status = _runner->update((float)elapsed_ms);
+		if (_running_status == RunningStatus::RunningFailure || _running_status == RunningStatus::RunningSuccess)
+		{
+			// the plan is over : search the next one without waiting
+			_running_status = RunningStatus::RunningWaiting;
+			_replan = true;
+			return 0;
+		}
+		if (_runner->isWaitingEvent() && _use_thread)
+		{
+			// the sensors are still updated, at a slow pace, until the operation completes
+			return _event_cycle_ms;
+		}
 	}
-}
\ No newline at end of file
+	catch (const std::domain_error& e)
+	{
+		HTNTrace(_domain->Name, "Catch domain_error : '%s'", e.what());
+		_running_status = RunningStatus::RunningWaiting;
+		_replan = true;
+	}
+	return _wait_cycle_ms;
+}
@@ -34,8 +34,11 @@
 
 #include "WorldStateProperties.h"
 #include "HTNInterface.h"
+#include "Runner.h"
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include <string>
 
 namespace HTN
@@ -44,6 +47,7 @@ namespace HTN
 	struct Domain;
 	class Planner;
 	class Runner;
+	class Scheduler;
 
 	 
 
@@ -55,16 +59,30 @@ namespace HTN
 	public:
 		HTNPlanner();
 		virtual ~HTNPlanner();
-		// initialize the HTN and call handlers
+		// initialize the HTN and call handlers. With use_thread, the planner is stepped in background
+		// by the shared Scheduler, every wait_cycle_ms at most
 		void initialize(const std::string& name,bool use_thread, int wait_cycle_ms = 1000);
+		// step the planner as soon as possible, and search a new plan if it is idle (e.g. a sensor changed)
+		void wakeup();
+		// stop stepping the planner in background (to call before the handlers are destroyed)
+		void stop();
+		// delay between two steps while the plan waits for an asynchronous operation (1 s by default). The sensors are
+		// updated at this pace, the completion of the operation steps the planner at once (-1 : only the completion
+		// or wakeup steps it)
+		void setEventCycle(int cycle_ms) { _event_cycle_ms = cycle_ms; }
 		 	
 
 	protected:
+		friend class Scheduler;
 		
 		// gets the domain
 		Domain& getDomain() { return *_domain; }
-		// thread method
+		// loop on step, when use_thread is false
 		void run();
+		// search a plan if needed, run the current plan and update the sensors.
+		// Returns the delay before the next step in ms (0 : as soon as possible, -1 : once woken up). While the plan
+		// waits for an asynchronous operation, the event cycle (see setEventCycle) : its completion steps it before
+		int step();
 
 	protected:
 		// contains world states and tasks
@@ -73,16 +91,22 @@ namespace HTN
 		Planner* _planner;
 		// run the plan
 		Runner* _runner;
-		// thread used to compute plan in background
-		std::thread _thread;
 		// lock the data
 		std::mutex _mutex;
-		// create a thread yes or no
+		// stepped by the scheduler yes or no
 		bool _use_thread;
-		// if true, quit the thread
+		// if true, quit the run loop
 		bool _stop_thread = false;
-		// sleep thread during cycle in ms
+		// delay between two steps in ms, while a plan is running or the planner is idle
 		int _wait_cycle_ms;
+		// see setEventCycle
+		int _event_cycle_ms = 1000;
+		// status of the running plan
+		RunningStatus _running_status = RunningStatus::RunningWaiting;
+		// a new plan is needed even if the world states are not modified
+		std::atomic<bool> _replan{ true };
+		// time of the last step
+		std::chrono::steady_clock::time_point _last_step;
 		// name of this planner
 		std::string _name;
  	 };
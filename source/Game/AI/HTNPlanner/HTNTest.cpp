@@ -33,42 +33,13 @@
 #include "Planner.h"
 #include "HTNPlanner.h"
 #include "HTNTrace.h"
+#include <random>
 
 // ----------------------------------------------------------------------------
 
 using namespace HTN;
 
 // ----------------------------------------------------------------------------
-
-
-
-
-
-/*
-int main(int argc,char *argv[])
-{
-	{
-		std::vector< HTNDemo*> demos;
-		for (int i = 0; i < 60; i++)
-		{
-			HTNDemo* demo = new HTNDemo("HTN::" + std::to_string(i));
-			demos.push_back(demo);
-		}
-
-		while (true)
-		{
-			std::this_thread::sleep_for(std::chrono::seconds(5));
-			 break;
-		}
-		for (HTNDemo* d : demos)
-		{
-			delete d;
-		}
-	}
-	return(-1);
-}*/
-
-// ----------------------------------------------------------------------------
 // ------ Simple travel Sample
 // ----------------------------------------------------------------------------
 
@@ -221,6 +192,486 @@ OperationStatus simple_travel::RideToPark(OperationStatus status, WStates& state
 
 }
 
+// ----------------------------------------------------------------------------
+// ------ Deep search Sample
+// ----------------------------------------------------------------------------
+
+
+
+struct WsSearch : public StateGroup
+{
+	WsSearch()
+	{
+		// branch with a reachable leaf : branch 0 has the lowest cost, it is tried last
+		States["goal"] = new StateLongValue(0);
+		States["leaves"] = new StateLongValue(0);
+	}
+};
+
+
+
+void deep_search::initWorldStatesHandler(WorldStateMap& worldStates)
+{
+	worldStates["WsSearch"] = WsSearch();
+}
+
+
+
+void deep_search::initDomainHandler(Domain& domain)
+{
+	// a compound task whose methods all failed does not backtrack the method above it :
+	// dead_end, after the subtasks, does it once all the alternatives below failed
+	domain.AddPrimitiveTask("dead_end")
+		.AddPreCondition(DefState("WsSearch", "leaves"), FCT::Inf, new LongValue(0));
+
+	CompoundTask& search = domain.AddCompoundTask("search");
+	for (int b = 0; b < Branches; b++)
+	{
+		std::string branch = "branch_" + std::to_string(b);
+		search.AddMethod("try_" + branch, (float)b)
+			.AddCompoundTask(branch + "_0")
+			.AddPrimitiveTask("dead_end");
+
+		// every level has Fanout methods, all of them go one level deeper
+		for (int d = 0; d < Depth; d++)
+		{
+			CompoundTask& level = domain.AddCompoundTask(branch + "_" + std::to_string(d));
+			for (int f = 0; f < Fanout; f++)
+			{
+				Method& method = level.AddMethod(branch + "_" + std::to_string(d) + "_" + std::to_string(f), (float)f);
+				if (d + 1 < Depth)
+					method.AddCompoundTask(branch + "_" + std::to_string(d + 1)).AddPrimitiveTask("dead_end");
+				else
+					method.AddPrimitiveTask("leaf_" + branch);
+			}
+		}
+
+		// a leaf is only reached in the goal branch
+		domain.AddPrimitiveTask("leaf_" + branch)
+			.AddPreCondition(DefState("WsSearch", "goal"), FCT::IsEqual, new LongValue(b))
+			.AddOperator(Operator([](OperationStatus, WStates&) { return OperationStatus::Success; }))
+			.AddEffect(DefState("WsSearch", "leaves"), FCT::Incr, new LongValue(1));
+	}
+}
+
+// ----------------------------------------------------------------------------
+// ------ Layered plan Sample
+// ----------------------------------------------------------------------------
+
+
+
+struct WsLayer : public StateGroup
+{
+	WsLayer()
+	{
+		States["key"] = new StateLongValue(0);
+		States["steps"] = new StateLongValue(0);
+	}
+};
+
+
+
+void layered_plan::initWorldStatesHandler(WorldStateMap& worldStates)
+{
+	worldStates["WsLayer"] = WsLayer();
+}
+
+
+
+void layered_plan::initDomainHandler(Domain& domain)
+{
+	for (int d = 0; d < Depth; d++)
+	{
+		std::string level = "level_" + std::to_string(d);
+		std::string step = "step_" + std::to_string(d);
+		CompoundTask& task = domain.AddCompoundTask(level);
+		for (int b = 0; b < Branching; b++)
+		{
+			// only method 0, which has the lowest cost, matches the key : it is tried last
+			Method& method = task.AddMethod(level + "_" + std::to_string(b), (float)b)
+				.AddPreCondition(DefState("WsLayer", "key"), FCT::IsEqual, new LongValue(b));
+			if (d + 1 < Depth)
+				method.AddCompoundTask("level_" + std::to_string(d + 1));
+			method.AddPrimitiveTask(step);
+		}
+		domain.AddPrimitiveTask(step)
+			.AddOperator(Operator([](OperationStatus, WStates&) { return OperationStatus::Success; }))
+			.AddEffect(DefState("WsLayer", "steps"), FCT::Incr, new LongValue(1));
+	}
+}
+
+// ----------------------------------------------------------------------------
+// ------ Synthetic domain Sample
+// ----------------------------------------------------------------------------
+
+
+
+struct WsSynthetic : public StateGroup
+{
+	WsSynthetic()
+	{
+		for (int s = 0; s < 10; s++)
+		{
+			States["s" + std::to_string(s)] = new StateLongValue(s);
+		}
+	}
+};
+
+
+
+void synthetic_domain::initWorldStatesHandler(WorldStateMap& worldStates)
+{
+	for (int g = 0; g < 10; g++)
+	{
+		worldStates["group_" + std::to_string(g)] = WsSynthetic();
+	}
+}
+
+
+
+void synthetic_domain::initDomainHandler(Domain& domain)
+{
+	// mt19937 is fully specified : the domain is the same on every platform.
+	// The draws are sequenced one by one, the order of evaluation of arguments is not
+	std::mt19937 random(3);
+	auto state = [&]()
+	{
+		int group = random() % 10;
+		int index = random() % 10;
+		return DefState("group_" + std::to_string(group), "s" + std::to_string(index));
+	};
+
+	int primitives = Tasks / 2;
+	int compounds = Tasks - primitives;
+	for (int p = 0; p < primitives; p++)
+	{
+		// a primitive is done a few times at most : plans backtrack once its counter is high
+		DefState counter = state();
+		long limit = 10 + random() % 10;
+		domain.AddPrimitiveTask("prim_" + std::to_string(p))
+			.AddPreCondition(counter, FCT::Inf, new LongValue(limit))
+			.AddOperator(Operator([](OperationStatus, WStates&) { return OperationStatus::Success; }))
+			.AddEffect(counter, FCT::Incr, new LongValue(1));
+	}
+
+	// comp_0 has the lowest cost : it is searched first, and each compound task calls a deeper one
+	// before its primitives (as layered_plan, the plan ends at the first method tried once it has a step)
+	for (int c = 0; c < compounds; c++)
+	{
+		std::string name = "comp_" + std::to_string(c);
+		CompoundTask& task = domain.AddCompoundTask(name, {}, 1.0f + c);
+		for (int m = 0; m < 3; m++)
+		{
+			// method 0 always applies, it is tried last; the others need a counter that is seldom that high
+			DefState read = state();
+			long bound = m == 0 ? -1 : (long)(15 + random() % 10);
+			Method& method = task.AddMethod(name + "_" + std::to_string(m), (float)m)
+				.AddPreCondition(read, FCT::Sup, new LongValue(bound));
+			if (c + 1 < compounds)
+			{
+				int deeper = c + 1 + random() % std::min(5, compounds - 1 - c);
+				method.AddCompoundTask("comp_" + std::to_string(deeper));
+			}
+			for (int k = 0; k < 2; k++)
+			{
+				method.AddPrimitiveTask("prim_" + std::to_string(random() % primitives));
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// ------ Deep chain Sample
+// ----------------------------------------------------------------------------
+
+
+
+struct WsChain : public StateGroup
+{
+	WsChain()
+	{
+		// steps done, and the attempts of the failing methods (never as many as needed)
+		States["steps"] = new StateLongValue(0);
+		States["attempts"] = new StateLongValue(0);
+	}
+};
+
+
+
+void deep_chain::initWorldStatesHandler(WorldStateMap& worldStates)
+{
+	worldStates["WsChain"] = WsChain();
+}
+
+
+
+void deep_chain::initDomainHandler(Domain& domain)
+{
+	for (int l = 0; l < Levels; l++)
+	{
+		std::string level = "chain_" + std::to_string(l);
+		std::string step = "step_" + std::to_string(l);
+		domain.AddCompoundTask(level, {}, (float)l)
+			.AddMethod(level + "_0", 0.0f)
+			.AddCompoundTask(l + 1 < Levels ? "chain_" + std::to_string(l + 1) : std::string("bottom"))
+			.AddPrimitiveTask(step);
+		domain.AddPrimitiveTask(step)
+			.AddOperator(Operator([](OperationStatus, WStates&) { return OperationStatus::Success; }))
+			.AddEffect(DefState("WsChain", "steps"), FCT::Incr, new LongValue(1));
+	}
+
+	// each failing method changes the state, then its primitive fails : the whole chain is backtracked to it
+	domain.AddPrimitiveTask("attempt")
+		.AddEffect(DefState("WsChain", "attempts"), FCT::Incr, new LongValue(1));
+	domain.AddPrimitiveTask("give_up")
+		.AddPreCondition(DefState("WsChain", "attempts"), FCT::Sup, new LongValue(Failing));
+	CompoundTask& bottom = domain.AddCompoundTask("bottom", {}, (float)Levels);
+	for (int f = 1; f <= Failing; f++)
+	{
+		bottom.AddMethod("bottom_" + std::to_string(f), (float)f)
+			.AddPreCondition(DefState("WsChain", "attempts"), FCT::Inf, new LongValue(Failing))
+			.AddPrimitiveTask("attempt")
+			.AddPrimitiveTask("give_up");
+	}
+	// the lowest cost : tried last
+	bottom.AddMethod("bottom_0", 0.0f)
+		.AddPrimitiveTask("step_bottom");
+	domain.AddPrimitiveTask("step_bottom")
+		.AddOperator(Operator([](OperationStatus, WStates&) { return OperationStatus::Success; }))
+		.AddEffect(DefState("WsChain", "steps"), FCT::Incr, new LongValue(1));
+}
+
+// ----------------------------------------------------------------------------
+// ------ Wide methods Sample
+// ----------------------------------------------------------------------------
+
+
+
+struct WsWide : public StateGroup
+{
+	WsWide()
+	{
+		// cost of the method which applies
+		States["key"] = new StateLongValue(0);
+		States["steps"] = new StateLongValue(0);
+	}
+};
+
+
+
+void wide_methods::initWorldStatesHandler(WorldStateMap& worldStates)
+{
+	worldStates["WsWide"] = WsWide();
+}
+
+
+
+void wide_methods::initDomainHandler(Domain& domain)
+{
+	CompoundTask& task = domain.AddCompoundTask("wide");
+	for (int m = 0; m < Methods; m++)
+	{
+		// the costs are a permutation of 0..Methods-1 (7919 is prime)
+		long cost = (long)m * 7919 % Methods;
+		std::string step = "wide_step_" + std::to_string(m);
+		task.AddMethod("wide_" + std::to_string(m), (float)cost)
+			.AddPreCondition(DefState("WsWide", "key"), FCT::IsEqual, new LongValue(cost))
+			.AddPrimitiveTask(step);
+		domain.AddPrimitiveTask(step)
+			.AddOperator(Operator([](OperationStatus, WStates&) { return OperationStatus::Success; }))
+			.AddEffect(DefState("WsWide", "steps"), FCT::Incr, new LongValue(1));
+	}
+}
+
+// ----------------------------------------------------------------------------
+// ------ Long operation Sample
+// ----------------------------------------------------------------------------
+
+
+
+OperationTimers& OperationTimers::instance()
+{
+	static OperationTimers timers;
+	return timers;
+}
+
+OperationTimers::OperationTimers()
+	: _thread(&OperationTimers::run, this)
+{
+
+}
+
+OperationTimers::~OperationTimers()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_signal.notify_all();
+	_thread.join();
+}
+
+void OperationTimers::add(const OperationHandlePtr& handle, int delay_ms)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	clock::time_point due = clock::now() + std::chrono::milliseconds(delay_ms);
+	// the thread only needs to wake up earlier
+	bool earlier = _timers.empty() || due < _timers.top().first;
+	_timers.push({ due, handle });
+	if (earlier)
+	{
+		_signal.notify_all();
+	}
+}
+
+void OperationTimers::run()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_stop)
+	{
+		if (_timers.empty())
+		{
+			_signal.wait(lock);
+			continue;
+		}
+		if (_timers.top().first > clock::now())
+		{
+			_signal.wait_until(lock, _timers.top().first);
+			continue;
+		}
+		OperationHandlePtr handle = _timers.top().second;
+		_timers.pop();
+		lock.unlock();
+		handle->complete(true);
+		lock.lock();
+	}
+}
+
+
+
+struct WsWork : public StateGroup
+{
+	WsWork()
+	{
+		States["done"] = new StateLongValue(0);
+	}
+};
+
+
+
+void long_operation::initWorldStatesHandler(WorldStateMap& worldStates)
+{
+	worldStates["WsWork"] = WsWork();
+}
+
+
+
+void long_operation::initDomainHandler(Domain& domain)
+{
+	domain.AddCompoundTask("work")
+		.AddMethod("work", 0)
+			.AddPrimitiveTask("operate").back().back()
+		.AddPrimitiveTask("operate")
+			.AddOperator(Async ? Operator([this](WStates& states) { return StartWork(states); })
+				: Operator([this](OperationStatus status, WStates& states) { return Work(status, states); }))
+			.AddEffect(DefState("WsWork", "done"), FCT::Incr, new LongValue(1));
+}
+
+
+
+long long_operation::done()
+{
+	return getDomain().WorldStates.wStateAsLong("WsWork", "done");
+}
+
+
+
+OperationStatus long_operation::Work(OperationStatus status, WStates& states)
+{
+	Polls++;
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (status == OperationStatus::FirstEvaluation)
+	{
+		_due = now + std::chrono::milliseconds(Duration);
+	}
+	if (now < _due)
+	{
+		return OperationStatus::Continue;
+	}
+	return OperationStatus::Success;
+}
+
+
+
+OperationHandlePtr long_operation::StartWork(WStates& states)
+{
+	OperationHandlePtr handle = OperationHandle::create();
+	Started++;
+	OperationTimers::instance().add(handle, Duration);
+	return handle;
+}
+
+// ----------------------------------------------------------------------------
+// ------ Reactive agent Sample
+// ----------------------------------------------------------------------------
+
+
+
+struct WsAlert : public StateGroup
+{
+	WsAlert()
+	{
+		States["alert"] = new StateLongValue(0);
+		States["gate"] = new StateBoolValue(true);
+	}
+};
+
+
+
+void reactive_agent::initWorldStatesHandler(WorldStateMap& worldStates)
+{
+	worldStates["WsAlert"] = WsAlert();
+}
+
+
+
+void reactive_agent::initDomainHandler(Domain& domain)
+{
+	domain.AddCompoundTask("answer")
+		.AddMethod("answer", 0)
+			.AddPreCondition(DefState("WsAlert", "alert"), FCT::IsEqual, new LongValue(1))
+			.AddPreCondition(DefState("WsAlert", "gate"), FCT::IsEqual, new FctBoolValue([this]() { return Gate.load(); }))
+				.AddPrimitiveTask("respond").back().back()
+		.AddPrimitiveTask("respond")
+			.AddOperator(Operator([this](OperationStatus, WStates&)
+			{
+				std::chrono::steady_clock::duration alerted(_alerted.load());
+				Latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch() - alerted).count());
+				Answered++;
+				return OperationStatus::Success;
+			}))
+			.AddEffect(DefState("WsAlert", "alert"), FCT::Equal, new LongValue(0));
+}
+
+
+
+void reactive_agent::sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime)
+{
+	if (_alert.exchange(false))
+	{
+		worldStates.wSetState("WsAlert", "alert", 1L);
+	}
+}
+
+
+
+void reactive_agent::alert()
+{
+	_alerted = std::chrono::steady_clock::now().time_since_epoch().count();
+	_alert = true;
+	wakeup();
+}
+
 // ----------------------------------------------------------------------------
 // ------ BeTrunkThumper Sample
 // ----------------------------------------------------------------------------
@@ -363,3 +814,1171 @@ Compound Task[BeTrunkThumper]
 	Primitive Task[CheckBridge]
 		Operator[CheckBridgeOperator(SearchAnimName)]
 */
+
+
+
+// ----------------------------------------------------------------------------
+// ------ Benchmark
+// ----------------------------------------------------------------------------
+
+#if defined HTN_BENCHMARK
+
+// Headless benchmark and regression check of the planner, without Unigine.
+// The HTN project defines HTN_BENCHMARK, on Linux :
+//   g++ -std=c++17 -O2 -DNDEBUG -DHTN_BENCHMARK -pthread *.cpp -o htn_benchmark
+//   ./htn_benchmark [--record] [--cache] [--speculation K] [--iterations N] [golden file]
+// The plans are compared to the golden file (HTNGolden.txt, run from this directory). Its plans were found by the
+// planner before the compiled domains, on the same samples : the lines which changed since are preceded by comments
+// (#) giving the former plan and the reason. --record only adds the scenarios missing from it.
+//   ./htn_benchmark --methods N [--iterations N]
+// times the plans of a task with N methods (256) out of cost order, sorted once by Domain::compile and sorted again
+// before each plan, as findPlan did. Checks that the plans are the same and that sorting once is faster.
+//   ./htn_benchmark --randomized N
+// searches N plans of each sample over random states, drawn among 64, with the plan cache and the method memo and
+// without them. Checks that the plans are the same, and that the cache found some of them.
+//   ./htn_benchmark --failing [--speculation K] [--iterations N]
+// times deep_search, whose branches all fail but the goal one, searched sequentially and with K (4) methods explored
+// in parallel. Checks that the plans are the golden ones, and that speculation is faster once there are several cores.
+//   ./htn_benchmark --preconditions [--iterations N]
+// evaluates every precondition of the samples with its compiled instruction and with the generic comparison of
+// variants it replaced. Checks that the results are the same, and that the instructions are faster.
+//   ./htn_benchmark --deep [--record] [--cache] [--speculation K] [--iterations N]
+// runs chains of 100 and 400 levels which backtrack through 50 failing methods at the bottom, compared to the
+// golden file as well. Checks that the undo logs of the planner make less than one allocation per level.
+//   ./htn_benchmark --operators N [--seconds S]
+// runs N agents with long operations on the Scheduler, polled or asynchronous, and compares their CPU time and
+// steps : while their operation runs, the asynchronous agents are only stepped at their event cycle (1 s), which
+// updates their sensors. Checks that a shorter event cycle keeps the sensors updated meanwhile.
+//   ./htn_benchmark --operators N --stress [--seconds S]
+// runs N agents with short asynchronous operations, woken up meanwhile from other threads, and checks that every
+// operation is received once. Build with -fsanitize=thread to check the completions and the Scheduler for data races.
+//   ./htn_benchmark --planners N [--seconds S]
+// runs N planners (2000) on the Scheduler, each alerted once a second for S seconds, and reports the threads, the
+// CPU time and the time from an alert to its answer. Checks that every alert is answered, that the threads do not
+// grow with the planners, and that a plan waiting for a function value is found once it changes.
+//   ./htn_benchmark --lookups [--iterations N]
+// times the subtask and state lookups by name, as the planner did them before Domain::compile, against the lookups
+// by identifier on the 500 tasks synthetic domain. Checks that both find the same tasks and states. Then times
+// findPlan on simple_travel and the synthetic domain against the same search by names (NamePlanner), and checks that
+// both find the same plans and that the compiled domain is faster.
+//   ./htn_benchmark --snapshots [--iterations N]
+// times the copy of the world state made for a backtrack point, as the tree of declared states and as the flat
+// values of the compiled domain. Checks that the flat copy allocates once at most, and is 10 times faster on the
+// synthetic domain (100 states).
+
+#include "HTNPlanCache.h"
+#include "Scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <ctime>
+#if defined _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// allocations of the process
+static std::atomic<size_t> g_allocations(0);
+
+// not inlined : gcc would pair the malloc and free of their bodies with the new and delete expressions of this file
+#if defined _MSC_VER
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+BENCH_NOINLINE void* operator new(size_t size)
+{
+	g_allocations++;
+	if (void* p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+BENCH_NOINLINE void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+BENCH_NOINLINE void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+BENCH_NOINLINE void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+BENCH_NOINLINE void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+BENCH_NOINLINE void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace
+{
+	// command line
+	struct BenchOptions
+	{
+		bool Record = false;
+		bool Cache = false;
+		size_t Speculation = 0;
+		int Iterations = 1000;
+		std::string Golden = "HTNGolden.txt";
+		// agents of the operator simulation, none by default
+		int Operators = 0;
+		// completions and wakeups from many threads instead (see stress)
+		bool Stress = false;
+		// planners of the scale test, none by default
+		int Planners = 0;
+		// lookups by name against lookups by identifier (see lookups)
+		bool Lookups = false;
+		// copies of the declared states against copies of the compiled ones (see snapshot)
+		bool Snapshots = false;
+		// deep_chain scenarios instead of the samples
+		bool Deep = false;
+		// methods of the ordering benchmark, none by default (see ordering)
+		int Methods = 0;
+		// plans of the cache check by sample, none by default (see randomized)
+		int Randomized = 0;
+		// sequential against speculative search (see failing)
+		bool Failing = false;
+		// compiled against generic precondition evaluation (see evaluation)
+		bool Preconditions = false;
+		int Seconds = 5;
+	};
+
+	// measures of one scenario
+	struct BenchResult
+	{
+		std::string Plan;
+		size_t Steps = 0;
+		double PlansPerSecond = 0;
+		double P99 = 0;
+		double Allocations = 0;
+		double Backtracks = 0;
+		// time to run the plan with the Runner, 0 if not run
+		double RunTime = 0;
+	};
+
+	// a sample loaded without the run loop of HTNPlanner::initialize
+	template <class T>
+	struct Bench : public T
+	{
+		template <typename... Args>
+		Bench(Args... args) : T(args...) {}
+
+		void load(const std::string& name, const BenchOptions& options)
+		{
+			this->_name = name;
+			this->_domain->Name = name;
+			this->initWorldStatesHandler(this->_domain->WorldStates.CurrentWorldState);
+			this->initDomainHandler(*this->_domain);
+			this->initVariables(*this->_domain);
+			this->_domain->Cache = options.Cache ? &PlanCache::instance() : nullptr;
+			this->_domain->compile();
+			this->_planner->setSpeculation(options.Speculation);
+		}
+
+		// search the plan iterations times, then run it with the Runner (if run)
+		BenchResult measure(int iterations, bool run)
+		{
+			typedef std::chrono::steady_clock clock;
+			BenchResult result;
+			std::vector<BaseTask*> plan = this->_planner->findPlan();
+			for (BaseTask* task : plan)
+			{
+				result.Plan += (result.Plan.empty() ? "" : " ") + task->Name;
+			}
+			result.Steps = plan.size();
+
+			std::vector<double> times;
+			times.reserve(iterations);
+			size_t allocations = g_allocations;
+			size_t backtracks = this->_planner->backtrackCount();
+			clock::time_point start = clock::now();
+			for (int i = 0; i < iterations; i++)
+			{
+				clock::time_point t = clock::now();
+				this->_planner->findPlan();
+				times.push_back(std::chrono::duration<double, std::micro>(clock::now() - t).count());
+			}
+			double total = std::chrono::duration<double>(clock::now() - start).count();
+			// the times vector does not allocate in the loop
+			result.Allocations = (double)(g_allocations - allocations) / iterations;
+			result.Backtracks = (double)(this->_planner->backtrackCount() - backtracks) / iterations;
+			result.PlansPerSecond = iterations / total;
+			std::sort(times.begin(), times.end());
+			result.P99 = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+
+			if (run && !plan.empty())
+			{
+				// the operators change the world states : they are restored after each run
+				std::vector<StateData> values = this->_domain->WorldStates.Values;
+				clock::time_point t = clock::now();
+				for (int i = 0; i < iterations; i++)
+				{
+					this->_runner->loadPlan(plan);
+					while (this->_runner->update(0.0f) == RunningStatus::RunningContinue);
+					this->_domain->WorldStates.Values = values;
+				}
+				result.RunTime = std::chrono::duration<double, std::micro>(clock::now() - t).count() / iterations;
+			}
+			return result;
+		}
+
+		Domain& domain() { return *this->_domain; }
+		std::vector<BaseTask*> findPlan() { return this->_planner->findPlan(); }
+	};
+
+	// CPU time of the process in seconds
+	double cpuSeconds()
+	{
+#if defined _WIN32
+		FILETIME creation, exit, kernel, user;
+		GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+		auto seconds = [](const FILETIME& t) { return (double)(((unsigned long long)t.dwHighDateTime << 32) | t.dwLowDateTime) * 1e-7; };
+		return seconds(kernel) + seconds(user);
+#else
+		return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+	}
+
+	// measures of the world state copies of a domain (times in ns)
+	struct SnapshotResult
+	{
+		size_t States = 0;
+		double TreeTime = 0;
+		double TreeAllocations = 0;
+		double FlatTime = 0;
+		double FlatAllocations = 0;
+	};
+
+	// measures of the precondition evaluations of a domain (in millions a second)
+	struct EvaluationResult
+	{
+		size_t Preconditions = 0;
+		size_t Compiled = 0;
+		double CompiledRate = 0;
+		double GenericRate = 0;
+		bool Same = true;
+	};
+
+	// measures of the operator simulation
+	struct SimulationResult
+	{
+		long Operations = 0;
+		long Polls = 0;
+		long Steps = 0;
+		double Cpu = 0;
+	};
+
+	// measures of the scheduler scale test
+	struct ScaleResult
+	{
+		long Alerts = 0;
+		long Answered = 0;
+		double Cpu = 0;
+		int Threads = 0;
+		std::vector<double> Latencies;
+	};
+
+	// threads of the process, -1 if unknown
+	int processThreads()
+	{
+#if defined __linux__
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+		{
+			if (line.compare(0, 8, "Threads:") == 0) return atoi(line.c_str() + 8);
+		}
+#endif
+		return -1;
+	}
+
+	// planners idle between their alerts, stepped every second : each one is alerted once a second, spread over the second
+	ScaleResult scale(int planners, int seconds)
+	{
+		ScaleResult result;
+		std::vector<std::unique_ptr<reactive_agent>> agents;
+		for (int i = 0; i < planners; i++)
+		{
+			agents.emplace_back(new reactive_agent());
+			agents.back()->initialize("agent_" + std::to_string(i), true, 1000);
+		}
+		// the first step is one second after initialize
+		std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+		double cpu = cpuSeconds();
+		const int ticks = 100;
+		for (int second = 0; second < seconds; second++)
+		{
+			for (int tick = 0; tick < ticks; tick++)
+			{
+				for (int i = tick; i < planners; i += ticks)
+				{
+					agents[i]->alert();
+					result.Alerts++;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1000 / ticks));
+			}
+		}
+		// the last alerts are answered
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		result.Cpu = cpuSeconds() - cpu;
+		result.Threads = processThreads();
+		for (auto& agent : agents)
+		{
+			agent->stop();
+			result.Answered += agent->Answered;
+			result.Latencies.insert(result.Latencies.end(), agent->Latencies.begin(), agent->Latencies.end());
+		}
+		std::sort(result.Latencies.begin(), result.Latencies.end());
+		return result;
+	}
+
+	// an alert while the gate is closed : the plan is found once the gate opens, although the world states do not change
+	bool gateOpens()
+	{
+		reactive_agent agent(false);
+		agent.initialize("gated", true, 50);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+		agent.alert();
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		bool waited = agent.Answered == 0;
+		agent.Gate = true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		bool answered = agent.Answered == 1;
+		agent.stop();
+		return waited && answered;
+	}
+
+	// agents repeating operations of 100 to 500 ms for some seconds, stepped every cycle_ms
+	// (every event_cycle_ms and by the completions while an asynchronous operation runs)
+	SimulationResult simulate(int agents, int seconds, bool async, int cycle_ms, int event_cycle_ms = 1000)
+	{
+		SimulationResult result;
+		std::vector<std::unique_ptr<long_operation>> units;
+		for (int i = 0; i < agents; i++)
+		{
+			units.emplace_back(new long_operation(async, 100 + (i * 37) % 400));
+			units.back()->setEventCycle(event_cycle_ms);
+			units.back()->initialize("agent_" + std::to_string(i), true, cycle_ms);
+		}
+		double cpu = cpuSeconds();
+		// the first step is one second after initialize
+		std::this_thread::sleep_for(std::chrono::seconds(1 + seconds));
+		for (auto& unit : units)
+		{
+			unit->stop();
+		}
+		result.Cpu = cpuSeconds() - cpu;
+		for (auto& unit : units)
+		{
+			result.Operations += unit->done();
+			result.Polls += unit->Polls;
+			result.Steps += unit->Steps;
+		}
+		return result;
+	}
+
+	// agents repeating asynchronous operations of 0 to 3 ms, woken up meanwhile by other threads as sensor events
+	// would : every operation started must complete once, and be received by its runner
+	bool stress(int agents, int seconds)
+	{
+		std::vector<std::unique_ptr<long_operation>> units;
+		for (int i = 0; i < agents; i++)
+		{
+			units.emplace_back(new long_operation(true, i % 4));
+			units.back()->initialize("agent_" + std::to_string(i), true, 1000);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+		std::atomic<bool> stopped{ false };
+		std::atomic<long> wakeups{ 0 };
+		std::vector<std::thread> sensors;
+		for (int t = 0; t < 4; t++)
+		{
+			sensors.emplace_back([&, t]()
+			{
+				for (unsigned int i = t; !stopped; i = i * 1103515245u + 12345u)
+				{
+					units[i % units.size()]->wakeup();
+					wakeups++;
+					if (i % 64 == 0) std::this_thread::yield();
+				}
+			});
+		}
+		std::this_thread::sleep_for(std::chrono::seconds(seconds));
+		stopped = true;
+		for (std::thread& sensor : sensors)
+		{
+			sensor.join();
+		}
+		long operations = 0;
+		bool received = true;
+		for (auto& unit : units)
+		{
+			unit->stop();
+			// the last operation started may still run
+			long done = unit->done();
+			received = received && done > 0 && (done == unit->Started || done == unit->Started - 1);
+			operations += done;
+		}
+		printf("%d agents, %ld operations, %ld wakeups in %d s : every operation received once : %s\n", agents, operations,
+			wakeups.load(), seconds, received ? "yes" : "NO");
+		return received;
+	}
+
+	// copies of the world state of a loaded sample, as a backtrack point made them : the declared states, one
+	// BaseState per state in maps of groups (cloned then freed), and the values of the compiled domain
+	template <class T>
+	SnapshotResult snapshot(Bench<T>& sample, int iterations)
+	{
+		typedef std::chrono::steady_clock clock;
+		SnapshotResult result;
+		Domain& domain = sample.domain();
+		result.States = domain.StatesById.size();
+		WStates declared(domain);
+		sample.initWorldStatesHandler(declared.CurrentWorldState);
+
+		size_t allocations = g_allocations;
+		clock::time_point t = clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			WStates copy(domain);
+			copy.clone(declared);
+			copy.free();
+		}
+		result.TreeTime = std::chrono::duration<double, std::nano>(clock::now() - t).count() / iterations;
+		result.TreeAllocations = (double)(g_allocations - allocations) / iterations;
+
+		allocations = g_allocations;
+		t = clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			WStates copy(domain);
+			copy.clone(domain.WorldStates);
+		}
+		result.FlatTime = std::chrono::duration<double, std::nano>(clock::now() - t).count() / iterations;
+		result.FlatAllocations = (double)(g_allocations - allocations) / iterations;
+		declared.free();
+		return result;
+	}
+
+	// measures of the cache check of a sample
+	struct RandomizedResult
+	{
+		long Plans = 0;
+		long Different = 0;
+		size_t Hits = 0;
+		double Cached = 0;
+		double Uncached = 0;
+	};
+
+	// plans of a sample over random states drawn among 64 (the same ones for every run), with the plan cache and the
+	// method memo, and without them
+	template <class T, typename... Args>
+	RandomizedResult randomized(int draws, Args... args)
+	{
+		typedef std::chrono::steady_clock clock;
+		RandomizedResult result;
+		BenchOptions options;
+		Bench<T> cached(args...);
+		Bench<T> uncached(args...);
+		cached.load("cached", options);
+		uncached.load("uncached", options);
+		cached.domain().Cache = &PlanCache::instance();
+		for (BaseTask* task : uncached.domain().TasksById)
+		{
+			if (task->Kind == TASK_COMPOUND) static_cast<CompoundTask*>(task)->Memoizable = false;
+		}
+
+		std::mt19937 random(7);
+		std::vector<std::vector<StateData>> states(64, uncached.domain().WorldStates.Values);
+		for (std::vector<StateData>& values : states)
+		{
+			for (StateData& value : values)
+			{
+				if (value.Type == VAR_BOOL) value.B = random() % 2 == 0;
+				else if (value.Type == VAR_LONG) value.L = (long)(random() % 25) - 1;
+				else if (value.Type == VAR_FLOAT) value.F = (float)(random() % 100) / 4;
+			}
+		}
+
+		size_t hits = PlanCache::instance().hits();
+		for (int i = 0; i < draws; i++)
+		{
+			const std::vector<StateData>& values = states[random() % states.size()];
+			cached.domain().WorldStates.Values = values;
+			uncached.domain().WorldStates.Values = values;
+			clock::time_point t = clock::now();
+			std::vector<BaseTask*> plan = cached.findPlan();
+			result.Cached += std::chrono::duration<double, std::micro>(clock::now() - t).count();
+			t = clock::now();
+			std::vector<BaseTask*> reference = uncached.findPlan();
+			result.Uncached += std::chrono::duration<double, std::micro>(clock::now() - t).count();
+			// tasks of two instances of the domain : same identifiers
+			bool same = plan.size() == reference.size();
+			for (size_t s = 0; s < plan.size() && same; s++)
+			{
+				same = plan[s]->Id == reference[s]->Id;
+			}
+			result.Plans++;
+			result.Different += !same;
+		}
+		result.Hits = PlanCache::instance().hits() - hits;
+		result.Cached /= draws;
+		result.Uncached /= draws;
+		return result;
+	}
+
+	// deep_search with the goal branch tried last and without goal : the failing branches are searched sequentially,
+	// then with options.Speculation methods in parallel (4 if not set)
+	bool failing(const BenchOptions& options, const std::map<std::string, std::string>& golden)
+	{
+		BenchOptions sequential = options;
+		sequential.Speculation = 0;
+		BenchOptions parallel = options;
+		parallel.Speculation = options.Speculation > 1 ? options.Speculation : 4;
+		const int iterations = std::max(1, options.Iterations / 50);
+		unsigned int cores = std::thread::hardware_concurrency();
+		bool ok = true;
+		bool faster = true;
+		printf("%-28s %14s %14s %10s  %s\n", "failing branches", "sequential us", "parallel us", "speedup", "golden");
+		for (int goal : { 0, -1 })
+		{
+			std::string name = "deep_search 8x4x5 goal " + std::to_string(goal);
+			BenchResult results[2];
+			const BenchOptions* runs[2] = { &sequential, &parallel };
+			for (int r = 0; r < 2; r++)
+			{
+				Bench<deep_search> sample(8, 4, 5);
+				sample.load("deep", *runs[r]);
+				sample.domain().WorldStates.wSetState("WsSearch", "goal", (long)goal);
+				results[r] = sample.measure(iterations, false);
+			}
+			auto it = golden.find(name);
+			bool same = it != golden.end() && it->second == results[0].Plan && it->second == results[1].Plan;
+			// plans per second
+			double speedup = results[1].PlansPerSecond / results[0].PlansPerSecond;
+			printf("%-28s %14.1f %14.1f %10.2f  %s\n", name.c_str(), 1e6 / results[0].PlansPerSecond,
+				1e6 / results[1].PlansPerSecond, speedup, same ? "ok" : "DIFFERENT");
+			ok = ok && same;
+			faster = faster && speedup > 1;
+		}
+		printf("%zu methods in parallel on %u cores : plans are the golden ones : %s, faster : %s\n", parallel.Speculation,
+			cores, ok ? "yes" : "NO", faster ? "yes" : cores < 2 ? "no (single core, not checked)" : "NO");
+		return ok && (faster || cores < 2);
+	}
+
+	// the preconditions of the primitives and methods of a sample, evaluated in its initial world state by
+	// Precondition::isSatisfied (the compiled instruction, or the generic comparison when it does not apply)
+	// and by the generic comparison alone
+	template <class T, typename... Args>
+	EvaluationResult evaluation(int iterations, Args... args)
+	{
+		typedef std::chrono::steady_clock clock;
+		EvaluationResult result;
+		BenchOptions options;
+		Bench<T> sample(args...);
+		sample.load("eval", options);
+		Domain& domain = sample.domain();
+		std::vector<Precondition*> preconditions;
+		for (BaseTask* task : domain.TasksById)
+		{
+			if (task->Kind == TASK_PRIMITIVE)
+			{
+				for (Precondition& pre : static_cast<PrimitiveTask*>(task)->Preconditions) preconditions.push_back(&pre);
+			}
+			else if (task->Kind == TASK_COMPOUND)
+			{
+				for (Method& method : static_cast<CompoundTask*>(task)->Methods)
+					for (Precondition& pre : method.Preconditions) preconditions.push_back(&pre);
+			}
+		}
+		WStates& states = domain.WorldStates;
+		EvalStack& stack = domain.EvalTask;
+		result.Preconditions = preconditions.size();
+		for (Precondition* pre : preconditions)
+		{
+			result.Compiled += pre->Code.Op != OP_GENERIC;
+			result.Same = result.Same && pre->isSatisfied(stack, states) == states.wCompare(stack, pre->Condition, pre->Fct, pre->Value);
+		}
+
+		// the counts of satisfied preconditions keep the evaluations from being optimized out
+		size_t compiled = 0;
+		size_t generic = 0;
+		clock::time_point t = clock::now();
+		for (int i = 0; i < iterations; i++)
+			for (Precondition* pre : preconditions) compiled += pre->isSatisfied(stack, states);
+		double compiledTime = std::chrono::duration<double, std::micro>(clock::now() - t).count();
+		t = clock::now();
+		for (int i = 0; i < iterations; i++)
+			for (Precondition* pre : preconditions) generic += states.wCompare(stack, pre->Condition, pre->Fct, pre->Value);
+		double genericTime = std::chrono::duration<double, std::micro>(clock::now() - t).count();
+		double evaluations = (double)iterations * preconditions.size();
+		result.CompiledRate = evaluations / compiledTime;
+		result.GenericRate = evaluations / genericTime;
+		result.Same = result.Same && compiled == generic;
+		return result;
+	}
+
+	// plans of wide_methods with the order of the methods kept, and sorted again before each plan as findPlan did
+	// before Domain::sort (both without the memo of the methods, which skips the failing ones)
+	bool ordering(const BenchOptions& options)
+	{
+		typedef std::chrono::steady_clock clock;
+		Bench<wide_methods> sample(options.Methods);
+		sample.load("wide", options);
+		Domain& domain = sample.domain();
+		for (BaseTask* task : domain.TasksById)
+		{
+			if (task->Kind == TASK_COMPOUND) static_cast<CompoundTask*>(task)->Memoizable = false;
+		}
+		std::vector<BaseTask*> sorted = sample.findPlan();
+		domain.sort();
+		bool same = sample.findPlan() == sorted && sorted.size() == 1;
+
+		const int iterations = std::max(1, options.Iterations);
+		clock::time_point t = clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			domain.sort();
+			same = same && sample.findPlan() == sorted;
+		}
+		double resorted = std::chrono::duration<double, std::micro>(clock::now() - t).count() / iterations;
+		t = clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			same = same && sample.findPlan() == sorted;
+		}
+		double once = std::chrono::duration<double, std::micro>(clock::now() - t).count() / iterations;
+
+		printf("%-24s %8s %16s %16s %10s\n", "ordering", "methods", "sorted each us", "sorted once us", "speedup");
+		printf("%-24s %8d %16.2f %16.2f %10.1f\n", "wide_methods", options.Methods, resorted, once, resorted / once);
+		printf("same plans : %s, sorting once faster : %s\n", same ? "yes" : "NO", once < resorted ? "yes" : "NO");
+		return same && once < resorted;
+	}
+
+	// findPlan as the planner did it before Domain::compile, on the tasks of a compiled domain : the subtasks are
+	// found by name (findTask scans the tasks), the preconditions and effects find their states by name (the generic
+	// wCompare and wSetState of a state without identifier), and each decomposition point copies the world state as
+	// a tree of names. The tasks and methods are sorted once, as for findPlan (see ordering)
+	class NamePlanner
+	{
+	public:
+		NamePlanner(Domain& domain) : _domain(domain), _states(domain)
+		{
+			for (BaseTask* task : domain.TasksById)
+			{
+				if (task->Kind == TASK_PRIMITIVE)
+				{
+					PrimitiveTask* primitive = static_cast<PrimitiveTask*>(task);
+					addNames(primitive, primitive->Preconditions);
+					for (const Effect& effect : primitive->Effects) _names[primitive].Effects.push_back(byName(effect.State));
+				}
+				else if (task->Kind == TASK_COMPOUND)
+				{
+					for (Method& method : static_cast<CompoundTask*>(task)->Methods) addNames(&method, method.Preconditions);
+				}
+			}
+		}
+
+		std::vector<BaseTask*> findPlan()
+		{
+			std::vector<BaseTask*> plan;
+			for (BaseTask* task : _domain.Tasks)
+			{
+				if (task->Kind != TASK_COMPOUND) continue;
+				plan = findPlan(task);
+				if (!plan.empty()) break;
+			}
+			return plan;
+		}
+
+	private:
+		// group -> state -> value
+		typedef std::map<std::string, std::map<std::string, StateData>> StateTree;
+		struct Backtrack
+		{
+			size_t PlanSize;
+			std::deque<BaseTask*> Tasks;
+			StateTree States;
+		};
+		// the states of the preconditions and effects of a task, without identifier
+		struct Names
+		{
+			std::vector<DefState> Preconditions;
+			std::vector<DefState> Effects;
+		};
+
+		static DefState byName(const DefState& state) { return DefState(state.Group, state.State); }
+
+		void addNames(BaseTask* task, const std::vector<Precondition>& preconditions)
+		{
+			for (const Precondition& pre : preconditions) _names[task].Preconditions.push_back(byName(pre.Condition));
+		}
+
+		bool isSatisfied(BaseTask* task, const std::vector<Precondition>& preconditions, EvalStack& evalTask)
+		{
+			const std::vector<DefState>& states = _names[task].Preconditions;
+			for (size_t i = 0; i < preconditions.size(); i++)
+			{
+				if (!_states.wCompare(evalTask, states[i], preconditions[i].Fct, preconditions[i].Value)) return false;
+			}
+			return true;
+		}
+
+		StateTree snapshot()
+		{
+			StateTree tree;
+			for (const DefState& state : _domain.StatesById)
+			{
+				tree[state.Group][state.State] = _states.Values[_domain.stateId(state.Group, state.State)];
+			}
+			return tree;
+		}
+
+		void restore(std::vector<BaseTask*>& plan, std::deque<BaseTask*>& tasks, std::deque<Backtrack>& history)
+		{
+			if (history.empty()) return;
+			Backtrack& bp = history.front();
+			plan.resize(bp.PlanSize);
+			tasks = bp.Tasks;
+			for (auto& group : bp.States)
+			{
+				for (auto& state : group.second) _states.Values[_domain.stateId(group.first, state.first)] = state.second;
+			}
+			history.pop_front();
+		}
+
+		std::vector<BaseTask*> findPlan(BaseTask* root)
+		{
+			std::vector<BaseTask*> plan;
+			std::deque<BaseTask*> tasks(1, root);
+			std::deque<Backtrack> history;
+			_states.clone(_domain.WorldStates);
+			EvalStack evalTask = _domain.EvalTask;
+			while (!tasks.empty())
+			{
+				BaseTask* task = tasks.front();
+				tasks.pop_front();
+				if (task->Kind == TASK_COMPOUND)
+				{
+					for (Method* method : static_cast<CompoundTask*>(task)->SortedMethods) tasks.push_front(method);
+				}
+				else if (task->Kind == TASK_METHOD)
+				{
+					Method* method = static_cast<Method*>(task);
+					if (!plan.empty()) break;
+					history.push_front({ plan.size(), tasks, snapshot() });
+					if (isSatisfied(method, method->Preconditions, evalTask))
+					{
+						std::vector<TaskRef> subtasks = method->Tasks;
+						std::reverse(subtasks.begin(), subtasks.end());
+						for (const TaskRef& ref : subtasks) tasks.push_front(_domain.findTask(ref.Name));
+					}
+					else restore(plan, tasks, history);
+				}
+				else
+				{
+					PrimitiveTask* primitive = static_cast<PrimitiveTask*>(task);
+					if (isSatisfied(primitive, primitive->Preconditions, evalTask))
+					{
+						plan.push_back(primitive);
+						const std::vector<DefState>& states = _names[primitive].Effects;
+						for (size_t i = 0; i < states.size(); i++)
+						{
+							_states.wSetState(states[i], primitive->Effects[i].Fct, *primitive->Effects[i].Value);
+						}
+					}
+					else restore(plan, tasks, history);
+				}
+			}
+			_states.free();
+			return plan;
+		}
+
+		Domain& _domain;
+		WStates _states;
+		std::unordered_map<const BaseTask*, Names> _names;
+	};
+
+	// findPlan by the compiled domain and by the lookups by name (see NamePlanner), the best of 3 runs
+	template <class T, typename... Args>
+	bool planLookups(const char* name, int iterations, Args... args)
+	{
+		typedef std::chrono::steady_clock clock;
+		BenchOptions options;
+		Bench<T> sample(args...);
+		sample.load(name, options);
+		NamePlanner byName(sample.domain());
+		std::vector<BaseTask*> plan = sample.findPlan();
+		bool same = !plan.empty() && byName.findPlan() == plan;
+		double compiled = 0;
+		double named = 0;
+		for (int run = 0; run < 3; run++)
+		{
+			clock::time_point t = clock::now();
+			for (int i = 0; i < iterations; i++) same = same && sample.findPlan().size() == plan.size();
+			double c = std::chrono::duration<double, std::micro>(clock::now() - t).count() / iterations;
+			t = clock::now();
+			for (int i = 0; i < iterations; i++) same = same && byName.findPlan().size() == plan.size();
+			double n = std::chrono::duration<double, std::micro>(clock::now() - t).count() / iterations;
+			compiled = run == 0 ? c : std::min(compiled, c);
+			named = run == 0 ? n : std::min(named, n);
+		}
+		printf("%-24s %10zu %14.2f %14.2f %10.1f\n", name, plan.size(), named, compiled, named / compiled);
+		return same && compiled < named;
+	}
+
+	// the subtasks of the methods and the states of the preconditions of the synthetic domain, looked up by name
+	// (findTask scans the tasks, stateId searches the name tables) and by the identifiers resolved by compile
+	bool lookups(const BenchOptions& options)
+	{
+		typedef std::chrono::steady_clock clock;
+		Bench<synthetic_domain> sample(500);
+		sample.load("synthetic", options);
+		Domain& domain = sample.domain();
+		std::vector<const TaskRef*> subtasks;
+		std::vector<const DefState*> states;
+		for (BaseTask* task : domain.TasksById)
+		{
+			if (task->Kind != TASK_COMPOUND) continue;
+			for (Method& method : static_cast<CompoundTask*>(task)->Methods)
+			{
+				for (const TaskRef& ref : method.Tasks) subtasks.push_back(&ref);
+				for (const Precondition& pre : method.Preconditions) states.push_back(&pre.Condition);
+			}
+		}
+
+		bool same = true;
+		for (const TaskRef* ref : subtasks) same = same && domain.findTask(ref->Name) == domain.findTask(ref->TaskId);
+		for (const DefState* state : states) same = same && domain.stateId(state->Group, state->State) == state->Id;
+
+		// each lookup by name adds what the same lookup by identifier subtracts : the sum keeps them from being
+		// optimized out, and is 0 once they all agree
+		const int iterations = std::max(1, options.Iterations / 10);
+		size_t sum = 0;
+		clock::time_point t = clock::now();
+		for (int i = 0; i < iterations; i++)
+			for (const TaskRef* ref : subtasks) sum += (size_t)domain.findTask(ref->Name)->Id;
+		double taskByName = std::chrono::duration<double, std::nano>(clock::now() - t).count();
+		t = clock::now();
+		for (int i = 0; i < iterations; i++)
+			for (const TaskRef* ref : subtasks) sum -= (size_t)domain.findTask(ref->TaskId)->Id;
+		double taskById = std::chrono::duration<double, std::nano>(clock::now() - t).count();
+		t = clock::now();
+		for (int i = 0; i < iterations; i++)
+			for (const DefState* state : states) sum += (size_t)domain.WorldStates.wState(domain.stateId(state->Group, state->State)).L;
+		double stateByName = std::chrono::duration<double, std::nano>(clock::now() - t).count();
+		t = clock::now();
+		for (int i = 0; i < iterations; i++)
+			for (const DefState* state : states) sum -= (size_t)domain.WorldStates.wState(state->Id).L;
+		double stateById = std::chrono::duration<double, std::nano>(clock::now() - t).count();
+
+		double tasks = (double)iterations * subtasks.size();
+		double reads = (double)iterations * states.size();
+		printf("%-24s %10s %14s %14s %10s\n", "lookups", "count", "by name ns", "by id ns", "speedup");
+		printf("%-24s %10zu %14.2f %14.2f %10.1f\n", "subtasks (findTask)", subtasks.size(), taskByName / tasks, taskById / tasks, taskByName / taskById);
+		printf("%-24s %10zu %14.2f %14.2f %10.1f\n", "precondition states", states.size(), stateByName / reads, stateById / reads, stateByName / stateById);
+		same = same && sum == 0;
+		bool faster = taskById < taskByName && stateById < stateByName;
+		printf("same tasks and states : %s, identifiers faster : %s\n", same ? "yes" : "NO", faster ? "yes" : "NO");
+
+		printf("\n%-24s %10s %14s %14s %10s\n", "findPlan", "steps", "by name us", "compiled us", "speedup");
+		bool plans = planLookups<simple_travel>("simple_travel", iterations);
+		plans = planLookups<synthetic_domain>("synthetic_domain 500", iterations, 500) && plans;
+		printf("same plans and compiled faster : %s\n", plans ? "yes" : "NO");
+		return same && faster && plans;
+	}
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--record")) options.Record = true;
+		else if (!strcmp(argv[i], "--cache")) options.Cache = true;
+		else if (!strcmp(argv[i], "--speculation") && i + 1 < argc) options.Speculation = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) options.Iterations = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--operators") && i + 1 < argc) options.Operators = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--stress")) options.Stress = true;
+		else if (!strcmp(argv[i], "--planners") && i + 1 < argc) options.Planners = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--lookups")) options.Lookups = true;
+		else if (!strcmp(argv[i], "--snapshots")) options.Snapshots = true;
+		else if (!strcmp(argv[i], "--deep")) options.Deep = true;
+		else if (!strcmp(argv[i], "--methods") && i + 1 < argc) options.Methods = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--randomized") && i + 1 < argc) options.Randomized = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--failing")) options.Failing = true;
+		else if (!strcmp(argv[i], "--preconditions")) options.Preconditions = true;
+		else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) options.Seconds = std::max(1, atoi(argv[++i]));
+		else options.Golden = argv[i];
+	}
+
+	if (options.Operators > 0)
+	{
+		if (options.Stress)
+		{
+			return stress(options.Operators, options.Seconds) ? 0 : 1;
+		}
+		printf("%-24s %8s %12s %12s %12s %10s %14s\n", "operators", "agents", "operations", "polls", "steps", "cpu s", "cpu us/op");
+		auto report = [&](const char* name, const SimulationResult& result)
+		{
+			printf("%-24s %8d %12ld %12ld %12ld %10.2f %14.1f\n", name, options.Operators, result.Operations, result.Polls,
+				result.Steps, result.Cpu, result.Operations ? result.Cpu * 1e6 / result.Operations : 0.0);
+			return result.Operations ? result.Cpu / result.Operations : 0.0;
+		};
+		// the polled operations need short cycles, the asynchronous ones step the planner when they complete
+		double polled = report("polled, steps 10 ms", simulate(options.Operators, options.Seconds, false, 10));
+		report("polled, steps 1 s", simulate(options.Operators, options.Seconds, false, 1000));
+		SimulationResult async = simulate(options.Operators, options.Seconds, true, 10);
+		double event = report("async, steps 10 ms", async);
+		SimulationResult sensing = simulate(options.Operators, options.Seconds, true, 10, 50);
+		report("async, sensors 50 ms", sensing);
+		// a few steps by operation : its completion ends the plan, the next plan starts the next operation
+		bool idle = async.Steps <= 3 * (async.Operations + options.Operators);
+		// operations of 300 ms on average : 6 sensor updates each, at least 1 for the shortest
+		bool sensors = sensing.Steps >= async.Steps + sensing.Operations;
+		printf("async agents idle while their operations run : %s, cheaper than polled : %s, sensors updated : %s\n",
+			idle ? "yes" : "NO", event < polled ? "yes" : "NO", sensors ? "yes" : "NO");
+		return idle && event < polled && sensors ? 0 : 1;
+	}
+
+	if (options.Planners > 0)
+	{
+		ScaleResult result = scale(options.Planners, options.Seconds);
+		size_t workers = Scheduler::instance().threadCount();
+		auto percentile = [&](size_t p) { return result.Latencies.empty() ? 0.0 : result.Latencies[std::min(result.Latencies.size() - 1, result.Latencies.size() * p / 100)]; };
+		printf("%8s %8s %8s %10s %10s %10s %10s %10s\n", "planners", "threads", "workers", "cpu s", "alerts", "answered", "p50 ms", "p99 ms");
+		printf("%8d %8d %8zu %10.2f %10ld %10ld %10.2f %10.2f\n", options.Planners, result.Threads, workers, result.Cpu,
+			result.Alerts, result.Answered, percentile(50), percentile(99));
+		// the main thread and the workers
+		bool threads = result.Threads < 0 || result.Threads <= (int)workers + 1;
+		bool gate = gateOpens();
+		printf("every alert answered : %s, threads independent of the planners : %s, plan found once a function value changed : %s\n",
+			result.Answered == result.Alerts ? "yes" : "NO", threads ? "yes" : "NO", gate ? "yes" : "NO");
+		return result.Answered == result.Alerts && threads && gate ? 0 : 1;
+	}
+
+	if (options.Lookups)
+	{
+		return lookups(options) ? 0 : 1;
+	}
+
+	if (options.Methods > 0)
+	{
+		return ordering(options) ? 0 : 1;
+	}
+
+	if (options.Preconditions)
+	{
+		const int iterations = options.Iterations;
+		std::vector<std::pair<std::string, EvaluationResult>> evaluations;
+		evaluations.push_back({ "simple_travel", evaluation<simple_travel>(iterations) });
+		evaluations.push_back({ "synthetic_domain 500", evaluation<synthetic_domain>(std::max(1, iterations / 10), 500) });
+		evaluations.push_back({ "layered_plan 32x10", evaluation<layered_plan>(iterations, 32, 10) });
+		evaluations.push_back({ "deep_search 8x4x5", evaluation<deep_search>(std::max(1, iterations / 10), 8, 4, 5) });
+		bool ok = true;
+		printf("%-24s %14s %10s %14s %14s %10s\n", "preconditions", "preconditions", "compiled", "compiled M/s", "generic M/s", "speedup");
+		for (auto& r : evaluations)
+		{
+			const EvaluationResult& result = r.second;
+			printf("%-24s %14zu %10zu %14.1f %14.1f %10.1f\n", r.first.c_str(), result.Preconditions, result.Compiled,
+				result.CompiledRate, result.GenericRate, result.CompiledRate / result.GenericRate);
+			// the preconditions on function values keep the generic comparison
+			ok = ok && result.Same && (result.Compiled == 0 || result.CompiledRate > result.GenericRate);
+		}
+		printf("same results, compiled instructions faster : %s\n", ok ? "yes" : "NO");
+		return ok ? 0 : 1;
+	}
+
+	if (options.Randomized > 0)
+	{
+		const int draws = options.Randomized;
+		std::vector<std::pair<std::string, RandomizedResult>> checks;
+		checks.push_back({ "synthetic_domain 500", randomized<synthetic_domain>(draws, 500) });
+		checks.push_back({ "wide_methods 256", randomized<wide_methods>(draws, 256) });
+		checks.push_back({ "layered_plan 8x4", randomized<layered_plan>(draws, 8, 4) });
+		checks.push_back({ "deep_search 8x4x5", randomized<deep_search>(draws, 8, 4, 5) });
+		checks.push_back({ "deep_chain 100x50", randomized<deep_chain>(draws, 100, 50) });
+		bool ok = true;
+		printf("%-24s %8s %10s %8s %12s %12s\n", "randomized", "plans", "different", "hits", "cached us", "uncached us");
+		for (auto& r : checks)
+		{
+			const RandomizedResult& result = r.second;
+			printf("%-24s %8ld %10ld %8zu %12.2f %12.2f\n", r.first.c_str(), result.Plans, result.Different, result.Hits,
+				result.Cached, result.Uncached);
+			ok = ok && result.Different == 0 && result.Hits > 0;
+		}
+		printf("cached and uncached plans are the same, the cache is used : %s\n", ok ? "yes" : "NO");
+		return ok ? 0 : 1;
+	}
+
+	if (options.Snapshots)
+	{
+		const int iterations = options.Iterations * 10;
+		std::vector<std::pair<std::string, SnapshotResult>> snapshots;
+		{
+			Bench<simple_travel> sample;
+			sample.load("travel", options);
+			snapshots.push_back({ "simple_travel", snapshot(sample, iterations) });
+		}
+		{
+			Bench<HTNTest> sample;
+			sample.load("trunk_thumper", options);
+			snapshots.push_back({ "trunk_thumper", snapshot(sample, iterations) });
+		}
+		{
+			Bench<synthetic_domain> sample(500);
+			sample.load("synthetic", options);
+			snapshots.push_back({ "synthetic_domain 500", snapshot(sample, iterations) });
+		}
+		bool ok = true;
+		printf("%-24s %8s %12s %12s %12s %12s %10s\n", "snapshot", "states", "tree ns", "tree allocs", "flat ns", "flat allocs", "speedup");
+		for (auto& r : snapshots)
+		{
+			const SnapshotResult& result = r.second;
+			printf("%-24s %8zu %12.1f %12.1f %12.1f %12.1f %10.1f\n", r.first.c_str(), result.States, result.TreeTime,
+				result.TreeAllocations, result.FlatTime, result.FlatAllocations, result.TreeTime / result.FlatTime);
+			ok = ok && result.FlatAllocations <= 1 && result.FlatTime < result.TreeTime;
+		}
+		// a copy of a hundred states is one allocation and one memcpy
+		ok = ok && snapshots.back().second.TreeTime >= 10 * snapshots.back().second.FlatTime;
+		printf("flat copies allocate once at most, and are 10 times faster on the synthetic domain : %s\n", ok ? "yes" : "NO");
+		return ok ? 0 : 1;
+	}
+
+	// scenario -> plan, the scenarios in the order of the file, and the comments before each one
+	std::map<std::string, std::string> golden;
+	std::vector<std::string> scenarios;
+	std::map<std::string, std::string> comments;
+	std::ifstream in(options.Golden);
+	std::string line;
+	std::string comment;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line[0] == '#')
+		{
+			comment += line + '\n';
+			continue;
+		}
+		size_t tab = line.find('\t');
+		if (tab == std::string::npos) continue;
+		scenarios.push_back(line.substr(0, tab));
+		golden[scenarios.back()] = line.substr(tab + 1);
+		comments[scenarios.back()] = comment;
+		comment.clear();
+	}
+	in.close();
+
+	if (options.Failing)
+	{
+		return failing(options, golden) ? 0 : 1;
+	}
+
+	std::vector<std::pair<std::string, BenchResult>> results;
+	auto scenario = [&](const std::string& name, BenchResult result)
+	{
+		results.push_back({ name, result });
+	};
+	const int iterations = options.Iterations;
+	if (options.Deep)
+	{
+		for (int levels : { 100, 400 })
+		{
+			Bench<deep_chain> sample(levels, 50);
+			sample.load("chain", options);
+			scenario("deep_chain " + std::to_string(levels) + "x50", sample.measure(std::max(1, iterations / 10), true));
+		}
+	}
+	else
+	{
+		{
+			// operators take a second : not run
+			Bench<simple_travel> sample;
+			sample.load("travel", options);
+			scenario("simple_travel", sample.measure(iterations, false));
+		}
+		{
+			Bench<synthetic_domain> sample(500);
+			sample.load("synthetic", options);
+			scenario("synthetic_domain 500", sample.measure(iterations, true));
+		}
+		{
+			Bench<wide_methods> sample(256);
+			sample.load("wide", options);
+			scenario("wide_methods 256", sample.measure(iterations, true));
+		}
+		for (int size : { 8, 32 })
+		{
+			Bench<layered_plan> sample(size, size / 4 + 2);
+			sample.load("layered", options);
+			scenario("layered_plan " + std::to_string(size) + "x" + std::to_string(size / 4 + 2), sample.measure(iterations, true));
+		}
+		for (int goal : { 0, 3, -1 })
+		{
+			// goal 0 is the branch tried last, -1 : no plan
+			Bench<deep_search> sample(8, 4, 5);
+			sample.load("deep", options);
+			sample.domain().WorldStates.wSetState("WsSearch", "goal", (long)goal);
+			scenario("deep_search 8x4x5 goal " + std::to_string(goal), sample.measure(std::max(1, iterations / 50), true));
+		}
+	}
+
+	int failures = 0;
+	printf("%-28s %6s %12s %10s %12s %12s %10s  %s\n", "scenario", "steps", "plans/s", "p99 us", "allocs/plan", "backtracks", "run us", "golden");
+	for (auto& r : results)
+	{
+		const BenchResult& result = r.second;
+		auto it = golden.find(r.first);
+		const char* check = it == golden.end() ? (options.Record ? "recorded" : "missing") : it->second == result.Plan ? "ok" : "DIFFERENT";
+		failures += (it == golden.end() && !options.Record) || (it != golden.end() && it->second != result.Plan);
+		printf("%-28s %6zu %12.0f %10.2f %12.1f %12.1f %10.2f  %s\n", r.first.c_str(), result.Steps, result.PlansPerSecond,
+			result.P99, result.Allocations, result.Backtracks, result.RunTime, check);
+	}
+
+	if (options.Deep)
+	{
+		// a snapshot of the world state, the plan and the task stack by level would allocate several times by level
+		const BenchResult& deepest = results.back().second;
+		bool logged = deepest.Allocations < 400;
+		printf("less than one allocation per level : %s\n", logged ? "yes" : "NO");
+		failures += !logged;
+	}
+
+	if (options.Record)
+	{
+		// the recorded plans are kept : a plan which changes on purpose is edited by hand, with its reason
+		for (auto& r : results)
+		{
+			if (golden.count(r.first)) continue;
+			scenarios.push_back(r.first);
+			golden[r.first] = r.second.Plan;
+		}
+		std::ofstream out(options.Golden);
+		for (const std::string& name : scenarios)
+		{
+			out << comments[name] << name << '\t' << golden[name] << '\n';
+		}
+	}
+	return failures ? 1 : 0;
+}
+
+#endif
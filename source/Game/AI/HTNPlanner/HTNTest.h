@@ -34,6 +34,8 @@
 #include "HTNPlanner.h"
 #include "Operator.h"
 #include "Variant.h"
+#include <condition_variable>
+#include <queue>
 
 namespace HTN
 {
@@ -69,6 +71,187 @@ namespace HTN
 	
 
 
+	// benchmark of the search : every method of the root task leads to a tree of alternatives
+	// (fanout^depth leaves) which all fail, but the one of the goal branch
+	class deep_search : public HTNPlanner
+	{
+	public:
+		deep_search(int branches = 8, int fanout = 4, int depth = 7)
+			: Branches(branches), Fanout(fanout), Depth(depth) {}
+
+		virtual void initWorldStatesHandler(WorldStateMap& worldStates);
+		virtual void initDomainHandler(Domain& domain);
+		virtual void initVariables(Domain& domain) {}
+		virtual void sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime) {}
+
+		int Branches;
+		int Fanout;
+		int Depth;
+	};
+
+
+
+	// benchmark of the plan length : Depth levels, each one with Branching methods of which only
+	// the one tried last is applicable; the plan has one step per level
+	class layered_plan : public HTNPlanner
+	{
+	public:
+		layered_plan(int depth = 8, int branching = 4)
+			: Depth(depth), Branching(branching) {}
+
+		virtual void initWorldStatesHandler(WorldStateMap& worldStates);
+		virtual void initDomainHandler(Domain& domain);
+		virtual void initVariables(Domain& domain) {}
+		virtual void sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime) {}
+
+		int Depth;
+		int Branching;
+	};
+
+
+
+	// benchmark of the domain size : Tasks tasks drawn from a fixed seed over 10 groups of 10 long states.
+	// Half of them are primitives, the others compound tasks whose methods call primitives and deeper compound tasks
+	class synthetic_domain : public HTNPlanner
+	{
+	public:
+		synthetic_domain(int tasks = 500) : Tasks(tasks) {}
+
+		virtual void initWorldStatesHandler(WorldStateMap& worldStates);
+		virtual void initDomainHandler(Domain& domain);
+		virtual void initVariables(Domain& domain) {}
+		virtual void sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime) {}
+
+		int Tasks;
+	};
+
+
+
+	// benchmark of the backtracking depth : a chain of Levels compound tasks, each one calling the next one before
+	// its step, down to a task whose Failing methods all backtrack before the one tried last applies
+	class deep_chain : public HTNPlanner
+	{
+	public:
+		deep_chain(int levels = 400, int failing = 50) : Levels(levels), Failing(failing) {}
+
+		virtual void initWorldStatesHandler(WorldStateMap& worldStates);
+		virtual void initDomainHandler(Domain& domain);
+		virtual void initVariables(Domain& domain) {}
+		virtual void sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime) {}
+
+		int Levels;
+		int Failing;
+	};
+
+
+
+	// benchmark of the method ordering : one compound task with Methods methods declared out of cost order,
+	// of which only the one with the lowest cost (tried last) applies
+	class wide_methods : public HTNPlanner
+	{
+	public:
+		wide_methods(int methods = 256) : Methods(methods) {}
+
+		virtual void initWorldStatesHandler(WorldStateMap& worldStates);
+		virtual void initDomainHandler(Domain& domain);
+		virtual void initVariables(Domain& domain) {}
+		virtual void sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime) {}
+
+		int Methods;
+	};
+
+
+
+	// completes asynchronous operations when they are due, from its own thread (as a game system would)
+	class OperationTimers
+	{
+	public:
+		static OperationTimers& instance();
+
+		OperationTimers();
+		~OperationTimers();
+		// complete the operation with success in delay_ms
+		void add(const OperationHandlePtr& handle, int delay_ms);
+
+	protected:
+		typedef std::chrono::steady_clock clock;
+		typedef std::pair<clock::time_point, OperationHandlePtr> Timer;
+		struct Later
+		{
+			bool operator()(const Timer& a, const Timer& b) const { return a.first > b.first; }
+		};
+
+		void run();
+
+		std::mutex _mutex;
+		std::condition_variable _signal;
+		std::priority_queue<Timer, std::vector<Timer>, Later> _timers;
+		bool _stop = false;
+		std::thread _thread;
+	};
+
+
+
+	// benchmark of the runner : the plan is one operation which lasts Duration ms, then the plan
+	// is searched again. The operation is polled by the runner, or asynchronous (see OperationTimers)
+	class long_operation : public HTNPlanner
+	{
+	public:
+		long_operation(bool async = true, int duration_ms = 100)
+			: Async(async), Duration(duration_ms) {}
+
+		virtual void initWorldStatesHandler(WorldStateMap& worldStates);
+		virtual void initDomainHandler(Domain& domain);
+		virtual void initVariables(Domain& domain) {}
+		virtual void sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime) { Steps++; }
+		OperationStatus Work(OperationStatus status, WStates& states);
+		OperationHandlePtr StartWork(WStates& states);
+		// number of operations done (once stopped)
+		long done();
+
+		bool Async;
+		int Duration;
+		// number of calls of the polled operation
+		long Polls = 0;
+		// number of steps of the planner (each one updates the sensors), and of asynchronous operations started
+		long Steps = 0;
+		long Started = 0;
+
+	protected:
+		// end of the polled operation
+		std::chrono::steady_clock::time_point _due;
+	};
+
+
+
+	// benchmark of the scheduler : the plan answers an alert seen by the sensors, if the gate is open.
+	// The gate is a function value : opening it does not modify the world states
+	class reactive_agent : public HTNPlanner
+	{
+	public:
+		reactive_agent(bool gate = true) : Gate(gate) {}
+
+		virtual void initWorldStatesHandler(WorldStateMap& worldStates);
+		virtual void initDomainHandler(Domain& domain);
+		virtual void initVariables(Domain& domain) {}
+		virtual void sensorUpdate(WorldStateProperties& worldStates, const float elapsedTime);
+		// raise an alert and wake the planner up (from any thread, once the previous alert is answered)
+		void alert();
+
+		std::atomic<bool> Gate;
+		// number of alerts answered
+		std::atomic<long> Answered{ 0 };
+		// time from each alert to its answer in ms (read once stopped)
+		std::vector<double> Latencies;
+
+	protected:
+		std::atomic<bool> _alert{ false };
+		// time of the last alert, in steady clock ticks
+		std::atomic<long long> _alerted{ 0 };
+	};
+
+
+
 	struct HTNDemo
 	{
 		HTNDemo(const std::string& name)
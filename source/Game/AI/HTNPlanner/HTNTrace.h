@@ -36,7 +36,7 @@
 #if  defined NDEBUG
 #define HTNTrace( format, ... )
 #else
-#define HTNTrace(name, format, ... )   printf( "\n%4s %15s  -> " format, name.c_str(), __func__  ,   __VA_ARGS__ )
+#define HTNTrace(name, format, ... )   printf( "\n%4s %15s  -> " format, name.c_str(), __func__  ,   ##__VA_ARGS__ )
 
 #endif
 
@@ -45,7 +45,7 @@
 #if defined NDEBUG_USR
 #define HTNTrace( format, ... )
 #else
-#define HTNUsrTrace(name, format, ... )   printf( "\n%4s %15s  -> " format, name.c_str(), __func__  ,   __VA_ARGS__ )
+#define HTNUsrTrace(name, format, ... )   printf( "\n%4s %15s  -> " format, name.c_str(), __func__  ,   ##__VA_ARGS__ )
 
 #endif
  
\ No newline at end of file
@@ -44,8 +44,10 @@ namespace HTN
 	struct TaskRef
 	{
 		TaskRef(const std::string& name, std::initializer_list<std::string> args)
-			: Name(name), Args(args) {}
+			: Name(name), TaskId(-1), Args(args) {}
 		std::string Name;
+		// identifier of the task, resolved by Domain::compile
+		int TaskId;
 		std::initializer_list<std::string> Args;
 	};
 
@@ -55,7 +57,7 @@ namespace HTN
 	struct Method : public BaseTask
 	{
 		
-		Method(const std::string& name, Domain* d, CompoundTask* ts, float cost) : BaseTask(d, name, {},cost),Task(ts) {}
+		Method(const std::string& name, Domain* d, CompoundTask* ts, float cost) : BaseTask(d, name, {},cost, TASK_METHOD),Task(ts) {}
 		// free memory
 		void free();
 		// add a pre-condition used by the planer to test if this task can be done
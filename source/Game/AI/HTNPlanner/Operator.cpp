@@ -42,6 +42,12 @@ Operator::Operator(BaseAction action)
 
 }
 
+Operator::Operator(AsyncAction start)
+	: Start(start)
+{
+
+}
+
 // print the operator
 void Operator::dump(int level)
 {
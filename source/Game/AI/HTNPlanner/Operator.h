@@ -33,6 +33,7 @@
 
 
 #include "WorldStateProperties.h"
+#include "CompletionQueue.h"
 #include <functional>
 
 namespace HTN
@@ -56,6 +57,10 @@ namespace HTN
 	// an action
 	typedef std::function<OperationStatus(OperationStatus status,WStates& states)> BaseAction;
 
+	// an asynchronous action : it starts the operation and returns its handle (nullptr : failure).
+	// It is called once, the runner then waits for OperationHandle::complete
+	typedef std::function<OperationHandlePtr(WStates& states)> AsyncAction;
+
 
 	// The operator represents an atomic action that a NPC can do
 	struct Operator
@@ -63,11 +68,15 @@ namespace HTN
 		Operator() {}
 		// construct an operation
 		Operator(BaseAction action);
+		// construct an asynchronous operation
+		Operator(AsyncAction start);
 		// print the operator
 		void dump(int level);
 
 		// function called when the plan is executed
 		BaseAction Action;
+		// function called when the plan is executed, for an asynchronous operation
+		AsyncAction Start;
 	 
 	};
 
@@ -32,6 +32,10 @@
 #include "Planner.h"
 #include "Domain.h"
 #include "HTNTrace.h"
+#include "Scheduler.h"
+#include <mutex>
+#include <memory>
+#include <functional>
 
 // ----------------------------------------------------------------------------
 
@@ -42,7 +46,7 @@ using namespace HTN;
 
 
 Planner::Planner(Domain& d)
-	: domain(d)
+	: _cacheSearches(0), _cacheLookups(0), _cacheHits(0), _cacheUsed(true), _speculation(0), _backtracks(0), _cancel(nullptr), domain(d)
 {
 
 }
@@ -60,38 +64,75 @@ Planner::~Planner()
 std::vector<BaseTask*> Planner::findPlan()
 {
 	std::vector<BaseTask*> finalPlan;
-	std::queue<BacktrackPoint> decomposition_history;
-
 
 	// return empty plan if there is no tasks
 	if (domain.Tasks.empty())
 		return finalPlan;
 
-	// search for the best task
-
-	// sort tasks by cost	 
-	std::sort(domain.Tasks.begin(), domain.Tasks.end(),
-		[](const BaseTask* a, const BaseTask*  b) -> bool
+	// names are resolved to identifiers once
+	domain.compile();
+	// sorted again only if a cost changed
+	if (!domain.isSorted())
+		domain.sort();
+
+	// plan already found for the same states and variables
+	// (the whole search is cached, under the root -1)
+	bool cacheable = domain.Cache && domain.Cacheable && useCache();
+	size_t variables = cacheable ? domain.EvalTask.hash() : 0;
+	size_t key = cacheable ? PlanCache::hash(domain.Version, -1, domain.WorldStates.Values, variables) : 0;
+	std::vector<int> ids;
+	_cacheLookups += cacheable;
+	if (cacheable && domain.Cache->find(key, domain.Version, -1, domain.WorldStates.Values, variables, ids))
 	{
-		return a->Cost < b->Cost;
-	});
+		_cacheHits++;
+		for (int id : ids)
+		{
+			finalPlan.push_back(domain.findTask(id));
+		}
+		HTNTrace(domain.Name, "Plan found in cache");
+		return finalPlan;
+	}
 
+	// search for the best task, by increasing cost
 	for (BaseTask* task : domain.Tasks)
 	{
-		CompoundTask* compoundTask = dynamic_cast<CompoundTask*>(task);
-		if (compoundTask)
+		if (task->Kind == TASK_COMPOUND)
 		{
 			
 			finalPlan = findPlan(task);
 			if (!finalPlan.empty())
-				return finalPlan;
+				break;
+		}
+	}
+
+	if (cacheable)
+	{
+		for (BaseTask* t : finalPlan)
+		{
+			ids.push_back(t->Id);
 		}
+		domain.Cache->insert(key, domain.Version, -1, domain.WorldStates.Values, variables, ids);
 	}
 	return finalPlan;
 }
 
 
 
+bool Planner::useCache()
+{
+	// every 256 searches, the cache is kept if at least one plan in 8 was found in it,
+	// else it is only tried by the first search of the next period
+	if (_cacheSearches++ % 256 == 0)
+	{
+		_cacheUsed = _cacheLookups == 0 || _cacheHits * 8 >= _cacheLookups;
+		_cacheLookups = _cacheHits = 0;
+		return true;
+	}
+	return _cacheUsed;
+}
+
+// ----------------------------------------------------------------------------
+
 std::vector<BaseTask*> Planner::findPlan(BaseTask* task)
 {
 	std::vector<BaseTask*> finalPlan;
@@ -99,143 +140,325 @@ std::vector<BaseTask*> Planner::findPlan(BaseTask* task)
 	// copy world state
 	WStates WorkingWS(domain);
 	WorkingWS.clone(domain.WorldStates);
+	// effects record the previous values, so that backtracking can undo them
+	StateTrail.clear();
+	WorkingWS.setTrail(&StateTrail);
 	EvalStack WorkingEvalTask = domain.EvalTask;
 	try
 	{
 		// clear stack
 		clearStack();
-		TasksToProcess.push_front(task);
+		pushTask(task);
 		 
 		HTNTrace(domain.Name,"-------------------------------------------------");
 		HTNTrace(domain.Name, "FIND PLAN for Compound : %s ",task->Name.c_str());
 		HTNTrace(domain.Name, "-------------------------------------------------");
 
 		// process
-		while (!TasksToProcess.empty())
+		search(finalPlan, WorkingWS, WorkingEvalTask, decomposition_history, 0);
+	}
+	catch (const std::domain_error& e)
+	{
+		WorkingWS.free();
+		clearBacktrackStack(decomposition_history);
+		HTNTrace(domain.Name, "Catch domain_error : '%s'", e.what());
+		throw e;
+	}
+	WorkingWS.free();
+	clearBacktrackStack(decomposition_history);
+	return finalPlan;
+}
+
+// ----------------------------------------------------------------------------
+
+bool Planner::search(std::vector<BaseTask*>& finalPlan, WStates& WorkingWS, EvalStack& WorkingEvalTask, backtrack_stack& decomposition_history, size_t floor)
+{
+	while (!TasksToProcess.empty())
+	{
+		if (_cancel && _cancel->load(std::memory_order_relaxed))
+			return false;
+		BaseTask* currentTask = popTask();
+		switch (currentTask->Kind)
 		{
-			BaseTask* currentTask = TasksToProcess.front();
-			TasksToProcess.pop_front();
-			CompoundTask* compoundTask = dynamic_cast<CompoundTask*>(currentTask);
-			if (compoundTask)
+		case TASK_COMPOUND:
+		{
+			// searching through its methods looking for the first set of conditions that are valid.
+			// (methods are sorted by cost once, see Domain::sort)
+			CompoundTask* compoundTask = static_cast<CompoundTask*>(currentTask);
+			// while the plan is empty, a method which is not satisfied is recorded then restored at once :
+			// it is not pushed when the result of its preconditions is already known
+			// (the memo is not shared with the speculative branches)
+			const std::vector<bool>* satisfied = nullptr;
+			if (finalPlan.empty() && compoundTask->Memoizable && !_cancel)
+			{
+				satisfied = satisfiedMethods(compoundTask, WorkingEvalTask, WorkingWS);
+			}
+			// only the methods tried before the first satisfied one (the last ones pushed) are skipped : the methods
+			// left below it are popped once the plan has steps, which ends the plan
+			size_t tried = compoundTask->SortedMethods.size();
+			while (satisfied && tried > 0 && !(*satisfied)[tried - 1])
+			{
+				tried--;
+			}
+			for (size_t m = 0; m < tried; m++)
+			{
+				// add to task stack
+				pushTask(compoundTask->SortedMethods[m]);
+			}
+			// the methods are only tried while the plan is empty
+			if (_speculation > 1 && finalPlan.empty() && speculate(finalPlan, WorkingWS, WorkingEvalTask))
+				return true;
+			break;
+		}
+		case TASK_METHOD:
+		{
+			Method* methodTask = static_cast<Method*>(currentTask);
+			if (!finalPlan.empty())
 			{
-					// searching through its methods looking for the first set of conditions that are valid.
-
-					// sort Methods by cost	 
-				std::sort(compoundTask->Methods.begin(), compoundTask->Methods.end(),
-					[](const Method & a, const Method & b) -> bool
-				{
-					return a.Cost < b.Cost;
-				});
-
-			 
-				for (Method& m : compoundTask->Methods)
-				{
-					// add to task stack
-					TasksToProcess.push_front(&m);
-				}
+				// we have already a plan computed for the next mthod
+				// return it :
+				return true;
+			}
+
+			// register this decomposition point so we can backtrack later 
+			// The planner can backtrack either when a compound task cannot be decomposed or when a primitives conditions arent satisfied
+			recordDecompositionOfTask(methodTask, finalPlan, decomposition_history);
+			HTNTrace(domain.Name, "-------------------------------------------------");
+			HTNTrace(domain.Name, "Trying method named : '%s'", methodTask->Name.c_str());
+			bool satisfied = methodTask->isSatisfied(WorkingEvalTask, WorkingWS);
+			if (satisfied)
+			{
+				HTNTrace(domain.Name, "\t'%s' is satisfied ", methodTask->Name.c_str());
+
+					// If a method is found, that methods subtasks are added on to the TaskToProcess stack.
+				decompose(methodTask);
+
 			}
 			else
 			{
-				Method* methodTask = dynamic_cast<Method*>(currentTask);
-				
+				HTNTrace(domain.Name, "\t'%s' is not satisfied ", currentTask->Name.c_str());
+
+				// If a valid method is not found, the planners state is rolled back to the last compound 
+				// task that was decomposed.
+				restoreToLastDecomposedTask(finalPlan, WorkingWS, decomposition_history);
+				if (decomposition_history.size() < floor)
+					return false;
+			}
+			break;
+		}
+		default:
+		{
+			PrimitiveTask* pt = static_cast<PrimitiveTask*>(currentTask);
+			HTNTrace(domain.Name, "Processing of PrimitiveTask '%s'", pt->Name.c_str());
+			//pt->Arg
+			if (pt->isSatisfied(WorkingEvalTask, WorkingWS))
+			{
+				HTNTrace(domain.Name, "'%s' is satisfied ", pt->Name.c_str());
+
+				// the task is added to the final plan and its effects are
+				//	applied to the working world state
+				finalPlan.push_back(pt);
+				HTNTrace(domain.Name, "'%s' apply effects ", pt->Name.c_str());
+
+				pt->applyEffects(WorkingEvalTask, WorkingWS);
+			}
+			else
+			{
+				HTNTrace(domain.Name, "'%s' is not satisfied ", pt->Name.c_str());
+
 				
+				// If a valid method is not found, the planners state is rolled back to the last compound 
+				// task that was decomposed.
+				restoreToLastDecomposedTask(finalPlan, WorkingWS, decomposition_history);
+				if (decomposition_history.size() < floor)
+					return false;
 
-				if (methodTask)
-				{
-					if (!finalPlan.empty())
-					{
-						// we have already a plan computed for the next mthod
-						// return it :
-						goto tagOut; // back to 1980! lol
-					}
-
-					// register this decomposition point so we can backtrack later 
-					// The planner can backtrack either when a compound task cannot be decomposed or when a primitives conditions arent satisfied
-					recordDecompositionOfTask(methodTask, finalPlan, WorkingWS, decomposition_history);
-					HTNTrace(domain.Name, "-------------------------------------------------");
-					HTNTrace(domain.Name, "Trying method named : '%s'", methodTask->Name.c_str());
-					bool satisfied = methodTask->isSatisfied(WorkingEvalTask, WorkingWS);
-					if (satisfied)
-					{
-						HTNTrace(domain.Name, "\t'%s' is satisfied ", methodTask->Name.c_str());
-
-							// If a method is found, that methods subtasks are added on to the TaskToProcess stack.
-						decompose(methodTask);
-
-					}
-					else
-					{
-						HTNTrace(domain.Name, "\t'%s' is not satisfied ", currentTask->Name.c_str());
-
-						// If a valid method is not found, the planners state is rolled back to the last compound 
-						// task that was decomposed.
-						restoreToLastDecomposedTask(finalPlan, WorkingWS, decomposition_history);
-					}
-				}
-
-				else
-				{
-					PrimitiveTask* pt = static_cast<PrimitiveTask*>(currentTask);
-					HTNTrace(domain.Name, "Processing of PrimitiveTask '%s'", pt->Name.c_str());
-					//pt->Arg
-					if (pt->isSatisfied(WorkingEvalTask, WorkingWS))
-					{
-						HTNTrace(domain.Name, "'%s' is satisfied ", pt->Name.c_str());
-
-						// the task is added to the final plan and its effects are
-						//	applied to the working world state
-						finalPlan.push_back(pt);
-						HTNTrace(domain.Name, "'%s' apply effects ", pt->Name.c_str());
-
-						pt->applyEffects(WorkingEvalTask, WorkingWS);
-					}
-					else
-					{
-						HTNTrace(domain.Name, "'%s' is not satisfied ", pt->Name.c_str());
-
-						
-						// If a valid method is not found, the planners state is rolled back to the last compound 
-						// task that was decomposed.
-						restoreToLastDecomposedTask(finalPlan, WorkingWS, decomposition_history);
-
-					}
-				}
 			}
+			break;
+		}
 		}
 	}
-	catch (const std::domain_error& e)
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+	// a method tried on its own copy of the planner state
+	struct Branch
 	{
-		WorkingWS.free();
-		clearBacktrackStack(decomposition_history);
-		HTNTrace(domain.Name, "Catch domain_error : '%s'", e.what());
-		throw e;
+		Branch(Domain& domain, const EvalStack& evalTask) : Search(domain), WorkingWS(domain), WorkingEvalTask(evalTask) {}
+
+		Planner Search;
+		WStates WorkingWS;
+		EvalStack WorkingEvalTask;
+		std::vector<BaseTask*> FinalPlan;
+		// true if the search ended in this branch (with a plan, an empty plan or an error)
+		bool Done = false;
+		bool Failed = false;
+		std::string Error;
+	};
+}
+
+bool Planner::speculate(std::vector<BaseTask*>& finalPlan, WStates& WorkingWS, EvalStack& WorkingEvalTask)
+{
+	// the first applicable methods, in the order they would be tried (top of the stack first).
+	// The methods before them are not satisfied : tried and backtracked at once
+	std::vector<size_t> depths;
+	for (size_t depth = 0; depth < TasksToProcess.size() && depths.size() < _speculation; depth++)
+	{
+		BaseTask* task = TasksToProcess[depth];
+		if (task->Kind != TASK_METHOD) break;
+		bool applicable = true;
+		try
+		{
+			applicable = static_cast<Method*>(task)->isSatisfied(WorkingEvalTask, WorkingWS);
+		}
+		catch (const std::domain_error&)
+		{
+			// thrown again by its branch
+		}
+		if (applicable) depths.push_back(depth);
 	}
-	tagOut:
-	WorkingWS.free();
-	clearBacktrackStack(decomposition_history);
-	return finalPlan;
+	if (depths.size() < 2)
+		return false;
+
+	// each branch starts as the sequential search when its method is popped, all the previous ones failed
+	std::atomic<bool> cancel(false);
+	std::mutex lock;
+	std::vector<std::unique_ptr<Branch>> branches;
+	std::vector<std::function<void()>> jobs;
+	for (size_t b = 0; b < depths.size(); b++)
+	{
+		branches.emplace_back(new Branch(domain, WorkingEvalTask));
+		Branch* branch = branches.back().get();
+		branch->Search._cancel = &cancel;
+		branch->Search.TasksToProcess.assign(TasksToProcess.begin() + depths[b], TasksToProcess.end());
+		branch->WorkingWS.clone(WorkingWS);
+		branch->WorkingWS.setTrail(&branch->Search.StateTrail);
+		jobs.push_back([&, branch]()
+		{
+			if (cancel.load()) return;
+			backtrack_stack history;
+			bool done = false;
+			try
+			{
+				done = branch->Search.search(branch->FinalPlan, branch->WorkingWS, branch->WorkingEvalTask, history, 1);
+			}
+			catch (const std::domain_error& e)
+			{
+				done = true;
+				branch->Error = e.what();
+			}
+			std::lock_guard<std::mutex> guard(lock);
+			branch->Done = done && !cancel.load();
+			branch->Failed = !done;
+			// the result is known when a branch is done after failed ones : the next ones are useless
+			for (std::unique_ptr<Branch>& previous : branches)
+			{
+				if (previous->Done) cancel = true;
+				if (!previous->Failed) break;
+			}
+		});
+	}
+	Scheduler::instance().parallel(jobs);
+	for (std::unique_ptr<Branch>& branch : branches)
+	{
+		_backtracks += branch->Search._backtracks;
+	}
+
+	// first success in method order
+	for (std::unique_ptr<Branch>& branch : branches)
+	{
+		if (branch->Failed) continue;
+		if (!branch->Error.empty())
+		{
+			throw std::domain_error(branch->Error);
+		}
+		finalPlan = branch->FinalPlan;
+		return true;
+	}
+
+	// all failed : the sequential search goes on with the next method
+	for (size_t depth = 0; depth <= depths.back(); depth++)
+	{
+		popTask();
+	}
+	return false;
 }
 
 // ----------------------------------------------------------------------------
  
 
 
+const std::vector<bool>* Planner::satisfiedMethods(CompoundTask* task, EvalStack& evalTask, WStates& WorkingWS)
+{
+	// seldom reused (states always new) : not worth the copies
+	if (task->MemoMisses >= 64 && task->MemoHits * 4 < task->MemoMisses)
+		return nullptr;
+	size_t h = WorkingWS.hash(task->ReadStates);
+	auto it = task->Memo.find(h);
+	if (it != task->Memo.end())
+	{
+		const std::vector<StateData>& values = it->second.Values;
+		bool same = true;
+		for (size_t i = 0; i < values.size() && same; i++)
+		{
+			same = WorldStateProperties::equals(values[i], WorkingWS.Values[task->ReadStates[i]]);
+		}
+		if (same)
+		{
+			task->MemoHits++;
+			return &it->second.Satisfied;
+		}
+	}
+	task->MemoMisses++;
+	// bounded : a new entry replaces all of them once full
+	if (task->Memo.size() >= 256)
+	{
+		task->Memo.clear();
+	}
+	CompoundTask::MethodMemo& memo = task->Memo[h];
+	memo.Values.clear();
+	for (int id : task->ReadStates)
+	{
+		memo.Values.push_back(WorkingWS.Values[id]);
+	}
+	memo.Satisfied.clear();
+	for (Method* method : task->SortedMethods)
+	{
+		bool satisfied = true;
+		try
+		{
+			satisfied = method->isSatisfied(evalTask, WorkingWS);
+		}
+		catch (const std::domain_error&)
+		{
+			// reported when the method is tried
+		}
+		memo.Satisfied.push_back(satisfied);
+	}
+	return &memo.Satisfied;
+}
+
+// ----------------------------------------------------------------------------
+ 
+
 void Planner::decompose(Method* currentMethod)
 {
 	// adding  methods subtasks to the TaskToProcess stack
-	std::vector<TaskRef> cptasks = currentMethod->Tasks;
-	std::reverse(cptasks.begin(), cptasks.end());
-	for (const TaskRef& task : cptasks)
+	for (auto task = currentMethod->Tasks.rbegin(); task != currentMethod->Tasks.rend(); ++task)
 	{
-		BaseTask* basetask = domain.findTask(task.Name);
+		BaseTask* basetask = domain.findTask(task->TaskId);
 		if (basetask)
 		{
 			// add to task stack
-			TasksToProcess.push_front(basetask);
+			pushTask(basetask);
 		}
 		else
 		{
-			throw std::domain_error("Planner::decompose : subtask does not exist in the domain : " + task.Name);
+			throw std::domain_error("Planner::decompose : subtask does not exist in the domain : " + task->Name);
 		}
 	}
 }
@@ -243,11 +466,9 @@ void Planner::decompose(Method* currentMethod)
 // ----------------------------------------------------------------------------
 
 
-void Planner::recordDecompositionOfTask(Method* method, std::vector<BaseTask*>& finalPlan,  WStates& WorkingWS, backtrack_stack& decomposition_history)
+void Planner::recordDecompositionOfTask(Method* method, std::vector<BaseTask*>& finalPlan, backtrack_stack& decomposition_history)
 {
-		WStates CopyWorkingWS(*method->domain);
-		CopyWorkingWS.clone(WorkingWS);
-		decomposition_history.push_front(BacktrackPoint(domain,finalPlan, TasksToProcess, method, CopyWorkingWS));
+	decomposition_history.push_front(BacktrackPoint(finalPlan.size(), TaskTrail.size(), StateTrail.size(), method));
 }
 
 // ----------------------------------------------------------------------------
@@ -255,11 +476,21 @@ void Planner::recordDecompositionOfTask(Method* method, std::vector<BaseTask*>&
 void Planner::restoreToLastDecomposedTask(std::vector<BaseTask*>& finalPlan, WStates& WorkingWS, backtrack_stack& decomposition_history)
 {
 	if (decomposition_history.empty()) return;
+	_backtracks++;
 	BacktrackPoint& bp = decomposition_history.front();
-	finalPlan = bp.Plan;
-	WorkingWS.free();
-	WorkingWS.CurrentWorldState = bp.WorkingWS.CurrentWorldState;
-	TasksToProcess = bp.TasksToProcess;
+	// the plan only grows after a decomposition
+	finalPlan.resize(bp.PlanSize);
+	WorkingWS.undo(StateTrail, bp.StateMark);
+	// undo the stack operations, most recent first
+	while (TaskTrail.size() > bp.TaskMark)
+	{
+		const TaskUndo& u = TaskTrail.back();
+		if (u.Pushed)
+			TasksToProcess.pop_front();
+		else
+			TasksToProcess.push_front(u.Task);
+		TaskTrail.pop_back();
+	}
 	decomposition_history.pop_front();
 
 
@@ -271,11 +502,31 @@ void Planner::restoreToLastDecomposedTask(std::vector<BaseTask*>& finalPlan, WSt
 // ----------------------------------------------------------------------------
 
 
+void Planner::pushTask(BaseTask* task)
+{
+	TasksToProcess.push_front(task);
+	TaskTrail.push_back({ task, true });
+}
+
+// ----------------------------------------------------------------------------
+
+BaseTask* Planner::popTask()
+{
+	BaseTask* task = TasksToProcess.front();
+	TasksToProcess.pop_front();
+	TaskTrail.push_back({ task, false });
+	return task;
+}
+
+// ----------------------------------------------------------------------------
+
+
 void  Planner::clearStack()
 {
 	// clear stack
 	while (!TasksToProcess.empty())
 		TasksToProcess.pop_front();
+	TaskTrail.clear();
 
 }
 
@@ -286,9 +537,6 @@ void  Planner::clearBacktrackStack(backtrack_stack& stack)
 {
 	while (!stack.empty())
 	{
-		BacktrackPoint& bp = stack.front();
-		
-		bp.WorkingWS.free();
 		stack.pop_front();
 	}
 }
\ No newline at end of file
@@ -34,6 +34,7 @@
 
 #include "WorldStateProperties.h"
 #include <queue>
+#include <atomic>
  
 
 namespace HTN
@@ -45,18 +46,25 @@ namespace HTN
 	struct CompoundTask;
 	
 	// records the planners state so the planner can backtrack either
-	// when a compound task cannot be decomposed or when a primitives conditions arent satisfied
+	// when a compound task cannot be decomposed or when a primitives conditions arent satisfied.
+	// Only the sizes of the plan and of the undo logs are kept : backtracking rewinds to them
 	struct BacktrackPoint
 	{
-		//BacktrackPoint() {}
-		BacktrackPoint(Domain& d,std::vector<BaseTask*>& plan, std::deque<BaseTask*>& tasksToProcess, Method* currentMethod,const  WStates& workingWS)
-			: Plan(plan), TasksToProcess(tasksToProcess), CurrentMethod(currentMethod), WorkingWS(workingWS), domain(d){}
+		BacktrackPoint(size_t planSize, size_t taskMark, size_t stateMark, Method* currentMethod)
+			: PlanSize(planSize), TaskMark(taskMark), StateMark(stateMark), CurrentMethod(currentMethod) {}
 
-		std::vector<BaseTask*> Plan;
-		std::deque<BaseTask*> TasksToProcess;
+		size_t PlanSize;
+		size_t TaskMark;
+		size_t StateMark;
 		Method* CurrentMethod;
-		WStates WorkingWS;
-		Domain& domain;
+	};
+
+	// change of the TasksToProcess stack, recorded so that it can be undone
+	struct TaskUndo
+	{
+		BaseTask* Task;
+		// true if the task was pushed, false if it was popped
+		bool Pushed;
 	};
 
 	typedef std::deque<BacktrackPoint> backtrack_stack;
@@ -78,15 +86,36 @@ namespace HTN
 		~Planner();
 		// search for a plan
 		std::vector<BaseTask*> findPlan();
+		// explore the first applicable methods of a compound task in parallel (0 or 1 : sequential search).
+		// The plan is the same as the sequential one : the first success in method order is kept.
+		// Function values (FctBoolValue...) are then called from several threads
+		void setSpeculation(size_t methods) { _speculation = methods; }
+		// number of backtracks since the planner was created (speculative branches included)
+		size_t backtrackCount() const { return _backtracks; }
 	protected:
 		// search a plan for the given compound task
 		std::vector<BaseTask*> findPlan(BaseTask* task);
+		// process the tasks until the stack is empty or a plan is found; returns false when a
+		// speculative branch backtracks its method (history below floor) or is cancelled
+		bool search(std::vector<BaseTask*>& finalPlan, WStates& WorkingWS, EvalStack& WorkingEvalTask, backtrack_stack& decomposition_history, size_t floor);
+		// try the first applicable methods on top of the stack in parallel, returns true with the result of the
+		// search if one of them succeeds; otherwise they are popped as if each one was tried then backtracked
+		bool speculate(std::vector<BaseTask*>& finalPlan, WStates& WorkingWS, EvalStack& WorkingEvalTask);
+		// true if the plan cache is looked up for this search
+		bool useCache();
+		// methods of a compound task which may be satisfied by the working world state, memoized by the values of the states they read
+		// (nullptr when the memo is not worth it for this task)
+		const std::vector<bool>* satisfiedMethods(CompoundTask* task, EvalStack& evalTask, WStates& WorkingWS);
 		// decompose CompoundTask by adding  methods subtasks to the TaskToProcess stack.  	 
 		void decompose(Method* currentMethod);
 		// register this decomposition point so we can backtrack later 
-		void recordDecompositionOfTask( Method* method, std::vector<BaseTask*>& finalPlan,  WStates& WorkingWS, backtrack_stack& decomposition_history);
+		void recordDecompositionOfTask( Method* method, std::vector<BaseTask*>& finalPlan, backtrack_stack& decomposition_history);
 		// backtrack either when a compound task cannot be decomposed or when a primitives conditions arent satisfied
 		void restoreToLastDecomposedTask(std::vector<BaseTask*>& finalPlan, WStates& WorkingWS, backtrack_stack& decomposition_history);
+		// push a task on the TasksToProcess stack
+		void pushTask(BaseTask* task);
+		// pop a task from the TasksToProcess stack
+		BaseTask* popTask();
 		// clear stack
 		void  clearStack();
 		// clear backtracking stack
@@ -94,6 +123,22 @@ namespace HTN
 	protected:
 		// working set of tasks
 		std::deque<BaseTask*> TasksToProcess;
+		// undo log of the TasksToProcess stack
+		std::vector<TaskUndo> TaskTrail;
+		// undo log of the working world state
+		std::vector<StateUndo> StateTrail;
+		// searches, cache lookups and plans found in the cache, by period of 256 searches
+		size_t _cacheSearches;
+		size_t _cacheLookups;
+		size_t _cacheHits;
+		// false while the cache is seldom useful
+		bool _cacheUsed;
+		// number of methods explored in parallel
+		size_t _speculation;
+		// see backtrackCount
+		size_t _backtracks;
+		// set in a speculative branch : it stops when true
+		std::atomic<bool>* _cancel;
 	 	// associated domain
 		Domain& domain;
 	};
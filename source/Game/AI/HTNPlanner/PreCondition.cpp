@@ -31,6 +31,7 @@
 #include "PreCondition.h"
 #include "Domain.h"
 #include "HTNTrace.h"
+#include <cstring>
 
 // ----------------------------------------------------------------------------
 
@@ -43,6 +44,7 @@ using namespace HTN;
 Precondition::Precondition(const DefState& condition, FCT fct, BaseValue* value)
 	: Condition(condition), Fct(fct), Value(value)
 {
+	memset(&Code, 0, sizeof(Code));
 
 }
 
@@ -55,27 +57,12 @@ Precondition::~Precondition()
 
 bool Precondition::isSatisfied(EvalStack& evalTask,WStates& states)
 {
-	// gets a state of a given group
-	BaseState*state = states.wState(Condition.Group, Condition.State);
-	if (!state) {
-		throw std::domain_error("Precondition::isSatisfied : state does not exists : %s" + Condition.toString());
-	}
-
-	 BaseValue* valueOperand = Value;
-	const StateValue* sv = dynamic_cast<const StateValue*>(Value);
-	if (sv)
+	bool sb;
+	if (Code.Op == OP_GENERIC || !states.wCompare(evalTask, Code, sb))
 	{
-		BaseState* valueState = states.wState(sv->state.Group, sv->state.State);
-		valueOperand = dynamic_cast<BaseValue*>(valueState);
-		if (!valueOperand)
-		{
-			throw std::domain_error("Precondition::isSatisfied :  " + sv->state.Group + "." + sv->state.State + FctLib::toString(Fct) + " ? Value is null");
-		}
+		sb = states.wCompare(evalTask, Condition, Fct, Value);
 	}
 
-
-	bool sb = state->compare(evalTask,Fct, valueOperand);
-
 	HTNTrace(states._domain.Name," isSatisfied %s = %s ",  Condition.toString().c_str(), sb ? "true" : "false");
 	return sb;
 }
@@ -45,10 +45,18 @@ namespace HTN
 	struct Domain;
 	class EvalStack;
 	
+	// kind of a task, to dispatch without a dynamic_cast
+	enum TaskKind
+	{
+		TASK_PRIMITIVE,
+		TASK_COMPOUND,
+		TASK_METHOD
+	};
+
 	// base class representing either a primitive task or a compound task
 	struct BaseTask
 	{
-		BaseTask(Domain* d, const std::string& name,std::initializer_list<std::string>,float cost=0) : Name(name), domain(d), Cost(cost){}
+		BaseTask(Domain* d, const std::string& name,std::initializer_list<std::string>,float cost=0, TaskKind kind = TASK_PRIMITIVE) : Name(name), domain(d), Cost(cost), Id(-1), Kind(kind){}
 		virtual ~BaseTask() {}
 		virtual void dump(int) {}
 		virtual void free() {}
@@ -61,6 +69,10 @@ namespace HTN
 		std::initializer_list<std::string> Args;
 		// cost of the task [0..1]
 		float Cost;
+		// interned identifier, index in Domain::TasksById (set by Domain::compile)
+		int Id;
+		// primitive, compound or method
+		TaskKind Kind;
 	
 	};
  
@@ -42,7 +42,7 @@ using namespace HTN;
 
 
 Runner::Runner(Domain& d)
-	: _domain(d), _current_plan_index(0), _state(RunnerState::EVAL_NEXT_OPERATION)
+	: _domain(d), _current_plan_index(0), _state(RunnerState::EVAL_NEXT_OPERATION), _completions(std::make_shared<CompletionQueue>())
 {
 
 }
@@ -74,6 +74,8 @@ void Runner::loadPlan(const std::vector<BaseTask*>& plan)
 	 
 	_plan = plan;
 	_current_plan_index = 0;
+	// the completion of an operation of the previous plan is ignored
+	_operation.reset();
 	_state = RunnerState::EVAL_NEXT_OPERATION;
 }
 
@@ -82,6 +84,8 @@ RunningStatus Runner::update(const float elapsedTime)
 { 
 
 
+	if (_state == RunnerState::WAIT_OPERATION_EVENT)
+		receive();
 	if(_state== RunnerState::EVAL_NEXT_OPERATION) 
 		advance(); 
 	if (_state == RunnerState::WAIT_OPERATION_TO_FINISH)
@@ -92,6 +96,7 @@ RunningStatus Runner::update(const float elapsedTime)
 	{
 	case RunnerState::EVAL_NEXT_OPERATION:  return RunningStatus::RunningContinue;
 	case RunnerState::WAIT_OPERATION_TO_FINISH: return RunningStatus::RunningContinue;
+	case RunnerState::WAIT_OPERATION_EVENT: return RunningStatus::RunningContinue;
 	case RunnerState::EVAL_FAILURE: return RunningStatus::RunningFailure;
 	case RunnerState::PLAN_FINISHED: return RunningStatus::RunningSuccess;
 	}
@@ -117,7 +122,7 @@ void Runner::advance()
 	{
 		throw std::domain_error("Runner::advance : task is null");
 	}
-	if (!pt->Operation.Action)//.isValid())
+	if (!pt->Operation.Action && !pt->Operation.Start)//.isValid())
 	{
 		HTNTrace(_domain.Name, "Operation has no action %s", pt->Name.c_str());
 		_state = RunnerState::EVAL_NEXT_OPERATION;
@@ -131,6 +136,20 @@ void Runner::advance()
 		_state = RunnerState::EVAL_FAILURE;
 		return;
 	}
+	if (pt->Operation.Start)
+	{
+		_operation = pt->Operation.Start(_domain.WorldStates);
+		if (!_operation)
+		{
+			HTNTrace(_domain.Name, "\t  task '%s' action not started", pt->Name.c_str());
+			_state = RunnerState::EVAL_FAILURE;
+			return;
+		}
+		// nothing to do until the operation completes
+		_state = RunnerState::WAIT_OPERATION_EVENT;
+		_operation->attach(_completions);
+		return;
+	}
 	_state = RunnerState::WAIT_OPERATION_TO_FINISH;
 	_curent_status = OperationStatus::FirstEvaluation;
 }
@@ -143,24 +162,43 @@ void Runner::eval()
 	PrimitiveTask* pt = static_cast<PrimitiveTask*>(bt);
 
 	_curent_status = pt->Operation.Action(_curent_status,_domain.WorldStates);
-	if (_curent_status == OperationStatus::Failure)
+	if (_curent_status == OperationStatus::Failure || _curent_status == OperationStatus::Success)
 	{ 
-		HTNTrace(_domain.Name, "\t  task '%s' action failure", pt->Name.c_str());
-		_state = RunnerState::EVAL_FAILURE;
+		finish(_curent_status == OperationStatus::Success);
 		return;
-		
 	}
-	if (_curent_status == OperationStatus::Success)
+	if (_curent_status == OperationStatus::Continue)
 	{
-		HTNTrace(_domain.Name, "\t  task '%s' action finished", pt->Name.c_str());
-		_state = RunnerState::EVAL_NEXT_OPERATION;
-		pt->applyEffects(_domain.EvalTask,_domain.WorldStates);
-		_current_plan_index++;
+		_state = RunnerState::WAIT_OPERATION_TO_FINISH;
 		return;
 	}
-	if (_curent_status == OperationStatus::Continue)
+}
+
+
+void Runner::receive()
+{
+	while (OperationHandlePtr handle = _completions->pop())
 	{
-		_state = RunnerState::WAIT_OPERATION_TO_FINISH;
+		// operation of a previous plan
+		if (handle != _operation) continue;
+		_operation.reset();
+		finish(handle->succeeded());
+		return;
+	}
+}
+
+
+void Runner::finish(bool success)
+{
+	PrimitiveTask* pt = static_cast<PrimitiveTask*>(_plan.at(_current_plan_index));
+	if (!success)
+	{
+		HTNTrace(_domain.Name, "\t  task '%s' action failure", pt->Name.c_str());
+		_state = RunnerState::EVAL_FAILURE;
 		return;
 	}
+	HTNTrace(_domain.Name, "\t  task '%s' action finished", pt->Name.c_str());
+	_state = RunnerState::EVAL_NEXT_OPERATION;
+	pt->applyEffects(_domain.EvalTask,_domain.WorldStates);
+	_current_plan_index++;
 }
\ No newline at end of file
@@ -32,6 +32,7 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include "Operator.h"
  
 
@@ -48,6 +49,8 @@ namespace HTN
 		EVAL_NEXT_OPERATION,
 		// wait this operation finish
 		WAIT_OPERATION_TO_FINISH,
+		// wait the completion of an asynchronous operation
+		WAIT_OPERATION_EVENT,
 		// failure on operation
 		EVAL_FAILURE,
 		// plan is finished
@@ -78,9 +81,17 @@ namespace HTN
 		void loadPlan(const std::vector<BaseTask*>& plan);
 		// execute plan 
 		RunningStatus update(const float elapsedTime);
+		// called from the thread which completes an asynchronous operation, e.g. to step the planner
+		void setWakeup(std::function<void()> wakeup) { _completions->Wakeup = wakeup; }
+		// true while the plan only waits for the completion of an asynchronous operation
+		bool isWaitingEvent() const { return _state == RunnerState::WAIT_OPERATION_EVENT; }
 	protected:
 		void advance();
 		void eval();
+		// handle the completed asynchronous operations
+		void receive();
+		// end the current operation
+		void finish(bool success);
 	protected:
 		// associated domain
 		Domain& _domain;
@@ -92,6 +103,10 @@ namespace HTN
 		RunnerState _state;
 		// current status of the current operation
 		OperationStatus _curent_status;
+		// current asynchronous operation, if any
+		OperationHandlePtr _operation;
+		// completed asynchronous operations
+		std::shared_ptr<CompletionQueue> _completions;
 		
 	};
 
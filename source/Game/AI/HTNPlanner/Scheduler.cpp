@@ -0,0 +1,236 @@
+ 
+// ----------------------------------------------------------------------------
+//
+//
+//	Hierarchical Task Networks - HTN Implementation in C++
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+#include "Scheduler.h"
+#include "HTNPlanner.h"
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+
+using namespace HTN;
+
+// ----------------------------------------------------------------------------
+
+
+Scheduler& Scheduler::instance()
+{
+	static Scheduler scheduler;
+	return scheduler;
+}
+
+// ----------------------------------------------------------------------------
+
+Scheduler::Scheduler(int workers)
+{
+	if (workers <= 0)
+	{
+		workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+	for (int i = 0; i < workers; i++)
+	{
+		_workers.push_back(std::thread(&Scheduler::run, this));
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+Scheduler::~Scheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_signal.notify_all();
+	for (std::thread& worker : _workers)
+	{
+		worker.join();
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+void Scheduler::add(HTNPlanner* planner, int delay_ms)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	Entry& entry = _planners[planner];
+	schedule(planner, entry, clock::now() + std::chrono::milliseconds(delay_ms));
+}
+
+// ----------------------------------------------------------------------------
+
+void Scheduler::remove(HTNPlanner* planner)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	auto it = _planners.find(planner);
+	if (it == _planners.end()) return;
+	Entry& entry = it->second;
+	_removing++;
+	_signal.wait(lock, [&]() { return !entry.Running; });
+	_removing--;
+	// pending timers are ignored once the entry is gone
+	_planners.erase(planner);
+}
+
+// ----------------------------------------------------------------------------
+
+void Scheduler::wakeup(HTNPlanner* planner)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _planners.find(planner);
+	if (it == _planners.end()) return;
+	if (it->second.Running)
+	{
+		// stepped again as soon as the current step ends
+		it->second.Wakeup = true;
+		return;
+	}
+	schedule(planner, it->second, clock::now());
+}
+
+// ----------------------------------------------------------------------------
+
+void Scheduler::parallel(std::vector<std::function<void()>>& jobs)
+{
+	Batch batch = { &jobs, 0, 0 };
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (jobs.empty()) return;
+	_batches.push_back(&batch);
+	_signal.notify_all();
+	// the calling thread takes part : the jobs are done even if all the workers are busy
+	while (batch.Next < jobs.size())
+	{
+		auto it = std::find(_batches.begin(), _batches.end(), &batch);
+		if (it != _batches.begin())
+		{
+			// run this batch first
+			_batches.erase(it);
+			_batches.push_front(&batch);
+		}
+		runJob(lock);
+	}
+	_signal.wait(lock, [&]() { return batch.Done == jobs.size(); });
+}
+
+// ----------------------------------------------------------------------------
+
+void Scheduler::runJob(std::unique_lock<std::mutex>& lock)
+{
+	Batch* batch = _batches.front();
+	size_t job = batch->Next++;
+	if (batch->Next == batch->Jobs->size())
+	{
+		// all started
+		_batches.pop_front();
+	}
+	lock.unlock();
+	(*batch->Jobs)[job]();
+	lock.lock();
+	if (++batch->Done == batch->Jobs->size())
+	{
+		// the caller of parallel is waiting
+		_signal.notify_all();
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+size_t Scheduler::plannerCount()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _planners.size();
+}
+
+// ----------------------------------------------------------------------------
+
+void Scheduler::schedule(HTNPlanner* planner, Entry& entry, clock::time_point due)
+{
+	// only the latest timer of a planner is valid
+	entry.Generation++;
+	_timers.push({ due, planner, entry.Generation });
+	_signal.notify_one();
+}
+
+// ----------------------------------------------------------------------------
+
+void Scheduler::run()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_stop)
+	{
+		if (!_batches.empty())
+		{
+			runJob(lock);
+			continue;
+		}
+		if (_timers.empty())
+		{
+			_signal.wait(lock);
+			continue;
+		}
+		Timer timer = _timers.top();
+		auto it = _planners.find(timer.Planner);
+		if (it == _planners.end() || it->second.Generation != timer.Generation)
+		{
+			// removed or rescheduled since
+			_timers.pop();
+			continue;
+		}
+		if (timer.Due > clock::now())
+		{
+			_signal.wait_until(lock, timer.Due);
+			continue;
+		}
+		_timers.pop();
+		Entry& entry = it->second;
+		entry.Running = true;
+		entry.Wakeup = false;
+
+		lock.unlock();
+		int delay_ms = timer.Planner->step();
+		lock.lock();
+
+		// the entry is not erased while it is running
+		entry.Running = false;
+		if (entry.Wakeup || delay_ms == 0)
+		{
+			schedule(timer.Planner, entry, clock::now());
+		}
+		else if (delay_ms > 0)
+		{
+			schedule(timer.Planner, entry, clock::now() + std::chrono::milliseconds(delay_ms));
+		}
+		// else no timer : the planner waits for a wakeup
+		if (_removing > 0)
+		{
+			// a remove is waiting for this step
+			_signal.notify_all();
+		}
+	}
+}
@@ -0,0 +1,136 @@
+ 
+// ----------------------------------------------------------------------------
+//
+//
+//	Hierarchical Task Networks - HTN Implementation in C++
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <deque>
+#include <functional>
+
+namespace HTN
+{
+
+	class HTNPlanner;
+
+	// Runs the registered planners on a fixed pool of worker threads, instead of one
+	// thread per planner. A planner is stepped when its delay expires or when it is
+	// woken up (only then if its step returned -1); a planner is never stepped by two
+	// workers at the same time.
+	// The workers also run batches of jobs (see parallel), before the planner steps
+	class Scheduler
+	{
+	public:
+		// shared scheduler, created on first use
+		static Scheduler& instance();
+
+		// create the scheduler with a number of workers (0 : one less than the number of cores)
+		Scheduler(int workers = 0);
+		~Scheduler();
+		// register a planner, first step after delay_ms
+		void add(HTNPlanner* planner, int delay_ms);
+		// unregister a planner, wait for its current step to finish
+		void remove(HTNPlanner* planner);
+		// step a planner as soon as possible
+		void wakeup(HTNPlanner* planner);
+		// run jobs on the workers and on the calling thread, which takes the jobs not started yet :
+		// it can be called from a planner step. Returns when all the jobs are done, jobs must not throw
+		void parallel(std::vector<std::function<void()>>& jobs);
+		// number of worker threads
+		size_t threadCount() const { return _workers.size(); }
+		// number of registered planners
+		size_t plannerCount();
+
+	protected:
+		typedef std::chrono::steady_clock clock;
+
+		// a planner waiting for its next step
+		struct Timer
+		{
+			clock::time_point Due;
+			HTNPlanner* Planner;
+			// generation of the planner entry, older timers are ignored
+			unsigned int Generation;
+			bool operator>(const Timer& rhs) const { return Due > rhs.Due; }
+		};
+
+		// state of a registered planner
+		struct Entry
+		{
+			unsigned int Generation = 0;
+			// a worker is stepping the planner
+			bool Running = false;
+			// woken up during its step
+			bool Wakeup = false;
+		};
+
+		// jobs given to parallel
+		struct Batch
+		{
+			std::vector<std::function<void()>>* Jobs;
+			// next job to start
+			size_t Next;
+			// number of jobs done
+			size_t Done;
+		};
+
+		// worker thread method
+		void run();
+		// start the next job of the first batch and wait for it (under lock, unlocked while it runs)
+		void runJob(std::unique_lock<std::mutex>& lock);
+		// queue the next step of a planner (under lock)
+		void schedule(HTNPlanner* planner, Entry& entry, clock::time_point due);
+
+	protected:
+		// worker threads
+		std::vector<std::thread> _workers;
+		// lock the data
+		std::mutex _mutex;
+		// signaled when a timer is added or a step ends
+		std::condition_variable _signal;
+		// next steps, earliest first
+		std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> _timers;
+		// registered planners
+		std::unordered_map<HTNPlanner*, Entry> _planners;
+		// batches with jobs not started yet
+		std::deque<Batch*> _batches;
+		// number of remove calls waiting for a step to finish
+		int _removing = 0;
+		// if true, quit the workers
+		bool _stop = false;
+	};
+
+}
@@ -32,12 +32,45 @@
 #pragma once
 
 #include <string>
+#include <cstring>
+#include <stdexcept>
 #include "Geometry.h"
 
 
 namespace HTN
 {
 
+	// FNV-1a hash of some bytes, stable from one run to the other (see PlanCache)
+	inline size_t hashBytes(size_t seed, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		unsigned long long h = seed ? seed : 14695981039346656037ULL;
+		for (size_t i = 0; i < size; i++)
+		{
+			h ^= bytes[i];
+			h *= 1099511628211ULL;
+		}
+		return (size_t)h;
+	}
+
+	// hash of a string
+	inline size_t hashString(size_t seed, const std::string& s)
+	{
+		return hashBytes(seed, s.data(), s.size() + 1);
+	}
+
+	// hash of a plain value (int, float, pointer...) : mixed as one 64 bits word
+	template <typename T>
+	inline size_t hashValue(size_t seed, const T& value)
+	{
+		static_assert(sizeof(T) <= sizeof(unsigned long long), "hashValue : use hashBytes");
+		unsigned long long word = 0;
+		memcpy(&word, &value, sizeof(T));
+		unsigned long long h = seed ? seed : 14695981039346656037ULL;
+		h ^= word + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+		return (size_t)h;
+	}
+
 
 	enum VariantType
 	{
@@ -84,6 +117,22 @@ namespace HTN
 			 
 		}
 
+		// hash of the name and value
+		size_t hash(size_t seed = 0) const
+		{
+			size_t h = hashString(hashValue(seed, (int)type), variable);
+			switch (type)
+			{
+			default:
+			case VAR_EMPTY: return h;
+			case VAR_BOOL: return hashValue(h, bvalue);
+			case VAR_LONG: return hashValue(h, lvalue);
+			case VAR_FLOAT: return hashValue(h, fvalue);
+			case VAR_STRING: return hashString(h, svalue);
+			case VAR_POINT: return hashValue(hashValue(hashValue(h, pvalue.X), pvalue.Y), pvalue.Z);
+			}
+		}
+
 		std::string toString() const
 		{
 			switch (type)
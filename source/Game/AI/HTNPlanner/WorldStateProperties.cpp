@@ -32,6 +32,7 @@
 #include "HTNTrace.h"
 #include "EvalStack.h"
 #include "Domain.h"
+#include <cstring>
 
 
 // ----------------------------------------------------------------------------
@@ -57,11 +58,19 @@ void WorldStateProperties::free()
 		element.second.free();
 	 
 	});
+	Values.clear();
 	_isModified = false;
 }
 
 void WorldStateProperties::clone(WorldStateProperties& wsp)
 {
+	// compiled states: a flat copy of the values
+	if (!wsp.Values.empty())
+	{
+		Values = wsp.Values;
+		_isModified = false;
+		return;
+	}
 	std::for_each(wsp.CurrentWorldState.begin(), wsp.CurrentWorldState.end(),
 		[&](std::pair<const std::string, StateGroup>  &element) {
 		StateGroup sg;
@@ -71,15 +80,121 @@ void WorldStateProperties::clone(WorldStateProperties& wsp)
 	_isModified = false;
 }
 
-BaseState* WorldStateProperties::wState(const std::string& group, const std::string& state)
+// ----------------------------------------------------------------------------
+
+Variant WorldStateProperties::wStateAsVariant(const std::string& group, const std::string& state)
 {
+	if (!Values.empty())
+	{
+		int id = _domain.stateId(group, state);
+		if (id < 0)
+		{
+			throw std::domain_error("wStateAsVariant : state does not exist : " + group + "." + state);
+		}
+		return toVariant(Values[id]);
+	}
+	// declared states, before compilation
+	BaseState* bs = nullptr;
 	if (CurrentWorldState.find(group) != CurrentWorldState.end())
 	{
-		StateGroup* stgroup = &CurrentWorldState[group];
-		if (!stgroup) return nullptr;
-		return stgroup->getState(state);
+		bs = CurrentWorldState[group].getState(state);
 	}
-	return nullptr;
+	if (!bs)
+	{
+		throw std::domain_error("wStateAsVariant : state does not exist : " + group + "." + state);
+	}
+	return bs->value();
+}
+
+// ----------------------------------------------------------------------------
+
+Variant WorldStateProperties::toVariant(const StateData& data) const
+{
+	switch (data.Type)
+	{
+	case VAR_BOOL: return Variant(data.B);
+	case VAR_LONG: return Variant(data.L);
+	case VAR_FLOAT: return Variant(data.F);
+	case VAR_STRING: return Variant(_domain.symbol(data.S));
+	case VAR_POINT: return Variant(Point(data.P[0], data.P[1], data.P[2]));
+	default:
+	case VAR_EMPTY: return Variant();
+	}
+}
+
+StateData WorldStateProperties::toData(const Variant& variant) const
+{
+	StateData data;
+	memset(&data, 0, sizeof(data));
+	data.Type = variant.type;
+	switch (variant.type)
+	{
+	case VAR_BOOL: data.B = variant.bvalue; break;
+	case VAR_LONG: data.L = variant.lvalue; break;
+	case VAR_FLOAT: data.F = variant.fvalue; break;
+	case VAR_STRING: data.S = _domain.intern(variant.svalue); break;
+	case VAR_POINT: data.P[0] = variant.pvalue.X; data.P[1] = variant.pvalue.Y; data.P[2] = variant.pvalue.Z; break;
+	default:
+	case VAR_EMPTY: break;
+	}
+	return data;
+}
+
+// ----------------------------------------------------------------------------
+
+size_t WorldStateProperties::hash(size_t seed, const StateData& data)
+{
+	// one mix per value : its bits, the type in the low bits
+	unsigned long long word = 0;
+	switch (data.Type)
+	{
+	case VAR_BOOL: word = data.B; break;
+	case VAR_LONG: word = (unsigned long)data.L; break;
+	case VAR_FLOAT: memcpy(&word, &data.F, sizeof(float)); break;
+	case VAR_STRING: word = (unsigned long)data.S; break;
+	case VAR_POINT:
+		seed = hashValue(hashValue(seed, data.P[0]), data.P[1]);
+		memcpy(&word, &data.P[2], sizeof(float));
+		break;
+	default:
+	case VAR_EMPTY: break;
+	}
+	return hashValue(seed, (word << 3) | (unsigned long long)data.Type);
+}
+
+bool WorldStateProperties::equals(const StateData& a, const StateData& b)
+{
+	if (a.Type != b.Type) return false;
+	switch (a.Type)
+	{
+	case VAR_BOOL: return a.B == b.B;
+	case VAR_LONG: return a.L == b.L;
+	case VAR_FLOAT: return a.F == b.F;
+	case VAR_STRING: return a.S == b.S;
+	case VAR_POINT: return a.P[0] == b.P[0] && a.P[1] == b.P[1] && a.P[2] == b.P[2];
+	default:
+	case VAR_EMPTY: return true;
+	}
+}
+
+size_t WorldStateProperties::hash() const
+{
+	size_t h = hashValue(0, Values.size());
+	for (const StateData& data : Values)
+	{
+		h = hash(h, data);
+	}
+	return h;
+}
+
+size_t WorldStateProperties::hash(const std::vector<int>& ids) const
+{
+	size_t h = hashValue(0, ids.size());
+	for (int id : ids)
+	{
+		h = hash(h, Values[id]);
+	}
+	return h;
 }
 
 // ----------------------------------------------------------------------------
@@ -115,607 +230,433 @@ bool WorldStateProperties::wSetState(const std::string& group, const std::string
 
 
 
-bool WorldStateProperties::wSetState(const std::string& group, const std::string& state, FCT Fct,const BaseValue& Value)
+void WorldStateProperties::compile(const std::vector<DefState>& states)
 {
-	if (CurrentWorldState.find(group) != CurrentWorldState.end())
+	std::vector<StateData> values(states.size());
+	for (const DefState& ds : states)
 	{
-		StateGroup* stgroup = &CurrentWorldState[group];
-		
-		BaseState* bs =  stgroup->getState(state);
-		if (!bs)
-		{
-			 throw std::domain_error("WorldStateProperties::wSetState : state does not exist : " + group + "." + state);
-		}
-		const BaseValue* valueOperand = &Value;
-
-		// indirection, we need to find the value of a state
-		const StateValue* sv = dynamic_cast<const StateValue*>(valueOperand);
-		if (sv)
-		{
-			BaseState* valueState = wState(sv->state.Group, sv->state.State);
-			valueOperand = dynamic_cast<BaseValue*>(valueState);
-			if (!valueOperand)
-			{
-				throw std::domain_error("WorldStateProperties::wSetState :  " + sv->state.Group + "." + sv->state.State + FctLib::toString(Fct) + " ? Value is null");
-			}
-		}
-
-		if (!valueOperand)
-		{
-			throw std::domain_error("WorldStateProperties::wSetState :  "+ group+"."+ state+ FctLib::toString(Fct)+" ? Value is null");
-		}
-		 
-		HTNTrace(_domain.Name, "\tmodify state %s.%s %s ", group.c_str(), state.c_str(), FctLib::toString(Fct).c_str());// , valueOperand->toString().c_str());
-
-		bs->affect(_domain.EvalTask,Fct, valueOperand);
-
-		setIsModified(true);
-		return true;
+		BaseState* bs = CurrentWorldState[ds.Group].States[ds.State];
+		values[ds.Id] = toData(bs->value());
+		values[ds.Id].AnyType = dynamic_cast<StateVariantValue*>(bs) != nullptr;
 	}
-	else
-	{
-		throw std::domain_error("WorldStateProperties::wSetState : state does not exist : " + group + "." + state);
-	}
-  
+	// the declarations are not used anymore
+	free();
+	CurrentWorldState.clear();
+	Values.swap(values);
 }
- 
 
-// ----------------------------------------------------------------------------
-// StateGroup
 // ----------------------------------------------------------------------------
 
-BaseState* StateGroup::getState(const std::string& state)
+int WorldStateProperties::stateId(const DefState& state) const
 {
-	if (States.find(state) != States.end())
+	if (state.Id >= 0) return state.Id;
+	int id = _domain.stateId(state.Group, state.State);
+	if (id < 0 || Values.empty())
 	{
-		return  States[state];
+		throw std::domain_error("WorldStateProperties : state does not exist : " + state.Group + "." + state.State);
 	}
-	return nullptr;
-}
-
- 
-StateGroup::~StateGroup()
-{
-	 
+	return id;
 }
 
+// ----------------------------------------------------------------------------
 
-void StateGroup::free()
+StateData WorldStateProperties::evaluate(EvalStack& evalTask, const BaseValue* value)
 {
-	std::for_each(States.begin(), States.end(),
-		[&](std::pair<const std::string, BaseState*>  &element) {
-		delete element.second;
-		element.second = nullptr;
-	});
-}
+	// indirection, we need to find the value of a state
+	const StateValue* sv = dynamic_cast<const StateValue*>(value);
+	if (sv) return Values[stateId(sv->state)];
 
+	StateData data;
+	memset(&data, 0, sizeof(data));
 
-void StateGroup::clone(const StateGroup& sg)
-{
-	std::for_each(sg.States.begin(), sg.States.end(),
-		[&](const std::pair<const std::string, BaseState*>  &element) {
+	// constants
+	if (const BoolValue* v = dynamic_cast<const BoolValue*>(value)) { data.Type = VAR_BOOL; data.B = v->Value; return data; }
+	if (const LongValue* v = dynamic_cast<const LongValue*>(value)) { data.Type = VAR_LONG; data.L = v->Value; return data; }
+	if (const FloatValue* v = dynamic_cast<const FloatValue*>(value)) { data.Type = VAR_FLOAT; data.F = v->Value; return data; }
+	if (const StringValue* v = dynamic_cast<const StringValue*>(value)) { data.Type = VAR_STRING; data.S = _domain.intern(v->Value); return data; }
+	if (const PointValue* v = dynamic_cast<const PointValue*>(value)) return toData(Variant(v->Value));
+	if (const VariantValue* v = dynamic_cast<const VariantValue*>(value)) return toData(v->Value);
 
-		States[element.first] = element.second->clone();
+	// variables
+	if (const BooleanVar* v = dynamic_cast<const BooleanVar*>(value)) { data.Type = VAR_BOOL; data.B = v->getValue(evalTask); return data; }
+	if (const LongVar* v = dynamic_cast<const LongVar*>(value)) { data.Type = VAR_LONG; data.L = v->getValue(evalTask); return data; }
+	if (const FloatVar* v = dynamic_cast<const FloatVar*>(value)) { data.Type = VAR_FLOAT; data.F = v->getValue(evalTask); return data; }
+	if (const StringVar* v = dynamic_cast<const StringVar*>(value)) { data.Type = VAR_STRING; data.S = _domain.intern(v->getValue(evalTask)); return data; }
+	if (const PointVar* v = dynamic_cast<const PointVar*>(value)) return toData(Variant(v->getValue(evalTask)));
+	if (const VariantVar* v = dynamic_cast<const VariantVar*>(value)) return toData(v->getValue(evalTask));
 
-	});
+	// functions
+	if (const FctBoolValue* v = dynamic_cast<const FctBoolValue*>(value)) { data.Type = VAR_BOOL; data.B = v->Value(); return data; }
+	if (const FctLongValue* v = dynamic_cast<const FctLongValue*>(value)) { data.Type = VAR_LONG; data.L = v->Value(); return data; }
+	if (const FctFloatValue* v = dynamic_cast<const FctFloatValue*>(value)) { data.Type = VAR_FLOAT; data.F = v->Value(); return data; }
+	if (const FctStringValue* v = dynamic_cast<const FctStringValue*>(value)) { data.Type = VAR_STRING; data.S = _domain.intern(v->Value()); return data; }
+	if (const FctPointValue* v = dynamic_cast<const FctPointValue*>(value)) return toData(Variant(v->Value()));
+	if (const FctVariantValue* v = dynamic_cast<const FctVariantValue*>(value)) return toData(v->Value());
+
+	throw std::domain_error("WorldStateProperties::evaluate : unknown value : " + (value ? value->toString() : std::string("null")));
 }
- 
- 
- 
- 
 
 // ----------------------------------------------------------------------------
 
-
-
-
-
-bool StateBoolValue::compare(EvalStack& evalTask,FCT fct, BaseValue* value)
+bool WorldStateProperties::wCompare(EvalStack& evalTask, const DefState& ds, FCT Fct, const BaseValue* Value)
 {
-	bool v;
-	BooleanVar* var = dynamic_cast<BooleanVar*>(value);
-	if (var)
+	const StateData& state = Values[stateId(ds)];
+	StateData v = evaluate(evalTask, Value);
+	if (state.AnyType && Fct != IsEqual && Fct != IsNequal)
 	{
-		v = var->getValue(evalTask);
+		throw std::domain_error("WorldStateProperties compare : bad operation !");
 	}
-	else
+	if (v.Type != state.Type)
+	{
+		// a variant state is only equal to a value of the same type
+		if (state.AnyType) return Fct == IsNequal;
+		throw std::domain_error("WorldStateProperties compare : argument type mismatch for " + ds.Group + "." + ds.State);
+	}
+	switch (state.Type)
 	{
-		FctBoolValue* fctvalue = dynamic_cast<FctBoolValue*>(value);
-		if (fctvalue)
+	case VAR_BOOL:
+		switch (Fct)
 		{
-			v = fctvalue->Value();
+		case IsEqual:  return state.B == v.B;
+		case IsNequal:  return state.B != v.B;
+		default: break;
 		}
-		else
+		break;
+	case VAR_LONG:
+		switch (Fct)
 		{
-			BoolValue* bvalue = dynamic_cast<BoolValue*>(value);
-			if (!bvalue)
-			{
-
-				throw std::domain_error("StateBoolValue compare : argument is not a boolean value");
-
-			}
-			v = bvalue->Value;
+		case IsEqual:  return state.L == v.L;
+		case IsNequal:  return state.L != v.L;
+		case Sup: return state.L > v.L;
+		case Inf: return state.L < v.L;
+		default: break;
 		}
-	}
-	switch (fct)
-	{
-	case IsEqual:  return this->Value == v;
-	case IsNequal:  return this->Value != v;
-	default:
-	{
-		throw std::domain_error("StateBoolValue compare : bad operation !");
-	}
-	}
-}
-
-
-
-void StateBoolValue::affect(EvalStack& evalTask, FCT fct, const BaseValue* value)
-{
-	bool v;
-	const BooleanVar* var = dynamic_cast<const BooleanVar*>(value);
-	if (var)
-	{
-		v = var->getValue(evalTask);
-	}
-	else
-	{
-		const FctBoolValue* fctvalue = dynamic_cast<const FctBoolValue*>(value);
-		if (fctvalue)
+		break;
+	case VAR_FLOAT:
+		switch (Fct)
 		{
-			v = fctvalue->Value();
+		case IsEqual:  return state.F == v.F;
+		case IsNequal:  return state.F != v.F;
+		case Sup: return state.F > v.F;
+		case Inf: return state.F < v.F;
+		default: break;
 		}
-		else
+		break;
+	case VAR_STRING:
+		switch (Fct)
 		{
-			const BoolValue* bvalue = dynamic_cast<const BoolValue*>(value);
-			if (!bvalue)
-			{
-
-				throw std::domain_error("StateBoolValue affect : argument is not a boolean value");
-
-			}
-			v = bvalue->Value;
+		case IsEqual:  return state.S == v.S;
+		case IsNequal:  return state.S != v.S;
+		case Sup: return _domain.symbol(state.S) > _domain.symbol(v.S);
+		case Inf: return _domain.symbol(state.S) < _domain.symbol(v.S);
+		default: break;
 		}
-	}
-#if !defined NDEBUG
-	printf("%s", v ? "true" : "false");
-#endif
-	switch (fct)
-	{
-	case Equal:   this->Value = v; break;
+		break;
+	case VAR_POINT:
+		switch (Fct)
+		{
+		case IsEqual:  return state.P[0] == v.P[0] && state.P[1] == v.P[1] && state.P[2] == v.P[2];
+		case IsNequal:  return !(state.P[0] == v.P[0] && state.P[1] == v.P[1] && state.P[2] == v.P[2]);
+		default: break;
+		}
+		break;
 	default:
-	{
-		throw std::domain_error("StateBoolValue affect : bad operation !");
-	}
+		switch (Fct)
+		{
+		case IsEqual:  return true;
+		case IsNequal:  return false;
+		default: break;
+		}
+		break;
 	}
+	throw std::domain_error("WorldStateProperties compare : bad operation !");
 }
 
- 
-
-
 // ----------------------------------------------------------------------------
 
-
-bool StateLongValue::compare(EvalStack& evalTask, FCT fct, BaseValue* value)
+namespace
 {
-	long v;
-	const LongVar* var = dynamic_cast<const LongVar*>(value);
-	if (var)
-	{
-		v = var->getValue(evalTask);
-	}
-	else
+	// typed operation of a precondition or an effect, OP_GENERIC if there is none
+	Opcode opcode(VariantType type, FCT fct)
 	{
-		FctLongValue* fctvalue = dynamic_cast<FctLongValue*>(value);
-		if (fctvalue)
+		switch (fct)
 		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-
-
-			LongValue* bvalue = dynamic_cast<LongValue*>(value);
-			if (!bvalue)
+		case IsEqual:
+			switch (type)
 			{
-				throw std::domain_error("StateLongValue compare : argument is not a Long");
+			case VAR_BOOL: return OP_BOOL_EQ;
+			case VAR_LONG: return OP_LONG_EQ;
+			case VAR_FLOAT: return OP_FLOAT_EQ;
+			case VAR_STRING: return OP_STRING_EQ;
+			case VAR_POINT: return OP_POINT_EQ;
+			default: return OP_GENERIC;
 			}
-
-			v = bvalue->Value;
+		case IsNequal:
+			switch (type)
+			{
+			case VAR_BOOL: return OP_BOOL_NE;
+			case VAR_LONG: return OP_LONG_NE;
+			case VAR_FLOAT: return OP_FLOAT_NE;
+			case VAR_STRING: return OP_STRING_NE;
+			case VAR_POINT: return OP_POINT_NE;
+			default: return OP_GENERIC;
+			}
+		// strings are ordered by their symbol : left to the generic evaluation
+		case Sup: return type == VAR_LONG ? OP_LONG_GT : type == VAR_FLOAT ? OP_FLOAT_GT : OP_GENERIC;
+		case Inf: return type == VAR_LONG ? OP_LONG_LT : type == VAR_FLOAT ? OP_FLOAT_LT : OP_GENERIC;
+		case Equal: return type != VAR_EMPTY ? OP_SET : OP_GENERIC;
+		case Incr: return type == VAR_LONG ? OP_LONG_ADD : type == VAR_FLOAT ? OP_FLOAT_ADD : type == VAR_POINT ? OP_POINT_ADD : OP_GENERIC;
+		case Decr: return type == VAR_LONG ? OP_LONG_SUB : type == VAR_FLOAT ? OP_FLOAT_SUB : type == VAR_POINT ? OP_POINT_SUB : OP_GENERIC;
+		default: return OP_GENERIC;
 		}
 	}
-	switch (fct)
-	{
-	case IsEqual:  return this->Value == v;
-	case IsNequal:  return this->Value != v;
-	case Sup: return this->Value > v;
-	case Inf:  return this->Value < v;
-	default:
+
+	// type of a typed variable, VAR_EMPTY if the value is not one
+	VariantType variableType(const BaseValue* value)
 	{
-		throw std::domain_error("StateLongValue compare : bad operation !");	 
-	}
+		if (dynamic_cast<const BooleanVar*>(value)) return VAR_BOOL;
+		if (dynamic_cast<const LongVar*>(value)) return VAR_LONG;
+		if (dynamic_cast<const FloatVar*>(value)) return VAR_FLOAT;
+		if (dynamic_cast<const StringVar*>(value)) return VAR_STRING;
+		if (dynamic_cast<const PointVar*>(value)) return VAR_POINT;
+		return VAR_EMPTY;
 	}
 }
 
-
-
-void StateLongValue::affect(EvalStack& evalTask, FCT fct, const BaseValue* value)
+Instruction WorldStateProperties::compile(const DefState& ds, FCT Fct, const BaseValue* Value)
 {
-	long v;
-	const LongVar* var = dynamic_cast<const LongVar*>(value);
-	if (var)
+	Instruction code;
+	memset(&code, 0, sizeof(code));
+	code.Op = OP_GENERIC;
+	code.State = stateId(ds);
+	code.Index = -1;
+	const StateData& state = Values[code.State];
+	// the type of a variant state changes : its operations are checked on each evaluation
+	if (state.AnyType) return code;
+
+	VariantType type = variableType(Value);
+	if (const StateValue* sv = dynamic_cast<const StateValue*>(Value))
 	{
-		v = var->getValue(evalTask);
+		code.Kind = OPERAND_STATE;
+		code.Index = stateId(sv->state);
 	}
-	else
+	else if (type != VAR_EMPTY)
 	{
-		const FctLongValue* fctvalue = dynamic_cast<const FctLongValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			const LongValue* bvalue = dynamic_cast<const LongValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StateLongValue compare : argument is not a Long");
-			}
-			v = bvalue->Value;
-		}
+		// the generic evaluation throws when the variable and the state types differ
+		if (type != state.Type) return code;
+		code.Kind = OPERAND_VARIABLE;
+		// a variable prints its name
+		code.Index = _domain.variableSlot(Value->toString());
 	}
-#if !defined NDEBUG
-	printf("%ld", v);
-#endif
-	switch (fct)
-	{
-	case Equal:   this->Value = v; break;
-	case Incr:   this->Value += v; break;
-	case Decr:   this->Value -= v; break;
-	default:
+	else if (dynamic_cast<const BoolValue*>(Value) || dynamic_cast<const LongValue*>(Value) || dynamic_cast<const FloatValue*>(Value)
+		|| dynamic_cast<const StringValue*>(Value) || dynamic_cast<const PointValue*>(Value) || dynamic_cast<const VariantValue*>(Value))
 	{
-		throw std::domain_error("StateLongValue affect : bad operation !");
+		code.Kind = OPERAND_CONST;
+		code.Const = evaluate(_domain.EvalTask, Value);
+		if (code.Const.Type != state.Type) return code;
 	}
+	else
+	{
+		// functions and variant variables
+		return code;
 	}
+	code.Type = state.Type;
+	code.Op = opcode(state.Type, Fct);
+	return code;
 }
- 
-// ----------------------------------------------------------------------------
 
+// ----------------------------------------------------------------------------
 
-bool StateFloatValue::compare(EvalStack& evalTask, FCT fct,  BaseValue* value)
+const StateData* WorldStateProperties::operand(EvalStack& evalTask, const Instruction& code) const
 {
-	float v;
-	const FloatVar* var = dynamic_cast<const FloatVar*>(value);
-	if (var)
-	{
-		v = var->getValue(evalTask);
-	}
-	else
-	{
-		FctFloatValue* fctvalue = dynamic_cast<FctFloatValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			FloatValue* bvalue = dynamic_cast<FloatValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StateFloatValue compare : argument is not a Float");
-			}
-			v = bvalue->Value;
-		}
-	}
-	switch (fct)
+	const StateData* v;
+	switch (code.Kind)
 	{
-	case IsEqual:  return this->Value == v;
-	case IsNequal:  return this->Value != v;
-	case Sup: return this->Value > v;
-	case Inf:  return this->Value < v;
-	default:
-	{
-		throw std::domain_error("StateFloatValue compare : bad operation !");
-	}
+	case OPERAND_CONST: return &code.Const;
+	case OPERAND_STATE: v = &Values[code.Index]; break;
+	default: v = evalTask.slot(code.Index); break;
 	}
+	return v && v->Type == code.Type ? v : nullptr;
 }
 
-
-
-
-void StateFloatValue::affect(EvalStack& evalTask, FCT fct, const BaseValue* value)
+bool WorldStateProperties::wCompare(EvalStack& evalTask, const Instruction& code, bool& result)
 {
-	float v;
-	const FloatVar* var = dynamic_cast<const FloatVar*>(value);
-	if (var)
+	const StateData* v = operand(evalTask, code);
+	if (!v) return false;
+	const StateData& state = Values[code.State];
+	switch (code.Op)
 	{
-		v = var->getValue(evalTask);
+	case OP_BOOL_EQ: result = state.B == v->B; break;
+	case OP_BOOL_NE: result = state.B != v->B; break;
+	case OP_LONG_EQ: result = state.L == v->L; break;
+	case OP_LONG_NE: result = state.L != v->L; break;
+	case OP_LONG_GT: result = state.L > v->L; break;
+	case OP_LONG_LT: result = state.L < v->L; break;
+	case OP_FLOAT_EQ: result = state.F == v->F; break;
+	case OP_FLOAT_NE: result = state.F != v->F; break;
+	case OP_FLOAT_GT: result = state.F > v->F; break;
+	case OP_FLOAT_LT: result = state.F < v->F; break;
+	case OP_STRING_EQ: result = state.S == v->S; break;
+	case OP_STRING_NE: result = state.S != v->S; break;
+	case OP_POINT_EQ: result = state.P[0] == v->P[0] && state.P[1] == v->P[1] && state.P[2] == v->P[2]; break;
+	case OP_POINT_NE: result = !(state.P[0] == v->P[0] && state.P[1] == v->P[1] && state.P[2] == v->P[2]); break;
+	default: return false;
 	}
-	else
+	return true;
+}
+
+bool WorldStateProperties::wSetState(EvalStack& evalTask, const Instruction& code)
+{
+	const StateData* v = operand(evalTask, code);
+	if (!v || code.Op < OP_SET) return false;
+	StateData& state = Values[code.State];
+	if (_trail)
 	{
-		const FctFloatValue* fctvalue = dynamic_cast<const FctFloatValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			const FloatValue* bvalue = dynamic_cast<const FloatValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StateFloatValue affect : argument is not a Float");
-			}
-			v = bvalue->Value;
-		}
+		_trail->push_back({ code.State, state });
 	}
+
+	HTNTrace(_domain.Name, "\tmodify state %s.%s %d ", _domain.StatesById[code.State].Group.c_str(), _domain.StatesById[code.State].State.c_str(), (int)code.Op);
 #if !defined NDEBUG
-	printf("%f", v);
+	printf("%s", toVariant(*v).toString().c_str());
 #endif
 
-	switch (fct)
-	{
-	case Equal:   this->Value = v; break;
-	case Incr:   this->Value += v; break;
-	case Decr:   this->Value -= v; break;
-	default:
+	switch (code.Op)
 	{
-		throw std::domain_error("StateFloatValue affect : bad operation !");
-	}
+	case OP_SET: state = *v; state.AnyType = false; break;
+	case OP_LONG_ADD: state.L += v->L; break;
+	case OP_LONG_SUB: state.L -= v->L; break;
+	case OP_FLOAT_ADD: state.F += v->F; break;
+	case OP_FLOAT_SUB: state.F -= v->F; break;
+	case OP_POINT_ADD: state.P[0] += v->P[0]; state.P[1] += v->P[1]; state.P[2] += v->P[2]; break;
+	case OP_POINT_SUB: state.P[0] -= v->P[0]; state.P[1] -= v->P[1]; state.P[2] -= v->P[2]; break;
+	default: break;
 	}
+	setIsModified(true);
+	return true;
 }
 
-
 // ----------------------------------------------------------------------------
 
-
-
-
-bool StateStringValue::compare(EvalStack& evalTask, FCT fct,  BaseValue* value)
+bool WorldStateProperties::wSetState(const std::string& group, const std::string& state, FCT Fct,const BaseValue& Value)
 {
-	std::string v;
-	StringVar* var = dynamic_cast<StringVar*>(value);
-	if (var)
-	{
-		v = var->getValue(evalTask);
-	}
-	else
-	{
-		FctStringValue* fctvalue = dynamic_cast<FctStringValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			StringValue* bvalue = dynamic_cast<StringValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StateStringValue compare : argument is not a String");
-			}
-			v = bvalue->Value;
-		}
-	}
-	switch (fct)
-	{
-	case IsEqual:  return !this->Value.compare(v);
-	case IsNequal:  return this->Value.compare(v);
-	case Sup: return this->Value > v;
-	case Inf:  return this->Value < v;
-	default:
-	{
-		throw std::domain_error("StateStringValue compare : bad operation !");
-	}
-	}
+	return wSetState(DefState(group, state), Fct, Value);
 }
 
+// ----------------------------------------------------------------------------
 
-void StateStringValue::affect(EvalStack& evalTask, FCT fct, const BaseValue* value)
+bool WorldStateProperties::wSetState(const DefState& ds, FCT Fct, const BaseValue& Value)
 {
-	std::string v;
-
-	const StringVar* var = dynamic_cast<const StringVar*>(value);
-	if (var)
+	int id = stateId(ds);
+	StateData& state = Values[id];
+	StateData v = evaluate(_domain.EvalTask, &Value);
+	if (_trail)
 	{
-		v = var->getValue(evalTask);
+		_trail->push_back({ id, state });
 	}
-	else
+
+	HTNTrace(_domain.Name, "\tmodify state %s.%s %s ", ds.Group.c_str(), ds.State.c_str(), FctLib::toString(Fct).c_str());
+#if !defined NDEBUG
+	printf("%s", toVariant(v).toString().c_str());
+#endif
+
+	if (state.AnyType)
 	{
-		const FctStringValue* fctvalue = dynamic_cast<const FctStringValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
+		// the type of a variant state follows the assigned value
+		if (Fct != Equal)
 		{
-			const StringValue* bvalue = dynamic_cast<const StringValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StateStringValue affect : argument is not a String");
-			}
-			v = bvalue->Value;
+			throw std::domain_error("WorldStateProperties affect : bad operation !");
 		}
+		state = v;
+		state.AnyType = true;
+		setIsModified(true);
+		return true;
 	}
-#if !defined NDEBUG
-	printf("%s", v.c_str());
-#endif
-	switch (fct)
-	{
-	case Equal:   this->Value = v; break;
-	default:
+	if (v.Type != state.Type)
 	{
-		throw std::domain_error("StateStringValue affect : bad operation !");
+		throw std::domain_error("WorldStateProperties affect : argument type mismatch for " + ds.Group + "." + ds.State);
 	}
-	}
-}
-
-
-// ----------------------------------------------------------------------------
-
-
-bool StatePointValue::compare(EvalStack& evalTask, FCT fct, BaseValue* value)
-{
-	Point v;
-	const PointVar* var = dynamic_cast<const PointVar*>(value);
-	if (var)
+	switch (Fct)
 	{
-		v = var->getValue(evalTask);
-	}
-	else
+	case Equal:
+		state = v;
+		break;
+	case Incr:
+	case Decr:
 	{
-		FctPointValue* fctvalue = dynamic_cast<FctPointValue*>(value);
-		if (fctvalue)
+		float sign = Fct == Incr ? 1.f : -1.f;
+		switch (state.Type)
 		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			PointValue* bvalue = dynamic_cast<PointValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StatePointValue compare : argument is not a Point");
-			}
-			v = bvalue->Value;
+		case VAR_LONG: state.L += Fct == Incr ? v.L : -v.L; break;
+		case VAR_FLOAT: state.F += sign * v.F; break;
+		case VAR_POINT: state.P[0] += sign * v.P[0]; state.P[1] += sign * v.P[1]; state.P[2] += sign * v.P[2]; break;
+		default: throw std::domain_error("WorldStateProperties affect : bad operation !");
 		}
+		break;
 	}
-	switch (fct)
-	{
-	case IsEqual:  return (this->Value == v);
-	case IsNequal:    return !(this->Value == v);
 	default:
-	{
-		throw std::domain_error("StatePointValue compare : bad operation !");	 
-	}
+		throw std::domain_error("WorldStateProperties affect : bad operation !");
 	}
-}
 
+	setIsModified(true);
+	return true;
+}
+ 
 
+// ----------------------------------------------------------------------------
 
-void StatePointValue::affect(EvalStack& evalTask, FCT fct, const BaseValue* value)
+void WorldStateProperties::undo(std::vector<StateUndo>& trail, size_t mark)
 {
-	Point v;
-	const PointVar* var = dynamic_cast<const PointVar*>(value);
-	if (var)
-	{
-		v = var->getValue(evalTask);
-	}
-	else
-	{
-		const FctPointValue* fctvalue = dynamic_cast<const FctPointValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			const PointValue* bvalue = dynamic_cast<const PointValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StatePointValue compare : argument is not a Point");
-			}
-			v = bvalue->Value;
-		}
-	}
-#if !defined NDEBUG
-	printf("%s", v.toString().c_str());
-#endif
-	switch (fct)
+	while (trail.size() > mark)
 	{
-	case Equal:  this->Value = v;  break;
-	case Incr:   this->Value.X += v.X; this->Value.Y +=v.Y; this->Value.Z += v.Z; break;
-	case Decr:   this->Value.X -= v.X; this->Value.Y -= v.Y; this->Value.Z -= v.Z; break;
-	default:
-	{
-		throw std::domain_error("StatePointValue affect : bad operation !");
-	}
+		const StateUndo& u = trail.back();
+		Values[u.Id] = u.Value;
+		trail.pop_back();
 	}
 }
 
-
-
-
+// ----------------------------------------------------------------------------
+// StateGroup
 // ----------------------------------------------------------------------------
 
-
-bool StateVariantValue::compare(EvalStack& evalTask, FCT fct, BaseValue* value)
+BaseState* StateGroup::getState(const std::string& state)
 {
-	Variant v;
-	const VariantVar* var = dynamic_cast<const VariantVar*>(value);
-	if (var)
-	{
-		v = var->getValue(evalTask);
-	}
-	else
-	{
-		FctVariantValue* fctvalue = dynamic_cast<FctVariantValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			VariantValue* bvalue = dynamic_cast<VariantValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StateVariantValue compare : argument is not a Variant");
-			}
-			v = bvalue->Value;
-		}
-	}
-	switch (fct)
-	{
-	case IsEqual:  return (this->Value == v);
-	case IsNequal:    return !(this->Value == v);
-	default:
+	if (States.find(state) != States.end())
 	{
-		throw std::domain_error("StateVariantValue compare : bad operation !");
-	}
+		return  States[state];
 	}
+	return nullptr;
 }
 
+ 
+StateGroup::~StateGroup()
+{
+	 
+}
 
 
-void StateVariantValue::affect(EvalStack& evalTask, FCT fct, const BaseValue* value)
+void StateGroup::free()
 {
-	Variant v;
-	const VariantVar* var = dynamic_cast<const VariantVar*>(value);
-	if (var)
-	{
-		v = var->getValue(evalTask);
-	}
-	else
-	{
-		const FctVariantValue* fctvalue = dynamic_cast<const FctVariantValue*>(value);
-		if (fctvalue)
-		{
-			v = fctvalue->Value();
-		}
-		else
-		{
-			const VariantValue* bvalue = dynamic_cast<const VariantValue*>(value);
-			if (!bvalue)
-			{
-				throw std::domain_error("StateVariantValue compare : argument is not a Point");
-			}
-			v = bvalue->Value;
-		}
-	}
-#if !defined NDEBUG
-	printf("%s", v.toString().c_str());
-#endif
-	switch (fct)
-	{
-	case Equal:  this->Value = v;  break;
- 	default:
-	{
-		throw std::domain_error("StateVariantValue affect : bad operation !");
-	}
-	}
+	std::for_each(States.begin(), States.end(),
+		[&](std::pair<const std::string, BaseState*>  &element) {
+		delete element.second;
+		element.second = nullptr;
+	});
 }
 
 
+void StateGroup::clone(const StateGroup& sg)
+{
+	std::for_each(sg.States.begin(), sg.States.end(),
+		[&](const std::pair<const std::string, BaseState*>  &element) {
 
+		States[element.first] = element.second->clone();
 
-
+	});
+}
+ 
+ 
+ 
+ 
 
 // ----------------------------------------------------------------------------
 // Variables
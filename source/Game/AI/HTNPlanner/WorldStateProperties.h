@@ -41,12 +41,11 @@ namespace HTN
 	class EvalStack;
 	struct Domain;
 
-	// basic state
+	// basic state : declares a state and its initial value (see WorldStateProperties::compile)
 	struct BaseState
 	{
 		virtual ~BaseState() {}
-		virtual bool compare(EvalStack&, FCT, BaseValue*) { return false; }
-		virtual void affect(EvalStack&, FCT,const  BaseValue*) {}
+		virtual Variant value() const { return Variant(); }
 		virtual BaseState* clone() const { return new BaseState(); }
 	};
 
@@ -56,8 +55,7 @@ namespace HTN
 	{
 		StateBoolValue(bool v) : BoolValue(v) {}
 		virtual ~StateBoolValue() {}
-		virtual bool compare(EvalStack& evalTask, FCT fct, BaseValue* value);
-		virtual void affect(EvalStack& evalTask, FCT fct, const BaseValue* value);
+		virtual Variant value() const { return Variant(Value); }
 		virtual StateBoolValue* clone() const { return new StateBoolValue(Value); }
 	};
 
@@ -66,8 +64,7 @@ namespace HTN
 	{
 		StateLongValue(long v) : LongValue(v) {}
 		virtual ~StateLongValue() {}
-		virtual bool compare(EvalStack& evalTask, FCT fct, BaseValue* value);
-		virtual void affect(EvalStack& evalTask, FCT fct, const BaseValue* value);
+		virtual Variant value() const { return Variant(Value); }
 		virtual StateLongValue* clone() const { return new StateLongValue(Value); }
 	};
 
@@ -76,8 +73,7 @@ namespace HTN
 	{
 		StateFloatValue(float v) : FloatValue(v) {}
 		virtual ~StateFloatValue() {}
-		virtual bool compare(EvalStack& evalTask, FCT fct, BaseValue* value);
-		virtual void affect(EvalStack& evalTask, FCT fct, const  BaseValue* value);
+		virtual Variant value() const { return Variant(Value); }
 		virtual StateFloatValue* clone() const { return new StateFloatValue(Value); }
 	};
 	 
@@ -86,8 +82,7 @@ namespace HTN
 	{
 		explicit StateStringValue(const std::string& v) : StringValue(v) {}
 		virtual ~StateStringValue() {}
-		virtual bool compare(EvalStack& evalTask, FCT fct, BaseValue* value);
-		virtual void affect(EvalStack& evalTask, FCT fct, const BaseValue* value);
+		virtual Variant value() const { return Variant(Value); }
 		virtual StateStringValue* clone() const { return new StateStringValue(Value); }
 	};
 
@@ -97,18 +92,16 @@ namespace HTN
 	{
 		StatePointValue(float x,float y,float z) : PointValue(x,y,z) {}
 		virtual ~StatePointValue() {}
-		virtual bool compare(EvalStack& evalTask, FCT fct, BaseValue* value);
-		virtual void affect(EvalStack& evalTask, FCT fct, const BaseValue* value);
+		virtual Variant value() const { return Variant(Value); }
 		virtual StatePointValue* clone() const { return new StatePointValue(Value.X,Value.Y,Value.Z); }
 	};
 
-	// State which can hold a Variant value
+	// State which can hold a Variant value (its type follows the assigned values)
 	struct StateVariantValue : VariantValue, BaseState
 	{
 		StateVariantValue(const Variant&v ) : VariantValue(v) {}
 		virtual ~StateVariantValue() {}
-		virtual bool compare(EvalStack& evalTask, FCT fct, BaseValue* value);
-		virtual void affect(EvalStack& evalTask, FCT fct, const BaseValue* value);
+		virtual Variant value() const { return Value; }
 		virtual StateVariantValue* clone() const { return new StateVariantValue(Value); }
 	};
 
@@ -134,12 +127,15 @@ namespace HTN
 	struct DefState
 	{
 		DefState(const std::string& group, const std::string& state)
-			: Group(group),State(state)
+			: Group(group),State(state), GroupId(-1), Id(-1)
 		{}
 		std::string toString() { return "ds[" + Group + "," + State + "]"; }
 
 		std::string Group;
 		std::string State;
+		// interned identifiers, resolved by Domain::compile (-1 before)
+		int GroupId;
+		int Id;
 	};
 
 	// Hold a state value
@@ -153,21 +149,96 @@ namespace HTN
 	};
 
 
+	// value of a state, stored in place in the world state. It is trivially copyable,
+	// so a whole world state is copied with a single memcpy. Strings are interned
+	// by the domain (see Domain::intern)
+	struct StateData
+	{
+		// type of the value
+		VariantType Type;
+		// true for a variant state, whose type follows the assigned value
+		bool AnyType;
+		union
+		{
+			bool B;
+			long L;
+			float F;
+			long S;
+			float P[3];
+		};
+	};
+
+
+	// previous value of a state, recorded so that a change can be undone (see Planner)
+	struct StateUndo
+	{
+		int Id;
+		StateData Value;
+	};
+
+
+	// operation of a compiled precondition or effect, for the type of its state (see WorldStateProperties::compile)
+	enum Opcode
+	{
+		// evaluated by the generic wCompare / wSetState (variant state, function operand...)
+		OP_GENERIC,
+		// preconditions
+		OP_BOOL_EQ, OP_BOOL_NE,
+		OP_LONG_EQ, OP_LONG_NE, OP_LONG_GT, OP_LONG_LT,
+		OP_FLOAT_EQ, OP_FLOAT_NE, OP_FLOAT_GT, OP_FLOAT_LT,
+		OP_STRING_EQ, OP_STRING_NE,
+		OP_POINT_EQ, OP_POINT_NE,
+		// effects
+		OP_SET,
+		OP_LONG_ADD, OP_LONG_SUB,
+		OP_FLOAT_ADD, OP_FLOAT_SUB,
+		OP_POINT_ADD, OP_POINT_SUB,
+	};
+
+	// where the operand of a compiled precondition or effect is read
+	enum OperandKind
+	{
+		OPERAND_CONST,
+		OPERAND_STATE,
+		OPERAND_VARIABLE,
+	};
+
+	// precondition or effect compiled once the states are known : the operation is chosen
+	// from the type of the state and the operand is resolved to a constant, a state or a variable slot
+	struct Instruction
+	{
+		Opcode Op;
+		// state compared or changed
+		int State;
+		OperandKind Kind;
+		// state identifier or variable slot (see Domain::variableSlot) of the operand
+		int Index;
+		// type the operand must have, otherwise the generic evaluation is used
+		VariantType Type;
+		// value of a constant operand
+		StateData Const;
+	};
+
+
 	typedef std::map<std::string, StateGroup> WorldStateMap;
 
 	// The world state is essentially a vector of properties that describe what our
 	// HTN is going to reason about
 	struct WorldStateProperties
 	{
-		WorldStateProperties(Domain& domain ) : _domain(domain),_isModified(false) {}
+		WorldStateProperties(Domain& domain ) : _domain(domain),_isModified(false),_trail(nullptr) {}
 	 	~WorldStateProperties();
 		// free memory
 		void free();
 		// free memory
 		void clone(WorldStateProperties& wsp);
+		// convert the declared states into values, in the order of their identifiers (see Domain::compile)
+		void compile(const std::vector<DefState>& states);
 
 		// sets an existing state with a given value
 		bool wSetState(const std::string& group, const std::string& state, FCT Fct, const BaseValue& Value);
+		// sets an existing state with a given value
+		bool wSetState(const DefState& state, FCT Fct, const BaseValue& Value);
 		// helper mehtod which set an existing state with a given boolean value
 		bool wSetState(const std::string& group, const std::string& state, bool value);
 		// helper mehtod which set an existing state with a given long value
@@ -179,66 +250,88 @@ namespace HTN
 		// helper mehtod which set an existing state with a given point value
 		bool wSetState(const std::string& group, const std::string& state, const Point& value);
 
-		// gets a state of a given group
-		BaseState* wState(const std::string& group, const std::string& state);
-	
-			 
-		
-		// template version of wstate which returns the value of state directly
-		template <typename T>
-		T wStateAs(const std::string& group, const std::string& state)
-		{
-			BaseState* bs = wState(group, state);
-			if (!bs)
-			{
-				throw std::domain_error("wStateAs : state does not exist : " + group + "." + state);
-			}
-			const T* sv = dynamic_cast<const T*>(bs);
-			if (!sv)
-			{
-				throw std::domain_error("wStateAs :  " + group + "." + state + " bad type");
-			}
-			return sv->Value;
-		}
+		// record the previous value of every modified state in the given trail (nullptr to stop recording)
+		void setTrail(std::vector<StateUndo>* trail) { _trail = trail; }
+		// restore the values recorded in the trail after mark, most recent first, and shrink the trail to mark
+		void undo(std::vector<StateUndo>& trail, size_t mark);
+
+		// compare a state with a value (precondition)
+		bool wCompare(EvalStack& evalTask, const DefState& state, FCT Fct, const BaseValue* Value);
 
+		// compile a precondition or an effect of a state (compiled domain only)
+		Instruction compile(const DefState& state, FCT Fct, const BaseValue* Value);
+		// evaluate a compiled precondition; false if it must be evaluated by the generic wCompare
+		bool wCompare(EvalStack& evalTask, const Instruction& code, bool& result);
+		// apply a compiled effect; false if it must be applied by the generic wSetState
+		bool wSetState(EvalStack& evalTask, const Instruction& code);
+
+		// gets the value of a state of a given group
+		Variant wStateAsVariant(const std::string& group, const std::string& state);
+		// gets the value of a state from its interned identifier (compiled domain only)
+		StateData& wState(int id) { return Values[id]; }
+			 
 		// returns the value of boolean state 
 		bool wStateAsBool(const std::string& group, const std::string& state)
 		{
-			return wStateAs<BoolValue>(group, state).Value;
+			return wStateAsVariant(group, state).AsBoolean();
 		}
 		// returns the float value of state 
 		float wStateAsFloat(const std::string& group, const std::string& state)
 		{
-			return wStateAs<FloatValue>(group, state).Value;
+			return wStateAsVariant(group, state).asFloat();
 		}
 		// returns the Long value of state 
 		long wStateAsLong(const std::string& group, const std::string& state)
 		{
-			return wStateAs<LongValue>(group, state).Value;
+			return wStateAsVariant(group, state).asLong();
 		}
 		// returns the Long value of state 
 		std::string wStateAsString(const std::string& group, const std::string& state)
 		{
-			return wStateAs<StringValue>(group, state).Value;
+			return wStateAsVariant(group, state).asString();
 		}
 		// returns the Point value of state 
 		Point wStateAsPoint(const std::string& group, const std::string& state)
 		{
-			return wStateAs<PointValue>(group, state).Value;
+			return wStateAsVariant(group, state).asPoint();
 		}
 		// modification of the flag which indicates if the state is changed
 		void setIsModified(bool modified) { _isModified = modified; }
 		// test if the state is modified
 		bool isModified() const { return _isModified;  }
 
-	 		 
+		// hash of all the values, stable from one run to the other (compiled domain only)
+		size_t hash() const;
+		// hash of the values of some states
+		size_t hash(const std::vector<int>& ids) const;
+		// hash of a value
+		static size_t hash(size_t seed, const StateData& data);
+		// true if two values are the same
+		static bool equals(const StateData& a, const StateData& b);
 
-		// all states of the world
+		// convert a value to / from a variant
+		Variant toVariant(const StateData& data) const;
+		StateData toData(const Variant& variant) const;
+
+	protected:
+		// identifier of a state, throw if it does not exist or if the domain is not compiled
+		int stateId(const DefState& state) const;
+		// evaluate an operand (constant, variable, function or state)
+		StateData evaluate(EvalStack& evalTask, const BaseValue* value);
+		// operand of a compiled instruction, nullptr if it does not have the expected type
+		const StateData* operand(EvalStack& evalTask, const Instruction& code) const;
+
+	public:
+		// all states of the world, as declared by the user (emptied by compile)
 		WorldStateMap CurrentWorldState;
+		// value of all states of the world indexed by their identifier, once the domain is compiled
+		std::vector<StateData> Values;
 		// indicates if state is changed
 		bool _isModified;
 		// domain associated with states
 		Domain& _domain;
+		// undo log of the modified states, if any
+		std::vector<StateUndo>* _trail;
 
 	};
 
@@ -246,4 +339,3 @@ namespace HTN
 	typedef WorldStateProperties WStates;
 
 }
-
@@ -0,0 +1,99 @@
+
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+
+namespace SubWorld
+{
+
+	// intrusive multiple producers, single consumer queue (as HTN::CompletionQueue) : any thread pushes without
+	// locking, only one thread pops. Node is default constructible and has a std::atomic<Node*> Next; the queue owns
+	// the nodes from push to pop
+	template <class Node>
+	class MPSCQueue
+	{
+	public:
+		MPSCQueue() : _head(&_stub), _tail(&_stub) {}
+		~MPSCQueue()
+		{
+			// free the nodes not popped
+			while (pop());
+		}
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		// add a node after the last one
+		void push(Node* node)
+		{
+			node->Next.store(nullptr, std::memory_order_relaxed);
+			Node* previous = _head.exchange(node, std::memory_order_acq_rel);
+			// until this store, the consumer sees the queue as ending before node
+			previous->Next.store(node, std::memory_order_release);
+		}
+
+		// remove the oldest node, nullptr if there is none or if the next one is still being linked
+		std::unique_ptr<Node> pop()
+		{
+			Node* tail = _tail;
+			Node* next = tail->Next.load(std::memory_order_acquire);
+			if (tail == &_stub)
+			{
+				if (!next) return nullptr;
+				_tail = next;
+				tail = next;
+				next = next->Next.load(std::memory_order_acquire);
+			}
+			if (!next)
+			{
+				if (tail != _head.load(std::memory_order_acquire)) return nullptr;
+				// tail is the last node : the stub takes its place so that it can be removed
+				push(&_stub);
+				next = tail->Next.load(std::memory_order_acquire);
+				if (!next) return nullptr;
+			}
+			_tail = next;
+			return std::unique_ptr<Node>(tail);
+		}
+
+	protected:
+		// last node pushed
+		std::atomic<Node*> _head;
+		// next node to pop
+		Node* _tail;
+		// placeholder queued when the last node is popped : the queue is never empty
+		Node _stub;
+	};
+
+}
@@ -33,9 +33,13 @@
 
 #include "Reasoner.h"
 #include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
 extern "C"
 {
 #include "../AI/CLIPS/clips.h"
+#include "../AI/CLIPS/proflfun.h"
 }
 
 // ----------------------------------------------------------------------------
@@ -44,12 +48,53 @@ using namespace SubWorld;
 
 // ----------------------------------------------------------------------------
 
+namespace
+{
+	// deftemplate of a typed fact and the slots set by the Reasoner
+	struct TemplateSlots
+	{
+		const char* Name;
+		std::vector<const char*> Slots;
+	};
+
+	// by Reasoner::FactTemplate
+	const TemplateSlots typedTemplates[] =
+	{
+		{ "enemy", { "id", "x", "y", "z", "distance" } },
+		{ "resource", { "id", "x", "y", "z", "distance" } },
+		{ "team", { "id", "tactical-activity", "units" } },
+		{ "situation_awareness", { "level", "strategy", "team-response", "enemy-is-near" } },
+	};
+
+	// JSON string of a rule or module name : CLIPS symbols have no quote, but may have a backslash
+	std::string quoted(const std::string& name)
+	{
+		std::string text = "\"";
+		for (char c : name)
+		{
+			if (c == '\\') text += '\\';
+			text += c;
+		}
+		return text + "\"";
+	}
+}
+
+// ----------------------------------------------------------------------------
+
 
 Reasoner::Reasoner()
-	: _thread(&Reasoner::run,this), _theEnv(CreateEnvironment())
+	: _theEnv(CreateEnvironment())
 {
+	EnvAddBeforeRunFunctionWithContext(_theEnv, "reasoner-deadline", &Reasoner::checkDeadline, 0, this);
+}
 
 
+Reasoner::Reasoner(const HashSizes& sizes)
+	: _theEnv(CreateSizedEnvironment(sizes.Symbols, sizes.Floats, sizes.Integers, sizes.BitMaps))
+{
+	// no fact yet : the fact table is only reallocated
+	EnvSetFactHashSize(_theEnv, sizes.Facts);
+	EnvAddBeforeRunFunctionWithContext(_theEnv, "reasoner-deadline", &Reasoner::checkDeadline, 0, this);
 }
 
 // ----------------------------------------------------------------------------
@@ -57,33 +102,158 @@ Reasoner::Reasoner()
 
 Reasoner::~Reasoner()
 {
+	stop();
+	if (!_profile_file.empty())
+	{
+		exportProfile(_profile_file.c_str(), _profile_format);
+	}
 	if (_theEnv)
 	{
 		DestroyEnvironment(_theEnv);
 	}
-	_stop_thread = true;
-	if (_thread.joinable())
-		_thread.join();
 }
 
 
 // ----------------------------------------------------------------------------
 
 
+void Reasoner::start()
+{
+	if (_thread.joinable()) return;
+	_stop_thread = false;
+	_thread = std::thread(&Reasoner::run, this);
+}
+
+
+void Reasoner::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_wakeup_mutex);
+		_stop_thread = true;
+	}
+	_wakeup.notify_one();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+
 void Reasoner::run()
 {
-	std::this_thread::sleep_for(std::chrono::seconds(1));
-	
-	// Print thread ID
-	std::cout << "Reasoner Thread ID : " << std::this_thread::get_id() << "\n";
 	initKnowledge();
-	while (!_stop_thread)
+	// true while the firing budget leaves activations on the agenda
+	bool agenda = false;
+	while (true)
 	{
-		std::cout << "Reasoner Thread ID : " << std::this_thread::get_id() << "\n";
-		std::this_thread::sleep_for(std::chrono::seconds(1));
+		{
+			std::unique_lock<std::mutex> lock(_wakeup_mutex);
+			_wakeup.wait(lock, [this, agenda]() { return agenda || _pending.load() || _stop_thread.load(); });
+			if (_stop_thread) break;
+		}
+		// cleared before the facts are popped : a later push wakes the thread again
+		_pending = false;
+		applyUpdates();
+		// bounded by the budgets : the facts pushed meanwhile are applied before the activations left fire
+		infer(_firing_budget);
+		agenda = hasActivations();
 	}
 }
 
+
+long long Reasoner::infer(long long firings)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	_deadline = _time_budget.count() > 0 ? start + _time_budget : std::chrono::steady_clock::time_point::max();
+	_deadline_reached = false;
+	_started_firings = 0;
+	long long fired = EnvRun(_theEnv, firings);
+	InferenceStats stats;
+	stats.Firings = fired;
+	stats.FiringBudgetReached = firings >= 0 && fired == firings;
+	stats.TimeBudgetReached = _deadline_reached;
+	if (_deadline_reached)
+	{
+		stats.Overrun = std::chrono::duration<double>(std::chrono::steady_clock::now() - _deadline).count();
+	}
+	if (fired > 0)
+	{
+		conclude(fired);
+	}
+	countDeferred(stats);
+	stats.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	_last_inference = stats;
+	_inference_totals.Inferences++;
+	_inference_totals.Deferring += stats.Deferred > 0;
+	_inference_totals.Firings += fired;
+	_inference_totals.Seconds += stats.Seconds;
+	_inference_totals.MaxSeconds = std::max(_inference_totals.MaxSeconds, stats.Seconds);
+	_inference_totals.MaxOverrun = std::max(_inference_totals.MaxOverrun, stats.Overrun);
+	_inference_totals.MaxDeferred = std::max(_inference_totals.MaxDeferred, stats.Deferred);
+	_inference_totals.MaxUrgentDeferred = std::max(_inference_totals.MaxUrgentDeferred, stats.UrgentDeferred);
+	return fired;
+}
+
+
+void Reasoner::checkDeadline(void* theEnv, void*)
+{
+	Reasoner* reasoner = (Reasoner*)GetEnvironmentCallbackContext(theEnv);
+	// the first rule always fires, or a budget spent before it would defer the agenda forever
+	if (reasoner->_started_firings++ > 0 && reasoner->_time_budget.count() > 0 && std::chrono::steady_clock::now() >= reasoner->_deadline)
+	{
+		// EnvRun leaves the activation on the agenda, and clears the flag on return
+		reasoner->_deadline_reached = true;
+		EnvSetHaltRules(theEnv, TRUE);
+	}
+}
+
+
+void Reasoner::countDeferred(InferenceStats& stats)
+{
+	stats.Deferred = GetNumberOfActivations(_theEnv);
+	if (stats.Deferred == 0) return;
+	void* current = EnvGetCurrentModule(_theEnv);
+	for (void* module = EnvGetNextDefmodule(_theEnv, NULL); module != NULL; module = EnvGetNextDefmodule(_theEnv, module))
+	{
+		EnvSetCurrentModule(_theEnv, module);
+		// an agenda is sorted by salience, the urgent activations first
+		for (void* activation = EnvGetNextActivation(_theEnv, NULL); activation != NULL; activation = EnvGetNextActivation(_theEnv, activation))
+		{
+			if (EnvGetActivationSalience(_theEnv, activation) < _urgent_salience) break;
+			stats.UrgentDeferred++;
+		}
+	}
+	EnvSetCurrentModule(_theEnv, current);
+}
+
+
+Reasoner::InferenceStats Reasoner::lastInference()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	return _last_inference;
+}
+
+
+Reasoner::InferenceTotals Reasoner::inferenceTotals()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	return _inference_totals;
+}
+
+
+bool Reasoner::hasActivations()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	return EnvGetNextActivation(_theEnv, NULL) != NULL;
+}
+
+
+long long Reasoner::memoryUsed()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	return EnvMemUsed(_theEnv);
+}
+
 // ----------------------------------------------------------------------------
 /*
 
@@ -113,7 +283,7 @@ void Reasoner::def(char *templateDef)
 void Reasoner::fact(char *f, char * r, char *v)
 {
 	char buff[255];
-	sprintf(buff,"(%s (%s \"%s\")",f,r,v);
+	sprintf(buff,"(%s (%s \"%s\"))",f,r,v);
 	EnvAssertString(_theEnv, buff);
 }
 
@@ -121,18 +291,594 @@ void Reasoner::fact(char *f, char * r, char *v)
 void Reasoner::fact(char *f, char * r, long v)
 {
 	char buff[255];
-	sprintf(buff, "(%s (%s %ld)", f, r, v);
+	sprintf(buff, "(%s (%s %ld))", f, r, v);
 	EnvAssertString(_theEnv, buff);
 }
 
 void Reasoner::fact(char *f, char * r, float v)
 {
 	char buff[255];
-	sprintf(buff, "(%s (%s %f)", f, r, v);
+	sprintf(buff, "(%s (%s %f))", f, r, v);
 	EnvAssertString(_theEnv, buff);
 }
 
 // ----------------------------------------------------------------------------
+
+
+bool Reasoner::load(const char* file)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	// 0 : file not found, -1 : some constructs did not parse
+	if (EnvLoad(_theEnv, file) == 0) return false;
+	return bindTemplates();
+}
+
+
+bool Reasoner::loadImage(const char* image)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	// the image replaces all the constructs and facts
+	for (OwnerShadows* owners : { &_enemies, &_resources })
+	{
+		for (auto& shadows : *owners)
+		{
+			for (auto& shadow : shadows.second)
+			{
+				retractSighting(shadow.second.Fact);
+			}
+		}
+		owners->clear();
+	}
+	_concluded.clear();
+	if (!EnvBload(_theEnv, image)) return false;
+	return bindTemplates();
+}
+
+
+bool Reasoner::save(const char* image)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	return EnvBsave(_theEnv, image) != 0;
+}
+
+
+bool Reasoner::compile(const char* file, const char* image)
+{
+	void* theEnv = CreateEnvironment();
+	// as load, constructs which did not parse are reported and left out
+	bool compiled = EnvLoad(theEnv, file) != 0 && EnvBsave(theEnv, image) != 0;
+	DestroyEnvironment(theEnv);
+	return compiled;
+}
+
+
+bool Reasoner::bindTemplates()
+{
+	bool bound = true;
+	for (int t = 0; t < FACT_TEMPLATES; t++)
+	{
+		void* deftemplate = EnvFindDeftemplate(_theEnv, typedTemplates[t].Name);
+		for (const char* slot : typedTemplates[t].Slots)
+		{
+			if (deftemplate && !EnvDeftemplateSlotExistP(_theEnv, deftemplate, slot))
+			{
+				deftemplate = nullptr;
+			}
+		}
+		_templates[t] = deftemplate;
+		_owned[t] = deftemplate && EnvDeftemplateSlotExistP(_theEnv, deftemplate, "owner");
+		bound = bound && deftemplate;
+	}
+	return bound;
+}
+
+// ----------------------------------------------------------------------------
+
+
+void* Reasoner::createFact(FactTemplate which)
+{
+	return _templates[which] ? EnvCreateFact(_theEnv, _templates[which]) : nullptr;
+}
+
+
+bool Reasoner::putOwner(FactTemplate which, void* fact, long owner)
+{
+	return !_owned[which] || putSlot(fact, "owner", owner);
+}
+
+
+bool Reasoner::putSlot(void* fact, const char* slot, long value)
+{
+	DATA_OBJECT theValue;
+	SetType(theValue, INTEGER);
+	SetValue(theValue, EnvAddLong(_theEnv, value));
+	return EnvPutFactSlot(_theEnv, fact, slot, &theValue) != 0;
+}
+
+
+bool Reasoner::putSlot(void* fact, const char* slot, float value)
+{
+	DATA_OBJECT theValue;
+	SetType(theValue, FLOAT);
+	SetValue(theValue, EnvAddDouble(_theEnv, value));
+	return EnvPutFactSlot(_theEnv, fact, slot, &theValue) != 0;
+}
+
+
+bool Reasoner::putSlot(void* fact, const char* slot, const char* symbol)
+{
+	DATA_OBJECT theValue;
+	SetType(theValue, SYMBOL);
+	SetValue(theValue, EnvAddSymbol(_theEnv, symbol));
+	return EnvPutFactSlot(_theEnv, fact, slot, &theValue) != 0;
+}
+
+
+bool Reasoner::putSlot(void* fact, const char* slot, const std::vector<long>& values)
+{
+	void* multifield = EnvCreateMultifield(_theEnv, (long)values.size());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		SetMFType(multifield, i + 1, INTEGER);
+		SetMFValue(multifield, i + 1, EnvAddLong(_theEnv, values[i]));
+	}
+	DATA_OBJECT theValue;
+	SetType(theValue, MULTIFIELD);
+	SetValue(theValue, multifield);
+	SetDOBegin(theValue, 1);
+	SetDOEnd(theValue, (long)values.size());
+	return EnvPutFactSlot(_theEnv, fact, slot, &theValue) != 0;
+}
+
+
+void* Reasoner::assertFact(void* fact, bool filled)
+{
+	if (!filled)
+	{
+		ReturnFact(_theEnv, (struct fact*)fact);
+		return nullptr;
+	}
+	EnvAssignFactSlotDefaults(_theEnv, fact);
+	return EnvAssert(_theEnv, fact);
+}
+
+// ----------------------------------------------------------------------------
+
+
+bool Reasoner::enemy(long id, float x, float y, float z, float distance, long owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	void* theFact = createFact(ENEMY_FACT);
+	if (!theFact) return false;
+	return assertFact(theFact, putOwner(ENEMY_FACT, theFact, owner) && putSlot(theFact, "id", id) && putSlot(theFact, "x", x) && putSlot(theFact, "y", y)
+		&& putSlot(theFact, "z", z) && putSlot(theFact, "distance", distance)) != nullptr;
+}
+
+
+bool Reasoner::resource(long id, float x, float y, float z, float distance, long owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	void* theFact = createFact(RESOURCE_FACT);
+	if (!theFact) return false;
+	return assertFact(theFact, putOwner(RESOURCE_FACT, theFact, owner) && putSlot(theFact, "id", id) && putSlot(theFact, "x", x) && putSlot(theFact, "y", y)
+		&& putSlot(theFact, "z", z) && putSlot(theFact, "distance", distance)) != nullptr;
+}
+
+
+bool Reasoner::team(long id, const char* tacticalActivity, const std::vector<long>& units, long owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	void* theFact = createFact(TEAM_FACT);
+	if (!theFact) return false;
+	return assertFact(theFact, putOwner(TEAM_FACT, theFact, owner) && putSlot(theFact, "id", id) && putSlot(theFact, "tactical-activity", tacticalActivity)
+		&& putSlot(theFact, "units", units)) != nullptr;
+}
+
+
+bool Reasoner::situationAwareness(const char* level, const char* strategy, const std::vector<long>& teamResponse, long enemyIsNear, long owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	void* theFact = createFact(SITUATION_AWARENESS_FACT);
+	if (!theFact) return false;
+	theFact = assertFact(theFact, putOwner(SITUATION_AWARENESS_FACT, theFact, owner) && putSlot(theFact, "level", level) && putSlot(theFact, "strategy", strategy)
+		&& putSlot(theFact, "team-response", teamResponse) && putSlot(theFact, "enemy-is-near", enemyIsNear));
+	if (!theFact) return false;
+	// given by the caller : only the changes of the rules are concluded
+	_concluded[owner] = EnvFactIndex(_theEnv, theFact);
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+
+Reasoner::FactDelta Reasoner::updateEnemies(const std::vector<Sighting>& sightings, long owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	return update(ENEMY_FACT, _enemies[owner], sightings, owner);
+}
+
+
+Reasoner::FactDelta Reasoner::updateResources(const std::vector<Sighting>& sightings, long owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	return update(RESOURCE_FACT, _resources[owner], sightings, owner);
+}
+
+
+Reasoner::FactDelta Reasoner::update(FactTemplate which, ShadowTable& shadows, const std::vector<Sighting>& sightings, long owner)
+{
+	FactDelta delta;
+	_update++;
+	for (const Sighting& sighting : sightings)
+	{
+		auto it = shadows.find(sighting.Id);
+		if (it != shadows.end())
+		{
+			ShadowFact& shadow = it->second;
+			// a rule may have retracted it : asserted again as a new fact
+			bool asserted = EnvFactExistp(_theEnv, shadow.Fact) != 0;
+			if (asserted && !changed(shadow.Values, sighting))
+			{
+				shadow.Update = _update;
+				delta.Unchanged++;
+				continue;
+			}
+			// CLIPS modifies a fact by retracting it and asserting the new values
+			retractSighting(shadow.Fact);
+			shadow.Fact = assertSighting(which, sighting, owner);
+			if (!shadow.Fact)
+			{
+				shadows.erase(it);
+				continue;
+			}
+			shadow.Values = sighting;
+			shadow.Update = _update;
+			(asserted ? delta.Modified : delta.Asserted)++;
+			continue;
+		}
+		void* theFact = assertSighting(which, sighting, owner);
+		if (theFact)
+		{
+			shadows[sighting.Id] = { sighting, theFact, _update };
+			delta.Asserted++;
+		}
+	}
+	// entities no more sensed
+	for (auto it = shadows.begin(); it != shadows.end();)
+	{
+		if (it->second.Update == _update)
+		{
+			++it;
+			continue;
+		}
+		retractSighting(it->second.Fact);
+		it = shadows.erase(it);
+		delta.Retracted++;
+	}
+	return delta;
+}
+
+
+void* Reasoner::assertSighting(FactTemplate which, const Sighting& sighting, long owner)
+{
+	void* theFact = createFact(which);
+	if (!theFact) return nullptr;
+	theFact = assertFact(theFact, putOwner(which, theFact, owner) && putSlot(theFact, "id", sighting.Id) && putSlot(theFact, "x", sighting.X) && putSlot(theFact, "y", sighting.Y)
+		&& putSlot(theFact, "z", sighting.Z) && putSlot(theFact, "distance", sighting.Distance));
+	if (theFact)
+	{
+		EnvIncrementFactCount(_theEnv, theFact);
+	}
+	return theFact;
+}
+
+
+void Reasoner::retractSightings(OwnerShadows& shadows, long owner)
+{
+	auto it = shadows.find(owner);
+	if (it == shadows.end()) return;
+	for (auto& shadow : it->second)
+	{
+		retractSighting(shadow.second.Fact);
+	}
+	shadows.erase(it);
+}
+
+
+void Reasoner::retractSighting(void* fact)
+{
+	if (EnvFactExistp(_theEnv, fact))
+	{
+		EnvRetract(_theEnv, fact);
+	}
+	EnvDecrementFactCount(_theEnv, fact);
+}
+
+
+void Reasoner::retractOwner(long owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	retractSightings(_enemies, owner);
+	retractSightings(_resources, owner);
+	_concluded.erase(owner);
+	// the other facts of the owner, asserted directly or by the rules
+	std::vector<void*> facts;
+	DATA_OBJECT theValue;
+	for (int t = 0; t < FACT_TEMPLATES; t++)
+	{
+		if (!_owned[t]) continue;
+		for (void* theFact = EnvGetNextFactInTemplate(_theEnv, _templates[t], NULL); theFact != NULL;
+			theFact = EnvGetNextFactInTemplate(_theEnv, _templates[t], theFact))
+		{
+			if (EnvGetFactSlot(_theEnv, theFact, "owner", &theValue) && GetType(theValue) == INTEGER && DOToLong(theValue) == owner)
+			{
+				facts.push_back(theFact);
+			}
+		}
+	}
+	for (void* theFact : facts)
+	{
+		EnvRetract(_theEnv, theFact);
+	}
+}
+
+
+bool Reasoner::changed(const Sighting& last, const Sighting& sighting) const
+{
+	return std::fabs(last.X - sighting.X) > _tolerance || std::fabs(last.Y - sighting.Y) > _tolerance
+		|| std::fabs(last.Z - sighting.Z) > _tolerance || std::fabs(last.Distance - sighting.Distance) > _tolerance;
+}
+
+// ----------------------------------------------------------------------------
+
+
+void Reasoner::pushEnemies(const std::vector<Sighting>& sightings, long owner)
+{
+	FactUpdate* update = new FactUpdate();
+	update->Template = ENEMY_FACT;
+	update->Owner = owner;
+	update->Sightings = sightings;
+	push(update);
+}
+
+
+void Reasoner::pushResources(const std::vector<Sighting>& sightings, long owner)
+{
+	FactUpdate* update = new FactUpdate();
+	update->Template = RESOURCE_FACT;
+	update->Owner = owner;
+	update->Sightings = sightings;
+	push(update);
+}
+
+
+void Reasoner::pushTeam(long id, const char* tacticalActivity, const std::vector<long>& units, long owner)
+{
+	FactUpdate* update = new FactUpdate();
+	update->Template = TEAM_FACT;
+	update->Owner = owner;
+	update->Id = id;
+	update->Symbol = tacticalActivity;
+	update->Values = units;
+	push(update);
+}
+
+
+void Reasoner::pushSituationAwareness(const char* level, const char* strategy, const std::vector<long>& teamResponse, long enemyIsNear, long owner)
+{
+	FactUpdate* update = new FactUpdate();
+	update->Template = SITUATION_AWARENESS_FACT;
+	update->Owner = owner;
+	update->Symbol = level;
+	update->Strategy = strategy;
+	update->Values = teamResponse;
+	update->EnemyIsNear = enemyIsNear;
+	push(update);
+}
+
+
+void Reasoner::pushRetractOwner(long owner)
+{
+	FactUpdate* update = new FactUpdate();
+	update->Template = FACT_TEMPLATES;
+	update->Owner = owner;
+	push(update);
+}
+
+
+void Reasoner::push(FactUpdate* update)
+{
+	_updates.push(update);
+	// only the first push after a batch takes the lock to wake the thread
+	if (!_pending.exchange(true))
+	{
+		std::lock_guard<std::mutex> lock(_wakeup_mutex);
+		_wakeup.notify_one();
+	}
+}
+
+
+long Reasoner::applyUpdates()
+{
+	long applied = 0;
+	while (std::unique_ptr<FactUpdate> update = _updates.pop())
+	{
+		switch (update->Template)
+		{
+		case ENEMY_FACT:
+			updateEnemies(update->Sightings, update->Owner);
+			break;
+		case RESOURCE_FACT:
+			updateResources(update->Sightings, update->Owner);
+			break;
+		case TEAM_FACT:
+			team(update->Id, update->Symbol.c_str(), update->Values, update->Owner);
+			break;
+		case SITUATION_AWARENESS_FACT:
+			situationAwareness(update->Symbol.c_str(), update->Strategy.c_str(), update->Values, update->EnemyIsNear, update->Owner);
+			break;
+		default:
+			retractOwner(update->Owner);
+			break;
+		}
+		applied++;
+	}
+	_applied.fetch_add(applied, std::memory_order_release);
+	return applied;
+}
+
+
+void Reasoner::conclude(long long firings)
+{
+	void* deftemplate = _templates[SITUATION_AWARENESS_FACT];
+	if (!deftemplate) return;
+	DATA_OBJECT theValue;
+	for (void* theFact = EnvGetNextFactInTemplate(_theEnv, deftemplate, NULL); theFact != NULL;
+		theFact = EnvGetNextFactInTemplate(_theEnv, deftemplate, theFact))
+	{
+		long owner = 0;
+		if (_owned[SITUATION_AWARENESS_FACT] && EnvGetFactSlot(_theEnv, theFact, "owner", &theValue) && GetType(theValue) == INTEGER)
+			owner = (long)DOToLong(theValue);
+		// a modified fact gets a new index
+		long long index = EnvFactIndex(_theEnv, theFact);
+		auto concluded = _concluded.find(owner);
+		if (concluded != _concluded.end() && concluded->second == index) continue;
+		_concluded[owner] = index;
+
+		Conclusion* conclusion = new Conclusion();
+		conclusion->Owner = owner;
+		conclusion->Firings = firings;
+		if (EnvGetFactSlot(_theEnv, theFact, "level", &theValue) && GetType(theValue) == SYMBOL)
+			conclusion->Level = DOToString(theValue);
+		if (EnvGetFactSlot(_theEnv, theFact, "strategy", &theValue) && GetType(theValue) == SYMBOL)
+			conclusion->Strategy = DOToString(theValue);
+		if (EnvGetFactSlot(_theEnv, theFact, "team-response", &theValue) && GetType(theValue) == MULTIFIELD)
+		{
+			void* multifield = GetValue(theValue);
+			for (long i = GetDOBegin(theValue); i <= GetDOEnd(theValue); i++)
+			{
+				if (GetMFType(multifield, i) == INTEGER)
+					conclusion->TeamResponse.push_back((long)ValueToLong(GetMFValue(multifield, i)));
+			}
+		}
+		if (EnvGetFactSlot(_theEnv, theFact, "enemy-is-near", &theValue) && GetType(theValue) == INTEGER)
+			conclusion->EnemyIsNear = (long)DOToLong(theValue);
+		_conclusions.push(conclusion);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+
+void Reasoner::setProfiling(bool on)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	Profile(_theEnv, on ? "constructs" : "off");
+}
+
+
+void Reasoner::resetProfile()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	// profile-reset only sees the rules of the current module
+	ProfileResetCommand(_theEnv);
+	void* current = EnvGetCurrentModule(_theEnv);
+	for (void* module = EnvGetNextDefmodule(_theEnv, NULL); module != NULL; module = EnvGetNextDefmodule(_theEnv, module))
+	{
+		EnvSetCurrentModule(_theEnv, module);
+		for (void* rule = EnvGetNextDefrule(_theEnv, NULL); rule != NULL; rule = EnvGetNextDefrule(_theEnv, rule))
+		{
+			for (struct defrule* disjunct = (struct defrule*)rule; disjunct != NULL; disjunct = disjunct->disjunct)
+			{
+				ResetProfileInfo((struct constructProfileInfo*)TestUserData(ProfileFunctionData(_theEnv)->ProfileDataID, disjunct->header.usrData));
+			}
+		}
+	}
+	EnvSetCurrentModule(_theEnv, current);
+}
+
+
+std::vector<Reasoner::RuleProfile> Reasoner::profile()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	std::vector<RuleProfile> rules;
+	DATA_OBJECT matches;
+	void* current = EnvGetCurrentModule(_theEnv);
+	for (void* module = EnvGetNextDefmodule(_theEnv, NULL); module != NULL; module = EnvGetNextDefmodule(_theEnv, module))
+	{
+		EnvSetCurrentModule(_theEnv, module);
+		for (void* rule = EnvGetNextDefrule(_theEnv, NULL); rule != NULL; rule = EnvGetNextDefrule(_theEnv, rule))
+		{
+			RuleProfile profile;
+			profile.Module = EnvGetDefmoduleName(_theEnv, module);
+			profile.Name = EnvGetDefruleName(_theEnv, rule);
+			// a rule with an or CE has one disjunct by alternative, each with its profile
+			for (struct defrule* disjunct = (struct defrule*)rule; disjunct != NULL; disjunct = disjunct->disjunct)
+			{
+				struct constructProfileInfo* info = (struct constructProfileInfo*)TestUserData(ProfileFunctionData(_theEnv)->ProfileDataID, disjunct->header.usrData);
+				if (!info) continue;
+				profile.Activations += info->numberOfActivations;
+				profile.Firings += info->numberOfEntries;
+				profile.Seconds += info->totalSelfTime;
+				profile.SecondsWithCalls += info->totalWithChildrenTime;
+			}
+			// alpha matches, partial matches and activations on the agenda, counted in the memories of the joins
+			EnvMatches(_theEnv, rule, TERSE, &matches);
+			if (GetType(matches) == MULTIFIELD)
+			{
+				void* counts = GetValue(matches);
+				profile.AlphaMatches = ValueToLong(GetMFValue(counts, 1));
+				profile.PartialMatches = ValueToLong(GetMFValue(counts, 2));
+				profile.Agenda = ValueToLong(GetMFValue(counts, 3));
+			}
+			rules.push_back(profile);
+		}
+	}
+	EnvSetCurrentModule(_theEnv, current);
+	return rules;
+}
+
+
+bool Reasoner::exportProfile(const char* file, ProfileFormat format)
+{
+	std::vector<RuleProfile> rules = profile();
+	std::stable_sort(rules.begin(), rules.end(), [](const RuleProfile& a, const RuleProfile& b) { return a.Seconds > b.Seconds; });
+	FILE* out = fopen(file, "w");
+	if (!out) return false;
+	if (format == PROFILE_CSV)
+	{
+		fprintf(out, "module,rule,activations,firings,agenda,alpha_matches,partial_matches,seconds,seconds_with_calls\n");
+		for (const RuleProfile& rule : rules)
+		{
+			// names between quotes : a symbol may have a comma
+			fprintf(out, "\"%s\",\"%s\",%lld,%lld,%lld,%lld,%lld,%.9f,%.9f\n", rule.Module.c_str(), rule.Name.c_str(), rule.Activations, rule.Firings,
+				rule.Agenda, rule.AlphaMatches, rule.PartialMatches, rule.Seconds, rule.SecondsWithCalls);
+		}
+	}
+	else
+	{
+		fprintf(out, "{\n  \"rules\": [");
+		for (size_t i = 0; i < rules.size(); i++)
+		{
+			const RuleProfile& rule = rules[i];
+			fprintf(out, "%s\n    { \"module\": %s, \"rule\": %s, \"activations\": %lld, \"firings\": %lld, \"agenda\": %lld, "
+				"\"alpha_matches\": %lld, \"partial_matches\": %lld, \"seconds\": %.9f, \"seconds_with_calls\": %.9f }",
+				i ? "," : "", quoted(rule.Module).c_str(), quoted(rule.Name).c_str(), rule.Activations, rule.Firings, rule.Agenda,
+				rule.AlphaMatches, rule.PartialMatches, rule.Seconds, rule.SecondsWithCalls);
+		}
+		fprintf(out, "\n  ]\n}\n");
+	}
+	return fclose(out) == 0;
+}
+
+
+void Reasoner::setProfileExport(const char* file, ProfileFormat format)
+{
+	_profile_file = file ? file : "";
+	_profile_format = format;
+}
+
+// ----------------------------------------------------------------------------
   
 
 void Reasoner::initKnowledge()
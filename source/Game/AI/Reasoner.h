@@ -39,36 +39,325 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <unordered_map>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include "MPSCQueue.h"
 
 
 namespace SubWorld
 {
 	class GameNode;
 
-	// In memory Rule Engine based on CLIPS
+	// In memory Rule Engine based on CLIPS.
+	// The knowledge is loaded first, then start gives the environment to the thread of the reasoner : the other threads
+	// push their facts (pushEnemies...) and pop the conclusions of the rules
 	class Reasoner  
 	{
 	public:
+		// buckets of the hash tables of the environment, 0 : CLIPS default (63559 symbols, 8191 floats, integers and
+		// bitmaps, 16231 facts, about 900 KB). Smaller tables suit an environment of few facts and rules
+		struct HashSizes
+		{
+			unsigned long Symbols = 0;
+			unsigned long Floats = 0;
+			unsigned long Integers = 0;
+			unsigned long BitMaps = 0;
+			unsigned long Facts = 0;
+		};
+
 		Reasoner();
+		explicit Reasoner(const HashSizes& sizes);
 		virtual ~Reasoner();
 		Reasoner(const Reasoner&) = delete;
 		Reasoner& operator=(const Reasoner&) = delete;
 
+		// start the thread of the reasoner : from now on, only this thread uses the environment
+		void start();
+		// stop the thread once the current batch is done (called by the destructor)
+		void stop();
+		// maximum number of rules fired between two batches of facts (-1 : until the agenda is empty)
+		void setFiringBudget(long long firings) { _firing_budget = firings; }
+		// time given to an inference, in microseconds (0 : no limit). No rule starts firing once it is spent, so an
+		// inference overruns it by the actions of its last rule. The activations left fire at the next inference.
+		// The first rule of an inference fires whatever the time spent : the agenda progresses at each inference
+		void setTimeBudget(long long microseconds) { _time_budget = std::chrono::microseconds(microseconds); }
+		// the agenda fires the highest salience first : the work cut by the budgets is the least urgent. The
+		// activations of this salience or higher count as urgent in the telemetry (see InferenceStats)
+		void setUrgentSalience(int salience) { _urgent_salience = salience; }
+		// fire at most firings rules (-1 : until the agenda is empty) within the time budget and publish the conclusions,
+		// when the thread is not started. Returns the number of rules fired
+		long long infer(long long firings = -1);
+		// memory used by the environment, in bytes
+		long long memoryUsed();
+
+		// work of an inference, and what it left on the agenda
+		struct InferenceStats
+		{
+			long long Firings = 0;
+			// time of the inference, and time past the time budget when the rules stopped, in seconds
+			double Seconds = 0;
+			double Overrun = 0;
+			// activations left for the next inference, and those of an urgent salience
+			long long Deferred = 0;
+			long long UrgentDeferred = 0;
+			// budgets which stopped the rules
+			bool FiringBudgetReached = false;
+			bool TimeBudgetReached = false;
+		};
+
+		// inferences since the reasoner was created
+		struct InferenceTotals
+		{
+			long long Inferences = 0;
+			// inferences which left activations on the agenda
+			long long Deferring = 0;
+			long long Firings = 0;
+			double Seconds = 0;
+			double MaxSeconds = 0;
+			double MaxOverrun = 0;
+			long long MaxDeferred = 0;
+			long long MaxUrgentDeferred = 0;
+		};
+
+		InferenceStats lastInference();
+		InferenceTotals inferenceTotals();
+
 		void def(char *templateDef);
 
 		void fact(char *f, char * r, char *v);
 		void fact(char *f, char * r, long v);
 		void fact(char *f, char * r, float v);
+
+		// load a knowledge base (.clp file), then bind the templates of the typed facts
+		bool load(const char* file);
+		// load a binary image of a knowledge base (see compile), then bind the templates of the typed facts.
+		// Nothing is parsed : the time no more depends on the size of the rules, but no construct can be added afterwards
+		bool loadImage(const char* image);
+		// save the constructs of the environment as a binary image
+		bool save(const char* image);
+		// build step : parse a knowledge base and save its binary image, false if the file is not found
+		static bool compile(const char* file, const char* image);
+
+		// typed facts of SensorAI.clp, asserted with the CLIPS C API instead of parsing a string.
+		// They return false if the template is not loaded or a value does not fit its slot.
+		// owner goes to the owner slot of the templates which have one, when owners share the environment (see ReasonerPool)
+		bool enemy(long id, float x, float y, float z, float distance, long owner = 0);
+		bool resource(long id, float x, float y, float z, float distance, long owner = 0);
+		bool team(long id, const char* tacticalActivity, const std::vector<long>& units, long owner = 0);
+		bool situationAwareness(const char* level, const char* strategy, const std::vector<long>& teamResponse, long enemyIsNear, long owner = 0);
+		// retract the typed facts of an owner
+		void retractOwner(long owner);
+
+		// enemy or resource seen by a sensor
+		struct Sighting
+		{
+			long Id;
+			float X, Y, Z;
+			float Distance;
+		};
+
+		// facts changed by a sensor update
+		struct FactDelta
+		{
+			int Asserted = 0;
+			int Modified = 0;
+			int Retracted = 0;
+			int Unchanged = 0;
+		};
+
+		// make the enemy (resource) facts match the sightings of a sensor update : the facts of the entities which
+		// appeared, changed or disappeared since the last update of the owner are asserted, modified or retracted, the others are untouched
+		FactDelta updateEnemies(const std::vector<Sighting>& sightings, long owner = 0);
+		FactDelta updateResources(const std::vector<Sighting>& sightings, long owner = 0);
+		// smaller changes of position and distance are not sent to the rules (0 : any change)
+		void setSensorTolerance(float tolerance) { _tolerance = tolerance; }
+
+		// facts given to the thread of the reasoner, from any thread without locking. They are applied in order
+		// by the next batch, as the functions above
+		void pushEnemies(const std::vector<Sighting>& sightings, long owner = 0);
+		void pushResources(const std::vector<Sighting>& sightings, long owner = 0);
+		void pushTeam(long id, const char* tacticalActivity, const std::vector<long>& units, long owner = 0);
+		void pushSituationAwareness(const char* level, const char* strategy, const std::vector<long>& teamResponse, long enemyIsNear, long owner = 0);
+		void pushRetractOwner(long owner);
+		// number of facts pushed and applied by the thread
+		long long appliedFacts() const { return _applied.load(std::memory_order_acquire); }
+
+		// situation_awareness fact of an owner, once changed by the rules
+		struct Conclusion
+		{
+			long Owner = 0;
+			std::string Level;
+			std::string Strategy;
+			std::vector<long> TeamResponse;
+			long EnemyIsNear = 0;
+			// rules fired by the inference which concluded
+			long long Firings = 0;
+			std::atomic<Conclusion*> Next{ nullptr };
+		};
+		// oldest conclusion published by the thread, nullptr if there is none (one consumer thread)
+		std::unique_ptr<Conclusion> popConclusion() { return _conclusions.pop(); }
+
+		// counters of a rule since the profiling started or was reset
+		struct RuleProfile
+		{
+			std::string Module;
+			std::string Name;
+			// activations put on the agenda, fired, and still waiting on the agenda
+			long long Activations = 0;
+			long long Firings = 0;
+			long long Agenda = 0;
+			// facts matching the patterns of the rule and partial matches of its joins in the Rete network
+			long long AlphaMatches = 0;
+			long long PartialMatches = 0;
+			// time of the actions of the rule, in seconds, without and with the deffunctions they call
+			double Seconds = 0;
+			double SecondsWithCalls = 0;
+		};
+
+		enum ProfileFormat
+		{
+			PROFILE_CSV,
+			PROFILE_JSON
+		};
+
+		// profile the constructs of the environment : the rules count their activations, firings and time
+		void setProfiling(bool on);
+		void resetProfile();
+		// profile of the rules of all the modules, in definition order
+		std::vector<RuleProfile> profile();
+		// write the profile of the rules, the most expensive first
+		bool exportProfile(const char* file, ProfileFormat format);
+		// profile exported by the destructor (nullptr : none)
+		void setProfileExport(const char* file, ProfileFormat format);
 	 
 	protected:
+		friend class ReasonerPartition;
+
 		void run();
 		virtual void initKnowledge();
 
+		// templates of the typed facts
+		enum FactTemplate
+		{
+			ENEMY_FACT,
+			RESOURCE_FACT,
+			TEAM_FACT,
+			SITUATION_AWARENESS_FACT,
+			FACT_TEMPLATES
+		};
+
+		// find the templates of the typed facts and check their slots, once the knowledge is loaded
+		bool bindTemplates();
+		// new fact of a bound template, nullptr if it is not loaded
+		void* createFact(FactTemplate which);
+		// set the owner slot of a fact, if its template has one
+		bool putOwner(FactTemplate which, void* fact, long owner);
+		// set a slot of a fact not asserted yet
+		bool putSlot(void* fact, const char* slot, long value);
+		bool putSlot(void* fact, const char* slot, float value);
+		bool putSlot(void* fact, const char* slot, const char* symbol);
+		bool putSlot(void* fact, const char* slot, const std::vector<long>& values);
+		// assert a fact once its slots are set (the others get their default), free it if a slot failed.
+		// Returns the asserted fact or nullptr
+		void* assertFact(void* fact, bool filled);
+
+		// fact asserted for a sensed entity and the values it holds
+		struct ShadowFact
+		{
+			Sighting Values;
+			// kept valid by its fact count, even once retracted by a rule
+			void* Fact;
+			// last sensor update which saw the entity
+			unsigned int Update;
+		};
+		typedef std::unordered_map<long, ShadowFact> ShadowTable;
+		// shadow tables by owner
+		typedef std::unordered_map<long, ShadowTable> OwnerShadows;
+
+		// fact pushed to the thread
+		struct FactUpdate
+		{
+			// FACT_TEMPLATES : retract the facts of the owner
+			FactTemplate Template = ENEMY_FACT;
+			long Owner = 0;
+			// ENEMY_FACT, RESOURCE_FACT
+			std::vector<Sighting> Sightings;
+			// TEAM_FACT
+			long Id = 0;
+			// tactical activity (TEAM_FACT) or level
+			std::string Symbol;
+			std::string Strategy;
+			// units (TEAM_FACT) or team response
+			std::vector<long> Values;
+			long EnemyIsNear = 0;
+			std::atomic<FactUpdate*> Next{ nullptr };
+		};
+
+		// queue a fact and wake the thread
+		void push(FactUpdate* update);
+		// apply the facts pushed so far, returns their number
+		long applyUpdates();
+		// publish the situation_awareness facts changed by firings
+		void conclude(long long firings);
+		// true while the agenda has activations
+		bool hasActivations();
+		// halt the rules once the time budget of the inference is spent (called by the environment before each firing)
+		static void checkDeadline(void* theEnv, void* activation);
+		// activations on the agendas of all the modules, and those of an urgent salience
+		void countDeferred(InferenceStats& stats);
+
+		// see updateEnemies
+		FactDelta update(FactTemplate which, ShadowTable& shadows, const std::vector<Sighting>& sightings, long owner);
+		// assert the fact of a sighting and keep it, nullptr if it fails
+		void* assertSighting(FactTemplate which, const Sighting& sighting, long owner);
+		// forget the sightings of an owner and retract their facts
+		void retractSightings(OwnerShadows& shadows, long owner);
+		// retract a kept fact if it is still asserted, and release it
+		void retractSighting(void* fact);
+		// true if the rules must see the new values
+		bool changed(const Sighting& last, const Sighting& sighting) const;
+
 	protected:
 		 void *_theEnv;
+		 // deftemplates of the typed facts, by FactTemplate (see bindTemplates)
+		 void *_templates[FACT_TEMPLATES] = {};
+		 // true for the templates with an owner slot
+		 bool _owned[FACT_TEMPLATES] = {};
+		 // last facts asserted by updateEnemies and updateResources, by owner and game id
+		 OwnerShadows _enemies;
+		 OwnerShadows _resources;
+		 // index of the last situation_awareness fact published, by owner
+		 std::unordered_map<long, long long> _concluded;
+		 unsigned int _update = 0;
+		 float _tolerance = 0;
 		 std::thread _thread;
+		 // environment, for the functions called outside of the thread
 		 std::mutex _mutex;
-		 bool _stop_thread = false;
+		 std::atomic<bool> _stop_thread{ false };
+		 // facts pushed, not applied yet
+		 MPSCQueue<FactUpdate> _updates;
+		 std::atomic<long long> _applied{ 0 };
+		 MPSCQueue<Conclusion> _conclusions;
+		 // set by push : the thread waits on _wakeup until it is true
+		 std::atomic<bool> _pending{ false };
+		 std::mutex _wakeup_mutex;
+		 std::condition_variable _wakeup;
+		 long long _firing_budget = 1000;
+		 std::chrono::microseconds _time_budget{ 0 };
+		 int _urgent_salience = 10;
+		 // end of the time budget of the running inference, and whether checkDeadline halted the rules
+		 std::chrono::steady_clock::time_point _deadline;
+		 bool _deadline_reached = false;
+		 // rules which started firing in the running inference
+		 long long _started_firings = 0;
+		 // see lastInference and inferenceTotals
+		 InferenceStats _last_inference;
+		 InferenceTotals _inference_totals;
+		 // see setProfileExport
+		 std::string _profile_file;
+		 ProfileFormat _profile_format = PROFILE_CSV;
 	};
 
 
@@ -0,0 +1,1336 @@
+
+
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+#if defined REASONER_BENCHMARK
+
+// Headless benchmark of the fact assertion of the Reasoner, without Unigine. On Linux :
+//   gcc -O2 -w -c CLIPS/*.c && g++ -std=c++17 -O2 -DREASONER_BENCHMARK -pthread Reasoner.cpp ReasonerPool.cpp ReasonerPartition.cpp ReasonerBenchmark.cpp HTNPlanner/*.cpp *.o -o reasoner_benchmark
+//   ./reasoner_benchmark [--facts N] [knowledge file]
+// Asserts N enemy facts by parsing strings, then through the typed API, and compares the rates.
+//   ./reasoner_benchmark --trace [file] [--record file] [knowledge file]
+// Replays a detection trace (lines "tick id x y z distance", generated when no file is given) into the enemy
+// facts : by retracting and asserting all of them each tick, then with updateEnemies, and compares the agenda
+// activations, rule firings and time per tick.
+//   ./reasoner_benchmark --compile knowledge image
+// Build step : saves the binary image of a knowledge base, for Reasoner::loadImage.
+//   ./reasoner_benchmark --image [--instances N] [--rules N] [knowledge file]
+// Checks that the rules behave the same once loaded from the image (same firings on the generated trace and
+// same facts), then creates N Reasoners (100) from the knowledge file and from its image, and again with N
+// generated rules added to it (200).
+//   ./reasoner_benchmark --stress [--producers P] [--facts N] [knowledge file]
+// P threads (8) push N facts each (100000 in all) to the started reasoner while another one pops its conclusions;
+// checks that every fact is applied. Build with -fsanitize=thread to check the queues for data races.
+//   ./reasoner_benchmark --deltas [knowledge file]
+// Pushes a scripted list of enemies seen by two sensors to the started reasoner, as the sensors of the units do,
+// then again retracting the enemies of the sensor before each update. Checks the facts asserted and retracted
+// by each path, and that both leave the same enemies.
+//   ./reasoner_benchmark --owners N [--environments K] [knowledge file]
+// N owners (500), each with its situation awareness, a team and 4 enemies closing in, for 300 ticks : one Reasoner
+// by owner (default and small hash tables), then a ReasonerPool of K environments (4, default and tuned hash tables).
+// Compares the memory used by CLIPS, the creation time and the time per tick.
+//   ./reasoner_benchmark --partition [--owners N] [--workers W]
+// Generated knowledge base of 4 defmodules (THREAT, SUPPLY, ENGAGE, RESUPPLY) run by a ReasonerPartition, for N owners
+// (200) with 8 enemies, 4 resources and 5 units each : the modules one after the other, then on W workers (3) and the
+// calling thread. Checks that the firings of each module at each tick are the same, and compares the time per tick.
+//   ./reasoner_benchmark --budget [--firings N] [--time us] [knowledge file]
+// Adds rules which never stop to the knowledge and runs 300 inferences within a budget of N firings (100), of a time (500 us),
+// then both. Checks that no inference fires more rules than the budget or starts a rule once its time is spent (it overruns
+// it by the last firing), that every one leaves work on the agenda, and that the urgent rules fire at the tick their enemy
+// comes within 200 m. The time overrun reported also counts the preemptions of the thread. Then spends the time budget
+// before each inference starts, and checks that each one still fires exactly one rule.
+//   ./reasoner_benchmark --profile [file] [knowledge file]
+// Profiles the rules on a scripted fact sequence and checks their activations and firings, then exports the profile
+// as CSV and JSON (and to file at shutdown, JSON if its name ends with .json).
+
+#include "Reasoner.h"
+#include "ReasonerPool.h"
+#include "ReasonerPartition.h"
+#include "HTNPlanner/Scheduler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <string>
+#include <thread>
+extern "C"
+{
+#include "../AI/CLIPS/clips.h"
+}
+
+using namespace SubWorld;
+
+namespace
+{
+	// gives access to the environment
+	class BenchReasoner : public Reasoner
+	{
+	public:
+		void* env() { return _theEnv; }
+
+		// number of facts in the environment
+		long factCount()
+		{
+			long count = 0;
+			for (void* theFact = EnvGetNextFact(_theEnv, NULL); theFact != NULL; theFact = EnvGetNextFact(_theEnv, theFact))
+			{
+				count++;
+			}
+			return count;
+		}
+
+		// count the rules which start firing past the time budget of the inference : a firing whose deadline is
+		// spent before the check of the Reasoner must be halted by it
+		void watchLateFirings()
+		{
+			EnvAddBeforeRunFunctionWithContext(_theEnv, "benchmark-deadline", &BenchReasoner::readDeadline, 10, this);
+			EnvAddBeforeRunFunctionWithContext(_theEnv, "benchmark-late-firings", &BenchReasoner::checkLateFiring, -10, this);
+		}
+		long long lateFirings() const { return _late_firings; }
+
+		// facts asserted since the last reset (a modification asserts the fact again)
+		long long assertedFacts() { return FactData(_theEnv)->NextFactIndex; }
+
+		// spend the time budget of each inference before its first firing, as a budget of 0 ms would
+		void spendTimeBudget()
+		{
+			EnvAddBeforeRunFunctionWithContext(_theEnv, "benchmark-spent-budget", &BenchReasoner::spendDeadline, 20, this);
+		}
+
+	protected:
+		static void readDeadline(void* theEnv, void*)
+		{
+			BenchReasoner* reasoner = (BenchReasoner*)GetEnvironmentCallbackContext(theEnv);
+			// the first firing of an inference is not checked (see Reasoner::checkDeadline)
+			reasoner->_deadline_spent = reasoner->_started_firings > 0 && reasoner->_time_budget.count() > 0 &&
+				std::chrono::steady_clock::now() >= reasoner->_deadline;
+		}
+
+		static void spendDeadline(void* theEnv, void*)
+		{
+			BenchReasoner* reasoner = (BenchReasoner*)GetEnvironmentCallbackContext(theEnv);
+			if (reasoner->_started_firings == 0)
+			{
+				reasoner->_deadline = std::chrono::steady_clock::now();
+			}
+		}
+
+		static void checkLateFiring(void* theEnv, void*)
+		{
+			BenchReasoner* reasoner = (BenchReasoner*)GetEnvironmentCallbackContext(theEnv);
+			if (reasoner->_deadline_spent && !EnvGetHaltRules(theEnv))
+			{
+				reasoner->_late_firings++;
+			}
+		}
+
+		bool _deadline_spent = false;
+		long long _late_firings = 0;
+	};
+
+	// time to assert facts facts, in seconds
+	template <class Assert>
+	double measure(BenchReasoner& reasoner, long facts, Assert assertFact)
+	{
+		EnvReset(reasoner.env());
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (long id = 0; id < facts; id++)
+		{
+			assertFact(id);
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// --------------------------------------------------------------------------
+
+	// sightings of each tick
+	typedef std::vector<std::vector<Reasoner::Sighting>> Trace;
+
+	// deterministic trace of 200 enemies for 600 ticks (10 s at 60 Hz) : 60% are idle, 30% move every tick,
+	// the others move every 10 ticks and are lost one tick out of 4
+	Trace generateTrace()
+	{
+		const long enemies = 200;
+		const int ticks = 600;
+		Trace trace(ticks);
+		unsigned int seed = 12345;
+		auto random = [&seed]() { seed = seed * 1103515245 + 12345; return (float)((seed >> 16) & 0x7fff) / 32768.0f; };
+		std::vector<Reasoner::Sighting> start;
+		for (long id = 0; id < enemies; id++)
+		{
+			start.push_back({ id, random() * 800 - 400, random() * 800 - 400, -random() * 100, 0 });
+		}
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			for (Reasoner::Sighting sighting : start)
+			{
+				long kind = sighting.Id % 10;
+				if (kind >= 6 && kind < 9)
+				{
+					sighting.X += tick * 0.5f;
+				}
+				else if (kind == 9)
+				{
+					if ((tick / 15 + sighting.Id) % 4 == 0) continue;
+					sighting.Y += (tick / 10) * 2.0f;
+				}
+				sighting.Distance = std::sqrt(sighting.X * sighting.X + sighting.Y * sighting.Y + sighting.Z * sighting.Z);
+				trace[tick].push_back(sighting);
+			}
+		}
+		return trace;
+	}
+
+	bool readTrace(const char* file, Trace& trace)
+	{
+		FILE* f = fopen(file, "r");
+		if (!f) return false;
+		std::map<int, std::vector<Reasoner::Sighting>> ticks;
+		int tick;
+		Reasoner::Sighting sighting;
+		while (fscanf(f, "%d %ld %f %f %f %f", &tick, &sighting.Id, &sighting.X, &sighting.Y, &sighting.Z, &sighting.Distance) == 6)
+		{
+			ticks[tick].push_back(sighting);
+		}
+		fclose(f);
+		trace.clear();
+		// ticks without sightings are kept : the entities are lost
+		for (int t = 0; !ticks.empty() && t <= ticks.rbegin()->first; t++)
+		{
+			trace.push_back(ticks[t]);
+		}
+		return !trace.empty();
+	}
+
+	bool writeTrace(const char* file, const Trace& trace)
+	{
+		FILE* f = fopen(file, "w");
+		if (!f) return false;
+		for (size_t tick = 0; tick < trace.size(); tick++)
+		{
+			for (const Reasoner::Sighting& s : trace[tick])
+			{
+				fprintf(f, "%d %ld %g %g %g %g\n", (int)tick, s.Id, s.X, s.Y, s.Z, s.Distance);
+			}
+		}
+		fclose(f);
+		return true;
+	}
+
+	// totals of a replay
+	struct Replay
+	{
+		long long Activations = 0;
+		long long Firings = 0;
+		long long Asserted = 0;
+		long long Retracted = 0;
+		double Seconds = 0;
+	};
+
+	// number of activations on the agenda
+	long agendaSize(void* env)
+	{
+		long count = 0;
+		for (void* act = EnvGetNextActivation(env, NULL); act != NULL; act = EnvGetNextActivation(env, act))
+		{
+			count++;
+		}
+		return count;
+	}
+
+	// replay the trace, update(tick) sends the sightings of a tick to the reasoner
+	template <class Update>
+	Replay replay(BenchReasoner& reasoner, const Trace& trace, Update update)
+	{
+		Replay total;
+		EnvReset(reasoner.env());
+		for (const std::vector<Reasoner::Sighting>& sightings : trace)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			update(sightings, total);
+			total.Activations += agendaSize(reasoner.env());
+			total.Firings += EnvRun(reasoner.env(), -1);
+			total.Seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		return total;
+	}
+
+	// reacts to every near enemy fact, as the rules of SensorAI.clp which are disabled once an enemy is near
+	const char* nearEnemyRule = "(defrule benchmark-near-enemy (enemy (id ?id) (distance ?d&:(< ?d 200))) => )";
+
+	int traceBenchmark(BenchReasoner& reasoner, const Trace& trace)
+	{
+		EnvBuild(reasoner.env(), nearEnemyRule);
+
+		std::vector<void*> asserted;
+		Replay full = replay(reasoner, trace, [&](const std::vector<Reasoner::Sighting>& sightings, Replay& total)
+		{
+			for (void* theFact : asserted)
+			{
+				EnvRetract(reasoner.env(), theFact);
+				EnvDecrementFactCount(reasoner.env(), theFact);
+			}
+			total.Retracted += asserted.size();
+			asserted.clear();
+			for (const Reasoner::Sighting& s : sightings)
+			{
+				reasoner.enemy(s.Id, s.X, s.Y, s.Z, s.Distance);
+			}
+			// the enemy facts just asserted
+			void* deftemplate = EnvFindDeftemplate(reasoner.env(), "enemy");
+			for (void* theFact = EnvGetNextFactInTemplate(reasoner.env(), deftemplate, NULL); theFact != NULL;
+				theFact = EnvGetNextFactInTemplate(reasoner.env(), deftemplate, theFact))
+			{
+				EnvIncrementFactCount(reasoner.env(), theFact);
+				asserted.push_back(theFact);
+			}
+			total.Asserted += asserted.size();
+		});
+		for (void* theFact : asserted)
+		{
+			EnvDecrementFactCount(reasoner.env(), theFact);
+		}
+		long fullFacts = reasoner.factCount();
+
+		Replay delta = replay(reasoner, trace, [&](const std::vector<Reasoner::Sighting>& sightings, Replay& total)
+		{
+			Reasoner::FactDelta changes = reasoner.updateEnemies(sightings);
+			total.Asserted += changes.Asserted + changes.Modified;
+			total.Retracted += changes.Retracted + changes.Modified;
+		});
+		long deltaFacts = reasoner.factCount();
+
+		double ticks = (double)trace.size();
+		printf("%zu ticks\n", trace.size());
+		printf("%-8s %12s %12s %14s %12s %10s\n", "path", "asserts/tick", "retracts/tick", "activations/tick", "firings/tick", "us/tick");
+		printf("%-8s %12.1f %12.1f %14.1f %12.1f %10.1f\n", "full", full.Asserted / ticks, full.Retracted / ticks,
+			full.Activations / ticks, full.Firings / ticks, full.Seconds * 1e6 / ticks);
+		printf("%-8s %12.1f %12.1f %14.1f %12.1f %10.1f\n", "delta", delta.Asserted / ticks, delta.Retracted / ticks,
+			delta.Activations / ticks, delta.Firings / ticks, delta.Seconds * 1e6 / ticks);
+		// both end with the facts of the last tick
+		return fullFacts == deltaFacts ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// facts of the environment, as printed by the facts command
+	std::string factList(void* env)
+	{
+		std::string facts;
+		char buff[1024];
+		for (void* theFact = EnvGetNextFact(env, NULL); theFact != NULL; theFact = EnvGetNextFact(env, theFact))
+		{
+			EnvGetFactPPForm(env, buff, sizeof(buff), theFact);
+			facts += buff;
+			facts += "\n";
+		}
+		return facts;
+	}
+
+	// true if the rules fire the same on the trace, whether parsed or loaded from their image
+	bool sameBehavior(const char* knowledge, const char* image, const Trace& trace)
+	{
+		BenchReasoner parsed;
+		parsed.load(knowledge);
+		EnvBuild(parsed.env(), nearEnemyRule);
+		if (!parsed.save(image)) return false;
+		BenchReasoner loaded;
+		if (!loaded.loadImage(image)) return false;
+
+		long long firings = 0;
+		BenchReasoner* reasoners[] = { &parsed, &loaded };
+		for (BenchReasoner* reasoner : reasoners)
+		{
+			EnvReset(reasoner->env());
+		}
+		for (const std::vector<Reasoner::Sighting>& sightings : trace)
+		{
+			long long tickFirings[2];
+			for (int r = 0; r < 2; r++)
+			{
+				reasoners[r]->updateEnemies(sightings);
+				tickFirings[r] = EnvRun(reasoners[r]->env(), -1);
+			}
+			if (tickFirings[0] != tickFirings[1]) return false;
+			firings += tickFirings[0];
+		}
+		printf("%zu ticks, %lld firings\n", trace.size(), firings);
+		return factList(parsed.env()) == factList(loaded.env());
+	}
+
+	// knowledge file with rules added, to show how the load time depends on its size
+	bool writeRules(const char* knowledge, const char* file, int rules)
+	{
+		FILE* in = fopen(knowledge, "r");
+		FILE* out = fopen(file, "w");
+		if (!in || !out)
+		{
+			if (in) fclose(in);
+			if (out) fclose(out);
+			return false;
+		}
+		char buff[1024];
+		size_t read;
+		while ((read = fread(buff, 1, sizeof(buff), in)) > 0)
+		{
+			fwrite(buff, 1, read, out);
+		}
+		for (int r = 0; r < rules; r++)
+		{
+			fprintf(out, "\n(defrule benchmark-rule-%d\n  (enemy (id ?id) (x ?x) (distance ?d&:(< ?d %d)))\n"
+				"  (resource (id ?rid) (x ?rx&:(< (abs (- ?x ?rx)) %d)))\n =>\n (assert (threat ?id ?rid %d)))\n", r, 100 + r, 10 + r % 50, r);
+		}
+		fclose(in);
+		fclose(out);
+		return true;
+	}
+
+	// time to create instances Reasoners and load them, in seconds
+	template <class Load>
+	double startup(int instances, Load load)
+	{
+		std::vector<Reasoner*> reasoners;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int i = 0; i < instances; i++)
+		{
+			reasoners.push_back(new BenchReasoner());
+			load(*reasoners.back());
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for (Reasoner* reasoner : reasoners)
+		{
+			delete reasoner;
+		}
+		return seconds;
+	}
+
+	int imageBenchmark(const char* knowledge, int instances, int rules)
+	{
+		const char* image = "reasoner_benchmark.bin";
+		const char* bigKnowledge = "reasoner_benchmark.clp";
+		const char* bigImage = "reasoner_benchmark_rules.bin";
+		bool same = sameBehavior(knowledge, image, generateTrace());
+		printf("rules from the image : %s\n", same ? "same firings and facts" : "DIFFERENT");
+
+		bool built = writeRules(knowledge, bigKnowledge, rules);
+		if (built)
+		{
+			BenchReasoner parsed;
+			parsed.load(bigKnowledge);
+			built = parsed.save(bigImage);
+		}
+
+		std::string big = std::to_string(rules) + " more rules";
+		printf("%-20s %-8s %10s %14s\n", "knowledge", "load", "instances", "ms/instance");
+		auto print = [&](const std::string& name, const char* path, double seconds)
+		{
+			printf("%-20s %-8s %10d %14.3f\n", name.c_str(), path, instances, seconds * 1e3 / instances);
+		};
+		print(knowledge, "parse", startup(instances, [&](Reasoner& r) { r.load(knowledge); }));
+		print(knowledge, "image", startup(instances, [&](Reasoner& r) { r.loadImage(image); }));
+		if (built)
+		{
+			print(big, "parse", startup(instances, [&](Reasoner& r) { r.load(bigKnowledge); }));
+			print(big, "image", startup(instances, [&](Reasoner& r) { r.loadImage(bigImage); }));
+		}
+		remove(image);
+		remove(bigKnowledge);
+		remove(bigImage);
+		return same && built ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// totals of an owners simulation
+	struct OwnersRun
+	{
+		double CreateSeconds = 0;
+		long long Memory = 0;
+		double TickSeconds = 0;
+		long long Firings = 0;
+		long long Conclusions = 0;
+	};
+
+	// each owner : its situation awareness, a team and 4 enemies closing in from 400 m
+	void simulateOwners(const std::vector<Reasoner*>& environments, const std::vector<ReasonerPool::Owner>& owners, int ticks, OwnersRun& run)
+	{
+		for (const ReasonerPool::Owner& owner : owners)
+		{
+			owner.reasoner->situationAwareness("strategical", "protection", {}, 0, owner.Id);
+			owner.reasoner->team(owner.Id, "waiting", { 1, 2, 3 }, owner.Id);
+		}
+		std::vector<Reasoner::Sighting> sightings(4);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			for (const ReasonerPool::Owner& owner : owners)
+			{
+				for (long k = 0; k < 4; k++)
+				{
+					float distance = std::max(10.0f, 400.0f - tick * (0.5f + 0.25f * k + (owner.Id % 7) * 0.1f));
+					sightings[k] = { k + 1, distance, 10.0f * k, -20, distance };
+				}
+				owner.reasoner->updateEnemies(sightings, owner.Id);
+			}
+			for (Reasoner* reasoner : environments)
+			{
+				run.Firings += reasoner->infer();
+				while (reasoner->popConclusion())
+				{
+					run.Conclusions++;
+				}
+			}
+		}
+		run.TickSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / ticks;
+		for (Reasoner* reasoner : environments)
+		{
+			run.Memory += reasoner->memoryUsed();
+		}
+	}
+
+	int ownersBenchmark(const char* knowledge, int owners, int environments)
+	{
+		const char* image = "reasoner_benchmark.bin";
+		const int ticks = 300;
+		if (!Reasoner::compile(knowledge, image))
+		{
+			printf("%s : no knowledge\n", knowledge);
+			return 1;
+		}
+		// one entity : a few symbols and facts
+		Reasoner::HashSizes small;
+		small.Symbols = 1021;
+		small.Floats = 1021;
+		small.Integers = 509;
+		small.BitMaps = 127;
+		small.Facts = 127;
+		// a pool of owners : the facts and positions of all of them
+		Reasoner::HashSizes tuned;
+		tuned.Symbols = 4099;
+		tuned.Floats = 8191;
+		tuned.Integers = 2053;
+		tuned.BitMaps = 509;
+		tuned.Facts = 4099;
+
+		std::vector<std::pair<std::string, OwnersRun>> runs;
+		auto separate = [&](const char* name, const Reasoner::HashSizes& sizes)
+		{
+			OwnersRun run;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			std::vector<Reasoner*> reasoners;
+			std::vector<ReasonerPool::Owner> entities;
+			for (int i = 0; i < owners; i++)
+			{
+				reasoners.push_back(new Reasoner(sizes));
+				reasoners.back()->loadImage(image);
+				ReasonerPool::Owner owner;
+				owner.reasoner = reasoners.back();
+				owner.Id = i + 1;
+				entities.push_back(owner);
+			}
+			run.CreateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			simulateOwners(reasoners, entities, ticks, run);
+			for (Reasoner* reasoner : reasoners)
+			{
+				delete reasoner;
+			}
+			runs.push_back({ name, run });
+		};
+		auto pooled = [&](const char* name, const Reasoner::HashSizes& sizes)
+		{
+			OwnersRun run;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			ReasonerPool pool(environments, sizes);
+			pool.loadImage(image);
+			std::vector<ReasonerPool::Owner> entities;
+			for (int i = 0; i < owners; i++)
+			{
+				entities.push_back(pool.acquire());
+			}
+			run.CreateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::vector<Reasoner*> reasoners;
+			for (size_t i = 0; i < pool.environments(); i++)
+			{
+				reasoners.push_back(&pool.reasoner(i));
+			}
+			simulateOwners(reasoners, entities, ticks, run);
+			runs.push_back({ name, run });
+		};
+		separate("reasoner by owner", Reasoner::HashSizes());
+		separate("  small tables", small);
+		pooled("pool", Reasoner::HashSizes());
+		pooled("  tuned tables", tuned);
+		remove(image);
+
+		printf("%d owners, %d environments in the pool, %d ticks\n", owners, environments, ticks);
+		printf("%-20s %12s %12s %12s %12s %12s\n", "", "memory (MB)", "create (ms)", "tick (ms)", "firings", "conclusions");
+		for (auto& run : runs)
+		{
+			printf("%-20s %12.1f %12.1f %12.3f %12lld %12lld\n", run.first.c_str(), run.second.Memory / 1048576.0,
+				run.second.CreateSeconds * 1e3, run.second.TickSeconds * 1e3, run.second.Firings, run.second.Conclusions);
+		}
+		// the rules conclude the same for every owner, whatever the environment
+		for (auto& run : runs)
+		{
+			if (run.second.Firings != runs[0].second.Firings) return 1;
+		}
+		return 0;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// number of lines of a file, -1 if it cannot be read
+	long lineCount(const char* file)
+	{
+		FILE* in = fopen(file, "r");
+		if (!in) return -1;
+		long lines = 0;
+		for (int c = fgetc(in); c != EOF; c = fgetc(in))
+		{
+			if (c == '\n') lines++;
+		}
+		fclose(in);
+		return lines;
+	}
+
+	int profileBenchmark(const char* knowledge, const char* exportFile)
+	{
+		const char* csv = "reasoner_profile.csv";
+		const char* json = "reasoner_profile.json";
+		long long fired = 0;
+		std::vector<Reasoner::RuleProfile> rules;
+		{
+			Reasoner reasoner;
+			if (!reasoner.load(knowledge))
+			{
+				printf("%s : templates enemy, resource, team and situation_awareness not found\n", knowledge);
+				return 1;
+			}
+			reasoner.setProfiling(true);
+			if (exportFile)
+			{
+				reasoner.setProfileExport(exportFile, strstr(exportFile, ".json") ? Reasoner::PROFILE_JSON : Reasoner::PROFILE_CSV);
+			}
+			// owner 0 : an enemy comes within 200 m, enemy-approach then adapt_strategy fire once
+			reasoner.situationAwareness("strategical", "protection", {}, 0);
+			reasoner.team(7, "waiting", { 1, 2, 3 });
+			fired += reasoner.infer();
+			reasoner.updateEnemies({ { 1, 10, 10, 0, 300 } });
+			fired += reasoner.infer();
+			reasoner.updateEnemies({ { 1, 10, 10, 0, 150 }, { 2, 20, 10, 0, 300 } });
+			fired += reasoner.infer();
+			// the enemy is already near : no more activation
+			reasoner.updateEnemies({ { 1, 10, 10, 0, 120 }, { 2, 20, 10, 0, 180 } });
+			fired += reasoner.infer();
+			// owner 2 : its enemy leaves before the rules run, the activation is removed without firing
+			reasoner.situationAwareness("strategical", "protection", {}, 0, 2);
+			reasoner.updateEnemies({ { 3, 10, 10, 0, 100 } }, 2);
+			reasoner.updateEnemies({}, 2);
+			fired += reasoner.infer();
+
+			rules = reasoner.profile();
+			reasoner.exportProfile(csv, Reasoner::PROFILE_CSV);
+			reasoner.exportProfile(json, Reasoner::PROFILE_JSON);
+		}
+
+		// expected activations and firings of the scripted facts
+		struct Expected
+		{
+			const char* Name;
+			long long Activations;
+			long long Firings;
+		};
+		const Expected expected[] = { { "enemy-approach", 2, 1 }, { "adapt_strategy", 1, 1 } };
+		bool same = true;
+		long long firings = 0;
+		printf("%-20s %12s %12s %12s %12s %12s %12s\n", "rule", "activations", "firings", "agenda", "alpha", "partial", "us");
+		for (const Reasoner::RuleProfile& rule : rules)
+		{
+			printf("%-20s %12lld %12lld %12lld %12lld %12lld %12.1f\n", rule.Name.c_str(), rule.Activations, rule.Firings, rule.Agenda,
+				rule.AlphaMatches, rule.PartialMatches, rule.Seconds * 1e6);
+			firings += rule.Firings;
+			same = same && rule.Agenda == 0;
+			for (const Expected& e : expected)
+			{
+				if (rule.Name == e.Name)
+				{
+					same = same && rule.Activations == e.Activations && rule.Firings == e.Firings;
+				}
+			}
+		}
+		same = same && firings == fired;
+		// a header and a line by rule, the JSON array between two lines
+		bool exported = lineCount(csv) == (long)rules.size() + 1 && lineCount(json) == (long)rules.size() + 4;
+		if (exportFile)
+		{
+			exported = exported && lineCount(exportFile) > 0;
+		}
+		printf("%lld firings : counters %s, export %s\n", fired, same ? "as expected" : "DIFFERENT", exported ? "written" : "FAILED");
+		remove(csv);
+		remove(json);
+		return same && exported ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// synthetic knowledge base of 4 modules : THREAT and SUPPLY conclude the distance band of each enemy and
+	// resource of an owner, ENGAGE and RESUPPLY give an order to each unit of the team of the owner by band of
+	// threat and supply. 8 rules by band
+	bool writePartitionKnowledge(const char* prefix, int bands, std::vector<ReasonerPartition::Module>& modules)
+	{
+		std::string shared = std::string(prefix) + "shared.clp";
+		FILE* out = fopen(shared.c_str(), "w");
+		if (!out) return false;
+		fprintf(out, "(defmodule MAIN (export deftemplate ?ALL))\n"
+			"(deftemplate enemy (slot owner (default 0)) (slot id) (slot x) (slot y) (slot z) (slot distance))\n"
+			"(deftemplate resource (slot owner (default 0)) (slot id) (slot x) (slot y) (slot z) (slot distance))\n"
+			"(deftemplate team (slot owner (default 0)) (slot id) (slot tactical-activity) (multislot units))\n"
+			"(deftemplate situation_awareness (slot owner (default 0)) (slot level) (slot strategy) (multislot team-response) (slot enemy-is-near (default 0)))\n"
+			"(deftemplate threat (slot owner) (slot enemy) (slot level))\n"
+			"(deftemplate supply (slot owner) (slot resource) (slot level))\n"
+			"(deftemplate engage (slot owner) (slot unit) (slot level))\n"
+			"(deftemplate resupply (slot owner) (slot unit) (slot level))\n");
+		fclose(out);
+
+		const float width = 400.0f / bands;
+		struct Band
+		{
+			const char* Module;
+			const char* Input;
+			const char* Conclusion;
+			const char* Key;
+		};
+		const Band sensed[] = { { "THREAT", "enemy", "threat", "enemy" }, { "SUPPLY", "resource", "supply", "resource" } };
+		for (const Band& band : sensed)
+		{
+			std::string file = std::string(prefix) + band.Conclusion + ".clp";
+			out = fopen(file.c_str(), "w");
+			if (!out) return false;
+			fprintf(out, "(defmodule %s (import MAIN deftemplate ?ALL))\n", band.Module);
+			for (int k = 0; k < bands; k++)
+			{
+				fprintf(out, "(defrule %s::%s-%d\n  (%s (owner ?o) (id ?e) (distance ?d&:(>= ?d %g)&:(< ?d %g)))\n"
+					"  (not (%s (owner ?o) (%s ?e) (level %d)))\n =>\n  (assert (%s (owner ?o) (%s ?e) (level %d))))\n",
+					band.Module, band.Conclusion, k, band.Input, k * width, (k + 1) * width, band.Conclusion, band.Key, k, band.Conclusion, band.Key, k);
+				fprintf(out, "(defrule %s::%s-%d-over\n  ?f <- (%s (owner ?o) (%s ?e) (level %d))\n"
+					"  (not (%s (owner ?o) (id ?e) (distance ?d&:(>= ?d %g)&:(< ?d %g))))\n =>\n  (retract ?f))\n",
+					band.Module, band.Conclusion, k, band.Conclusion, band.Key, k, band.Input, k * width, (k + 1) * width);
+			}
+			fclose(out);
+			modules.push_back({ band.Module, file, { band.Conclusion } });
+		}
+
+		// an order by unit of the team and band of the owner
+		const Band orders[] = { { "ENGAGE", "threat", "engage", "unit" }, { "RESUPPLY", "supply", "resupply", "unit" } };
+		for (const Band& order : orders)
+		{
+			std::string file = std::string(prefix) + order.Conclusion + ".clp";
+			out = fopen(file.c_str(), "w");
+			if (!out) return false;
+			fprintf(out, "(defmodule %s (import MAIN deftemplate ?ALL))\n", order.Module);
+			for (int k = 0; k < bands; k++)
+			{
+				fprintf(out, "(defrule %s::%s-%d\n  (team (owner ?o) (units $? ?u $?))\n  (exists (%s (owner ?o) (level %d)))\n"
+					"  (not (%s (owner ?o) (unit ?u) (level %d)))\n =>\n  (assert (%s (owner ?o) (unit ?u) (level %d))))\n",
+					order.Module, order.Conclusion, k, order.Input, k, order.Conclusion, k, order.Conclusion, k);
+				fprintf(out, "(defrule %s::%s-%d-over\n  ?f <- (%s (owner ?o) (level %d))\n  (not (%s (owner ?o) (level %d)))\n =>\n  (retract ?f))\n",
+					order.Module, order.Conclusion, k, order.Conclusion, k, order.Input, k);
+			}
+			fclose(out);
+			modules.push_back({ order.Module, file, { order.Conclusion } });
+		}
+		return true;
+	}
+
+	// firings of each module at each tick, and the matches left in the Rete networks
+	struct PartitionRun
+	{
+		std::vector<long long> Firings;
+		std::vector<long long> Matches;
+		long long Copied = 0;
+		double Seconds = 0;
+	};
+
+	bool simulatePartition(ReasonerPartition& partition, int owners, int ticks, PartitionRun& run)
+	{
+		const int enemies = 8;
+		const int resources = 4;
+		for (size_t m = 0; m < partition.modules(); m++)
+		{
+			for (long owner = 1; owner <= owners; owner++)
+			{
+				partition.reasoner(m).pushSituationAwareness("strategical", "protection", {}, 0, owner);
+				partition.reasoner(m).pushTeam(owner, "waiting", { 1, 2, 3, 4, 5 }, owner);
+			}
+		}
+		std::vector<Reasoner::Sighting> sightings;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			for (long owner = 1; owner <= owners; owner++)
+			{
+				// the sightings of the owner move through the distance bands
+				auto sense = [&](int count, float speed)
+				{
+					sightings.clear();
+					for (long id = 1; id <= count; id++)
+					{
+						float distance = std::fmod(id * 37.0f + owner * 11.0f + tick * speed * (1 + (owner + id) % 5), 400.0f);
+						sightings.push_back({ id, distance, 0, 0, distance });
+					}
+				};
+				sense(enemies, 3.0f);
+				for (size_t m = 0; m < partition.modules(); m++)
+				{
+					partition.reasoner(m).pushEnemies(sightings, owner);
+				}
+				sense(resources, 1.0f);
+				for (size_t m = 0; m < partition.modules(); m++)
+				{
+					partition.reasoner(m).pushResources(sightings, owner);
+				}
+			}
+			partition.tick();
+			for (size_t m = 0; m < partition.modules(); m++)
+			{
+				run.Firings.push_back(partition.firings(m));
+			}
+		}
+		run.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		run.Copied = partition.copiedFacts();
+		for (size_t m = 0; m < partition.modules(); m++)
+		{
+			for (const Reasoner::RuleProfile& rule : partition.reasoner(m).profile())
+			{
+				run.Matches.push_back(rule.AlphaMatches);
+				run.Matches.push_back(rule.PartialMatches);
+				run.Matches.push_back(rule.Agenda);
+			}
+		}
+		return true;
+	}
+
+	int partitionBenchmark(int owners, int workers)
+	{
+		const char* prefix = "reasoner_partition_";
+		const int bands = 20;
+		const int ticks = 100;
+		std::vector<ReasonerPartition::Module> modules;
+		bool written = writePartitionKnowledge(prefix, bands, modules);
+		std::string shared = std::string(prefix) + "shared.clp";
+
+		std::vector<std::pair<std::string, PartitionRun>> runs;
+		bool loaded = written;
+		auto simulate = [&](const std::string& name, HTN::Scheduler* scheduler)
+		{
+			ReasonerPartition partition(scheduler);
+			PartitionRun run;
+			loaded = loaded && partition.load(shared.c_str(), modules);
+			if (loaded) simulatePartition(partition, owners, ticks, run);
+			runs.push_back({ name, run });
+		};
+		simulate("sequential", nullptr);
+		{
+			// the calling thread runs jobs too
+			HTN::Scheduler scheduler(workers);
+			simulate(std::to_string(workers + 1) + " threads", &scheduler);
+		}
+		remove(shared.c_str());
+		for (const ReasonerPartition::Module& module : modules)
+		{
+			remove(module.File.c_str());
+		}
+		if (!loaded)
+		{
+			printf("%spartition : knowledge not loaded\n", prefix);
+			return 1;
+		}
+
+		long long facts = 0;
+		for (long long f : runs[0].second.Firings) facts += f;
+		printf("%d owners (%d enemies, %d resources and 5 units each), %zu modules, %d rules, %d ticks, %u cores\n", owners, owners * 8, owners * 4,
+			modules.size(), bands * 8, ticks, std::thread::hardware_concurrency());
+		printf("%-14s %12s %12s %12s %10s\n", "", "ms/tick", "firings", "copied", "speedup");
+		bool same = true;
+		for (auto& run : runs)
+		{
+			const PartitionRun& r = run.second;
+			printf("%-14s %12.2f %12lld %12lld %10.2f\n", run.first.c_str(), r.Seconds * 1e3 / ticks, facts, r.Copied, runs[0].second.Seconds / r.Seconds);
+			same = same && r.Firings == runs[0].second.Firings && r.Matches == runs[0].second.Matches && r.Copied == runs[0].second.Copied;
+		}
+		printf("firings by module and tick, and matches at the end : %s\n", same ? "same as sequential" : "DIFFERENT");
+		return same ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// rules which never stop, below the salience of the rules of the knowledge : a counter steps at each firing and
+	// asserts a burst of 16 sparks every 4 steps, each retracted by a costlier rule
+	const char* runawayRules[] =
+	{
+		"(deftemplate runaway (slot n))",
+		"(deftemplate spark (slot n) (slot i))",
+		"(defrule runaway-step (declare (salience -10)) ?r <- (runaway (n ?n)) => (modify ?r (n (+ ?n 1))))",
+		"(defrule runaway-burst (declare (salience -10)) (runaway (n ?n&:(= (mod ?n 4) 0))) => (loop-for-count (?i 1 16) (assert (spark (n ?n) (i ?i)))))",
+		"(defrule runaway-spark (declare (salience -10)) ?s <- (spark (n ?n) (i ?i)) => (bind ?x 0) (loop-for-count (?k 1 200) (bind ?x (+ ?x (* ?k ?i)))) (retract ?s))",
+	};
+
+	// the knowledge and the runaway rules, the situation awareness and the team of owner 0, and the runaway counter
+	bool loadRunaway(BenchReasoner& reasoner, const char* knowledge)
+	{
+		if (!reasoner.load(knowledge)) return false;
+		for (const char* construct : runawayRules)
+		{
+			if (!EnvBuild(reasoner.env(), construct)) return false;
+		}
+		EnvReset(reasoner.env());
+		reasoner.situationAwareness("strategical", "protection", {}, 0);
+		reasoner.team(7, "waiting", { 1, 2, 3 });
+		return EnvAssertString(reasoner.env(), "(runaway (n 0))") != NULL;
+	}
+
+	int budgetBenchmark(const char* knowledge, long long firingBudget, long long timeBudget)
+	{
+		const int ticks = 300;
+		// an enemy comes within 200 m : enemy-approach and adapt_strategy must fire at this tick, before the runaway rules
+		const int threatTick = 150;
+
+		struct Budget
+		{
+			const char* Name;
+			long long Firings;
+			long long Microseconds;
+		};
+		const Budget budgets[] = { { "firings", firingBudget, 0 }, { "time", -1, timeBudget }, { "both", firingBudget, timeBudget } };
+		printf("%d ticks, budgets of %lld firings and %lld us\n", ticks, firingBudget, timeBudget);
+		printf("%-8s %10s %10s %10s %10s %10s %10s %8s %8s %8s\n", "budget", "firings", "max", "ms/tick", "max ms", "overrun us",
+			"deferred", "max", "by fire", "by time");
+		bool ok = true;
+		for (const Budget& budget : budgets)
+		{
+			BenchReasoner reasoner;
+			if (!loadRunaway(reasoner, knowledge))
+			{
+				printf("%s : knowledge or runaway rules not loaded\n", knowledge);
+				return 1;
+			}
+			reasoner.setTimeBudget(budget.Microseconds);
+			reasoner.watchLateFirings();
+			long long maxFirings = 0;
+			long long byFirings = 0;
+			long long byTime = 0;
+			long long urgentDeferred = 0;
+			bool deferred = true;
+			bool withinBudget = true;
+			int conclusionTick = -1;
+			int conclusions = 0;
+			for (int tick = 0; tick < ticks; tick++)
+			{
+				if (tick == threatTick)
+				{
+					reasoner.updateEnemies({ { 1, 10, 10, 0, 100 } });
+				}
+				reasoner.infer(budget.Firings);
+				Reasoner::InferenceStats stats = reasoner.lastInference();
+				maxFirings = std::max(maxFirings, stats.Firings);
+				byFirings += stats.FiringBudgetReached;
+				byTime += stats.TimeBudgetReached;
+				urgentDeferred += stats.UrgentDeferred;
+				deferred = deferred && stats.Deferred > 0 && (stats.FiringBudgetReached || stats.TimeBudgetReached);
+				withinBudget = withinBudget && (budget.Firings < 0 || stats.Firings <= budget.Firings);
+				while (std::unique_ptr<Reasoner::Conclusion> conclusion = reasoner.popConclusion())
+				{
+					conclusions++;
+					if (conclusion->EnemyIsNear == 1 && conclusion->TeamResponse == std::vector<long>{ 7 })
+					{
+						conclusionTick = tick;
+					}
+				}
+			}
+			Reasoner::InferenceTotals totals = reasoner.inferenceTotals();
+			printf("%-8s %10lld %10lld %10.3f %10.3f %10.1f %10lld %8lld %8lld %8lld\n", budget.Name, totals.Firings, maxFirings,
+				totals.Seconds * 1e3 / ticks, totals.MaxSeconds * 1e3, totals.MaxOverrun * 1e6, reasoner.lastInference().Deferred,
+				totals.MaxDeferred, byFirings, byTime);
+			withinBudget = withinBudget && reasoner.lateFirings() == 0;
+			bool urgent = conclusions == 1 && conclusionTick == threatTick && urgentDeferred == 0;
+			printf("%-8s within budget : %s, work deferred at every tick : %s, threat concluded at tick %d : %s\n", "", withinBudget ? "yes" : "NO",
+				deferred ? "yes" : "NO", conclusionTick, urgent ? "yes" : "NO");
+			ok = ok && withinBudget && deferred && urgent && totals.Inferences == ticks && totals.Deferring == ticks;
+		}
+
+		// a time budget spent before the first firing : each inference still fires one rule, and only one
+		{
+			BenchReasoner reasoner;
+			if (!loadRunaway(reasoner, knowledge))
+			{
+				printf("%s : knowledge or runaway rules not loaded\n", knowledge);
+				return 1;
+			}
+			reasoner.setTimeBudget(timeBudget);
+			reasoner.spendTimeBudget();
+			reasoner.watchLateFirings();
+			bool progress = true;
+			for (int tick = 0; tick < ticks; tick++)
+			{
+				reasoner.infer();
+				Reasoner::InferenceStats stats = reasoner.lastInference();
+				progress = progress && stats.Firings == 1 && stats.TimeBudgetReached && stats.Deferred > 0;
+			}
+			Reasoner::InferenceTotals totals = reasoner.inferenceTotals();
+			progress = progress && totals.Firings == ticks && reasoner.lateFirings() == 0;
+			printf("%-8s %10lld, one rule fired by each inference : %s\n", "spent", totals.Firings, progress ? "yes" : "NO");
+			ok = ok && progress;
+		}
+		return ok ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	// sensor updates pushed to the thread of the reasoner
+	struct ScriptedUpdate
+	{
+		long Owner;
+		std::vector<Reasoner::Sighting> Sightings;
+	};
+
+	// facts asserted and retracted by the thread for a script, and the enemy facts left
+	struct ScriptRun
+	{
+		long long Asserted = 0;
+		long long Retracted = 0;
+		long Enemies = 0;
+	};
+
+	// push the script to a started reasoner, by deltas, or by retracting the facts of the owner before each update
+	bool runScript(const char* knowledge, const std::vector<ScriptedUpdate>& script, bool full, ScriptRun& run)
+	{
+		BenchReasoner reasoner;
+		if (!reasoner.load(knowledge)) return false;
+		EnvReset(reasoner.env());
+		long long asserted = reasoner.assertedFacts();
+		long facts = reasoner.factCount();
+		reasoner.start();
+		long long pushed = 0;
+		for (const ScriptedUpdate& update : script)
+		{
+			if (full)
+			{
+				reasoner.pushRetractOwner(update.Owner);
+				pushed++;
+			}
+			reasoner.pushEnemies(update.Sightings, update.Owner);
+			pushed++;
+		}
+		while (reasoner.appliedFacts() < pushed)
+		{
+			std::this_thread::yield();
+		}
+		reasoner.stop();
+		run.Asserted = reasoner.assertedFacts() - asserted;
+		run.Retracted = run.Asserted - (reasoner.factCount() - facts);
+		void* deftemplate = EnvFindDeftemplate(reasoner.env(), "enemy");
+		for (void* theFact = EnvGetNextFactInTemplate(reasoner.env(), deftemplate, NULL); theFact != NULL;
+			theFact = EnvGetNextFactInTemplate(reasoner.env(), deftemplate, theFact))
+		{
+			run.Enemies++;
+		}
+		return true;
+	}
+
+	int deltaBenchmark(const char* knowledge)
+	{
+		// two sensors : enemies appear, stay, one moves, one appears, then they disappear
+		const std::vector<ScriptedUpdate> script =
+		{
+			{ 1, { { 10, 100, 0, 0, 100 }, { 11, 300, 0, 0, 300 }, { 12, 500, 0, 0, 500 } } },
+			{ 2, { { 10, 0, 0, 150, 150 } } },
+			{ 1, { { 10, 100, 0, 0, 100 }, { 11, 300, 0, 0, 300 }, { 12, 500, 0, 0, 500 } } },
+			{ 1, { { 10, 100, 0, 0, 100 }, { 11, 250, 0, 0, 250 }, { 12, 500, 0, 0, 500 }, { 13, 0, 0, 900, 900 } } },
+			{ 2, { { 10, 0, 0, 150, 150 } } },
+			{ 1, { { 11, 250, 0, 0, 250 }, { 12, 500, 0, 0, 500 }, { 13, 0, 0, 900, 900 } } },
+			{ 2, {} },
+			{ 1, { { 11, 250, 0, 0, 250 }, { 12, 500, 0, 0, 500 }, { 13, 0, 0, 900, 900 } } },
+		};
+		// the full re-assert asserts every sighting and retracts the previous ones of the owner,
+		// the deltas only assert the 4 new enemies and the moved one, and retract the moved and the 2 gone
+		const ScriptRun expectedFull = { 18, 15, 3 };
+		const ScriptRun expectedDelta = { 6, 3, 3 };
+
+		ScriptRun full, delta;
+		if (!runScript(knowledge, script, true, full) || !runScript(knowledge, script, false, delta))
+		{
+			printf("%s : templates enemy, resource, team and situation_awareness not found\n", knowledge);
+			return 1;
+		}
+		printf("%zu sensor updates\n", script.size());
+		printf("%-8s %10s %10s %10s %10s\n", "path", "asserts", "retracts", "enemies", "expected");
+		auto check = [](const char* name, const ScriptRun& r, const ScriptRun& e)
+		{
+			bool same = r.Asserted == e.Asserted && r.Retracted == e.Retracted && r.Enemies == e.Enemies;
+			printf("%-8s %10lld %10lld %10ld %10s\n", name, r.Asserted, r.Retracted, r.Enemies, same ? "ok" : "DIFFERENT");
+			return same;
+		};
+		bool ok = check("full", full, expectedFull);
+		ok = check("delta", delta, expectedDelta) && ok;
+		return ok ? 0 : 1;
+	}
+
+	// --------------------------------------------------------------------------
+
+	int stressBenchmark(BenchReasoner& reasoner, int producers, long facts)
+	{
+		long perProducer = std::max(1L, facts / producers);
+		long long expected = 1 + (long long)producers * perProducer;
+		EnvReset(reasoner.env());
+		reasoner.start();
+		reasoner.pushSituationAwareness("strategical", "protection", {}, 0);
+
+		std::atomic<bool> stopped{ false };
+		long long conclusions = 0;
+		long long firings = 0;
+		std::thread consumer([&]()
+		{
+			// the last conclusions are published once the reasoner stopped
+			bool last = false;
+			while (!last)
+			{
+				last = stopped;
+				while (std::unique_ptr<Reasoner::Conclusion> conclusion = reasoner.popConclusion())
+				{
+					conclusions++;
+					firings += conclusion->Firings;
+				}
+				std::this_thread::yield();
+			}
+		});
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (int p = 0; p < producers; p++)
+		{
+			threads.emplace_back([&reasoner, p, perProducer]()
+			{
+				for (long i = 0; i < perProducer; i++)
+				{
+					long id = p * perProducer + i;
+					if (i % 4 == 0)
+					{
+						// all the enemies of a sensor : the producers replace each other's
+						float d = (float)(i % 400);
+						reasoner.pushEnemies({ { id, d, 0, 0, d }, { id + 1, 0, d, 0, d + 50 } });
+					}
+					else
+					{
+						reasoner.pushTeam(id, "waiting", { (long)p, i });
+					}
+				}
+			});
+		}
+		for (std::thread& t : threads)
+		{
+			t.join();
+		}
+		while (reasoner.appliedFacts() < expected)
+		{
+			std::this_thread::yield();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		reasoner.stop();
+		stopped = true;
+		consumer.join();
+
+		long teams = 0;
+		void* deftemplate = EnvFindDeftemplate(reasoner.env(), "team");
+		for (void* theFact = EnvGetNextFactInTemplate(reasoner.env(), deftemplate, NULL); theFact != NULL;
+			theFact = EnvGetNextFactInTemplate(reasoner.env(), deftemplate, theFact))
+		{
+			teams++;
+		}
+		long expectedTeams = 0;
+		for (long i = 0; i < perProducer; i++)
+		{
+			expectedTeams += i % 4 != 0;
+		}
+		expectedTeams *= producers;
+
+		printf("%d producers, %lld facts applied in %.3f s : %.0f facts/s\n", producers, reasoner.appliedFacts(), seconds,
+			reasoner.appliedFacts() / seconds);
+		printf("%lld conclusions, %lld firings, %ld team facts (%ld expected)\n", conclusions, firings, teams, expectedTeams);
+		return reasoner.appliedFacts() == expected && teams == expectedTeams ? 0 : 1;
+	}
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	long facts = 100000;
+	const char* knowledge = "SensorAI.clp";
+	bool useTrace = false;
+	const char* traceFile = nullptr;
+	const char* recordFile = nullptr;
+	bool useImage = false;
+	bool stress = false;
+	bool deltas = false;
+	bool profile = false;
+	const char* profileFile = nullptr;
+	int producers = 8;
+	int owners = 0;
+	int environments = 4;
+	bool partition = false;
+	int workers = 3;
+	bool budget = false;
+	long long firingBudget = 100;
+	long long timeBudget = 500;
+	int instances = 100;
+	int rules = 200;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--facts") && i + 1 < argc) facts = std::max(1L, atol(argv[++i]));
+		else if (!strcmp(argv[i], "--trace"))
+		{
+			useTrace = true;
+			if (i + 1 < argc && strstr(argv[i + 1], ".clp") == nullptr && argv[i + 1][0] != '-') traceFile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--record") && i + 1 < argc) recordFile = argv[++i];
+		else if (!strcmp(argv[i], "--compile") && i + 2 < argc)
+		{
+			bool compiled = Reasoner::compile(argv[i + 1], argv[i + 2]);
+			printf("%s -> %s : %s\n", argv[i + 1], argv[i + 2], compiled ? "saved" : "failed");
+			return compiled ? 0 : 1;
+		}
+		else if (!strcmp(argv[i], "--image")) useImage = true;
+		else if (!strcmp(argv[i], "--stress")) stress = true;
+		else if (!strcmp(argv[i], "--deltas")) deltas = true;
+		else if (!strcmp(argv[i], "--profile"))
+		{
+			profile = true;
+			if (i + 1 < argc && strstr(argv[i + 1], ".clp") == nullptr && argv[i + 1][0] != '-') profileFile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--producers") && i + 1 < argc) producers = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--owners") && i + 1 < argc) owners = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--environments") && i + 1 < argc) environments = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--partition")) partition = true;
+		else if (!strcmp(argv[i], "--workers") && i + 1 < argc) workers = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--budget")) budget = true;
+		else if (!strcmp(argv[i], "--firings") && i + 1 < argc) firingBudget = std::max(1LL, atoll(argv[++i]));
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc) timeBudget = std::max(1LL, atoll(argv[++i]));
+		else if (!strcmp(argv[i], "--instances") && i + 1 < argc) instances = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--rules") && i + 1 < argc) rules = std::max(0, atoi(argv[++i]));
+		else knowledge = argv[i];
+	}
+
+	if (partition)
+	{
+		return partitionBenchmark(owners > 0 ? owners : 200, workers);
+	}
+
+	if (budget)
+	{
+		return budgetBenchmark(knowledge, firingBudget, timeBudget);
+	}
+
+	if (deltas)
+	{
+		return deltaBenchmark(knowledge);
+	}
+
+	if (owners > 0)
+	{
+		return ownersBenchmark(knowledge, owners, environments);
+	}
+
+	if (useImage)
+	{
+		return imageBenchmark(knowledge, instances, rules);
+	}
+
+	if (profile)
+	{
+		return profileBenchmark(knowledge, profileFile);
+	}
+
+	BenchReasoner reasoner;
+	if (!reasoner.load(knowledge))
+	{
+		printf("%s : templates enemy, resource, team and situation_awareness not found\n", knowledge);
+		return 1;
+	}
+
+	if (stress)
+	{
+		return stressBenchmark(reasoner, producers, facts);
+	}
+
+	if (useTrace)
+	{
+		Trace trace;
+		if (traceFile && !readTrace(traceFile, trace))
+		{
+			printf("%s : no detection trace\n", traceFile);
+			return 1;
+		}
+		if (!traceFile)
+		{
+			trace = generateTrace();
+		}
+		if (recordFile && !writeTrace(recordFile, trace))
+		{
+			printf("%s : cannot write the detection trace\n", recordFile);
+			return 1;
+		}
+		return traceBenchmark(reasoner, trace);
+	}
+
+	double parsed = measure(reasoner, facts, [&](long id)
+	{
+		char buff[255];
+		float v = (float)(id % 1000);
+		sprintf(buff, "(enemy (id %ld) (x %f) (y %f) (z %f) (distance %f))", id, v, v + 1, v + 2, v * 10);
+		EnvAssertString(reasoner.env(), buff);
+	});
+	long parsedFacts = reasoner.factCount();
+
+	double typed = measure(reasoner, facts, [&](long id)
+	{
+		float v = (float)(id % 1000);
+		reasoner.enemy(id, v, v + 1, v + 2, v * 10);
+	});
+	long typedFacts = reasoner.factCount();
+
+	printf("%-12s %10s %14s %10s\n", "path", "facts", "facts/s", "us/fact");
+	printf("%-12s %10ld %14.0f %10.2f\n", "string", parsedFacts, facts / parsed, parsed * 1e6 / facts);
+	printf("%-12s %10ld %14.0f %10.2f\n", "typed", typedFacts, facts / typed, typed * 1e6 / facts);
+	return parsedFacts == typedFacts ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,350 @@
+
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#include "ReasonerPartition.h"
+#include "HTNPlanner/Scheduler.h"
+#include <functional>
+extern "C"
+{
+#include "../AI/CLIPS/clips.h"
+}
+
+// ----------------------------------------------------------------------------
+
+using namespace SubWorld;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+	// value of a slot or field, read in one environment and written in another : the symbols belong to their environment
+	void readValue(unsigned short type, void* value, unsigned short& readType, std::string& symbol, long long& integer, double& real)
+	{
+		readType = type;
+		switch (type)
+		{
+		case SYMBOL:
+		case STRING:
+		case INSTANCE_NAME:
+			symbol = ValueToString(value);
+			break;
+		case INTEGER:
+			integer = ValueToLong(value);
+			break;
+		case FLOAT:
+			real = ValueToDouble(value);
+			break;
+		default:
+			// addresses have no meaning in another environment
+			readType = SYMBOL;
+			symbol = "nil";
+			break;
+		}
+	}
+
+	void* writeValue(void* theEnv, unsigned short type, const std::string& symbol, long long integer, double real)
+	{
+		switch (type)
+		{
+		case INTEGER:
+			return EnvAddLong(theEnv, integer);
+		case FLOAT:
+			return EnvAddDouble(theEnv, real);
+		default:
+			return EnvAddSymbol(theEnv, symbol.c_str());
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+
+ReasonerPartition::ReasonerPartition(HTN::Scheduler* scheduler)
+	: _scheduler(scheduler)
+{
+
+}
+
+
+ReasonerPartition::~ReasonerPartition()
+{
+	for (std::unique_ptr<Partition>& partition : _partitions)
+	{
+		void* theEnv = partition->Engine->_theEnv;
+		for (std::map<long long, void*>& copies : partition->Copies)
+		{
+			for (auto& copy : copies)
+			{
+				EnvDecrementFactCount(theEnv, copy.second);
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+
+bool ReasonerPartition::load(const char* shared, const std::vector<Module>& modules)
+{
+	_partitions.clear();
+	bool loaded = true;
+	for (const Module& module : modules)
+	{
+		std::unique_ptr<Partition> partition(new Partition());
+		partition->Name = module.Name;
+		partition->Engine.reset(new Reasoner());
+		partition->Conclusions = module.Conclusions;
+		partition->Copies.resize(modules.size());
+		void* theEnv = partition->Engine->_theEnv;
+		// as Reasoner::load, constructs which did not parse are reported and left out
+		loaded = loaded && EnvLoad(theEnv, shared) != 0 && EnvLoad(theEnv, module.File.c_str()) != 0;
+		// the typed facts of the game, if the shared knowledge has their templates
+		partition->Engine->bindTemplates();
+		partition->Defmodule = EnvFindDefmodule(theEnv, module.Name.c_str());
+		loaded = loaded && partition->Defmodule != nullptr;
+		for (const std::string& name : module.Conclusions)
+		{
+			std::vector<std::string> slots;
+			void* deftemplate = EnvFindDeftemplate(theEnv, name.c_str());
+			if (!deftemplate)
+			{
+				loaded = false;
+			}
+			else if (((struct deftemplate*)deftemplate)->implied)
+			{
+				slots.push_back("");
+			}
+			else
+			{
+				DATA_OBJECT names;
+				EnvDeftemplateSlotNames(theEnv, deftemplate, &names);
+				for (long i = GetDOBegin(names); i <= GetDOEnd(names); i++)
+				{
+					slots.push_back(ValueToString(GetMFValue(GetValue(names), i)));
+				}
+			}
+			partition->Slots.push_back(slots);
+		}
+		_partitions.push_back(std::move(partition));
+	}
+	return loaded;
+}
+
+// ----------------------------------------------------------------------------
+
+
+long long ReasonerPartition::tick(long long firings)
+{
+	std::vector<std::function<void()>> jobs;
+	for (std::unique_ptr<Partition>& partition : _partitions)
+	{
+		Partition* p = partition.get();
+		jobs.push_back([this, p, firings]() { run(*p, firings); });
+	}
+	if (_scheduler)
+	{
+		_scheduler->parallel(jobs);
+	}
+	else
+	{
+		for (std::function<void()>& job : jobs)
+		{
+			job();
+		}
+	}
+	// tick boundary : the changes are seen by the next tick
+	long long fired = 0;
+	for (std::unique_ptr<Partition>& partition : _partitions)
+	{
+		partition->Changes.swap(partition->NextChanges);
+		partition->NextChanges.clear();
+		fired += partition->Firings;
+	}
+	return fired;
+}
+
+
+void ReasonerPartition::run(Partition& partition, long long firings)
+{
+	// only this job uses the environment of the module during the tick
+	copy(partition);
+	partition.Engine->applyUpdates();
+	{
+		std::lock_guard<std::mutex> lockGuard(partition.Engine->_mutex);
+		EnvFocus(partition.Engine->_theEnv, partition.Defmodule);
+	}
+	partition.Firings = partition.Engine->infer(firings);
+	publish(partition);
+}
+
+
+long long ReasonerPartition::copiedFacts() const
+{
+	long long copied = 0;
+	for (const std::unique_ptr<Partition>& partition : _partitions)
+	{
+		copied += partition->Copied;
+	}
+	return copied;
+}
+
+// ----------------------------------------------------------------------------
+
+
+void ReasonerPartition::copy(Partition& partition)
+{
+	std::lock_guard<std::mutex> lockGuard(partition.Engine->_mutex);
+	void* theEnv = partition.Engine->_theEnv;
+	// in module order, then in the order of the changes : the same facts whatever the worker
+	for (size_t m = 0; m < _partitions.size(); m++)
+	{
+		Partition& from = *_partitions[m];
+		if (&from == &partition) continue;
+		std::map<long long, void*>& copies = partition.Copies[m];
+		for (const FactChange& change : from.Changes)
+		{
+			if (!change.Asserted)
+			{
+				auto copy = copies.find(change.Index);
+				if (copy == copies.end()) continue;
+				if (EnvFactExistp(theEnv, copy->second))
+				{
+					EnvRetract(theEnv, copy->second);
+				}
+				EnvDecrementFactCount(theEnv, copy->second);
+				copies.erase(copy);
+				partition.Copied++;
+				continue;
+			}
+			void* deftemplate = EnvFindDeftemplate(theEnv, from.Conclusions[change.Template].c_str());
+			// no rule of the module matches the facts of the template
+			if (!deftemplate || ((struct deftemplate*)deftemplate)->patternNetwork == NULL) continue;
+			void* theFact = EnvCreateFact(theEnv, deftemplate);
+			if (!theFact) continue;
+			const std::vector<std::string>& slots = from.Slots[change.Template];
+			for (size_t s = 0; s < slots.size() && s < change.Values.size(); s++)
+			{
+				const SlotValue& value = change.Values[s];
+				DATA_OBJECT theValue;
+				if (value.Type == MULTIFIELD)
+				{
+					void* multifield = EnvCreateMultifield(theEnv, (long)value.Fields.size());
+					for (size_t f = 0; f < value.Fields.size(); f++)
+					{
+						const SlotValue& field = value.Fields[f];
+						SetMFType(multifield, (long)f + 1, field.Type);
+						SetMFValue(multifield, (long)f + 1, writeValue(theEnv, field.Type, field.Symbol, field.Integer, field.Float));
+					}
+					SetType(theValue, MULTIFIELD);
+					SetValue(theValue, multifield);
+					SetDOBegin(theValue, 1);
+					SetDOEnd(theValue, (long)value.Fields.size());
+				}
+				else
+				{
+					SetType(theValue, value.Type);
+					SetValue(theValue, writeValue(theEnv, value.Type, value.Symbol, value.Integer, value.Float));
+				}
+				EnvPutFactSlot(theEnv, theFact, slots[s].empty() ? NULL : slots[s].c_str(), &theValue);
+			}
+			EnvAssignFactSlotDefaults(theEnv, theFact);
+			theFact = EnvAssert(theEnv, theFact);
+			if (!theFact) continue;
+			// kept valid by its fact count until the module retracts it
+			EnvIncrementFactCount(theEnv, theFact);
+			copies[change.Index] = theFact;
+			partition.Copied++;
+		}
+	}
+}
+
+
+void ReasonerPartition::publish(Partition& partition)
+{
+	std::lock_guard<std::mutex> lockGuard(partition.Engine->_mutex);
+	void* theEnv = partition.Engine->_theEnv;
+	std::set<long long> current;
+	std::vector<FactChange> asserted;
+	for (size_t t = 0; t < partition.Conclusions.size(); t++)
+	{
+		void* deftemplate = EnvFindDeftemplate(theEnv, partition.Conclusions[t].c_str());
+		if (!deftemplate) continue;
+		for (void* theFact = EnvGetNextFactInTemplate(theEnv, deftemplate, NULL); theFact != NULL;
+			theFact = EnvGetNextFactInTemplate(theEnv, deftemplate, theFact))
+		{
+			long long index = EnvFactIndex(theEnv, theFact);
+			current.insert(index);
+			if (partition.Published.count(index)) continue;
+			FactChange change;
+			change.Template = t;
+			change.Index = index;
+			for (const std::string& slot : partition.Slots[t])
+			{
+				DATA_OBJECT theValue;
+				SlotValue value;
+				if (EnvGetFactSlot(theEnv, theFact, slot.empty() ? NULL : slot.c_str(), &theValue))
+				{
+					if (GetType(theValue) == MULTIFIELD)
+					{
+						value.Type = MULTIFIELD;
+						for (long i = GetDOBegin(theValue); i <= GetDOEnd(theValue); i++)
+						{
+							SlotValue field;
+							readValue(GetMFType(GetValue(theValue), i), GetMFValue(GetValue(theValue), i), field.Type, field.Symbol, field.Integer, field.Float);
+							value.Fields.push_back(field);
+						}
+					}
+					else
+					{
+						readValue(GetType(theValue), GetValue(theValue), value.Type, value.Symbol, value.Integer, value.Float);
+					}
+				}
+				change.Values.push_back(value);
+			}
+			asserted.push_back(change);
+		}
+	}
+	// retracted (or modified) first, then asserted
+	for (long long index : partition.Published)
+	{
+		if (current.count(index)) continue;
+		FactChange change;
+		change.Asserted = false;
+		change.Index = index;
+		partition.NextChanges.push_back(change);
+	}
+	for (FactChange& change : asserted)
+	{
+		partition.NextChanges.push_back(std::move(change));
+	}
+	partition.Published.swap(current);
+}
+
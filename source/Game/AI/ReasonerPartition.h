@@ -0,0 +1,145 @@
+
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include "Reasoner.h"
+
+namespace HTN
+{
+	class Scheduler;
+}
+
+namespace SubWorld
+{
+
+	// Knowledge base split in independent defmodules, each one in its own Reasoner (CLIPS environment) : a tick
+	// runs the modules in parallel on the workers of a Scheduler. The facts of the templates concluded by a module
+	// are copied to the other modules whose rules match them at the next tick, in module order, so that the firings
+	// do not depend on the workers. The facts of the game are pushed to each module (reasoner(i).pushEnemies...) and applied by the
+	// next tick; the reasoners must not be started
+	class ReasonerPartition
+	{
+	public:
+		struct Module
+		{
+			// defmodule of the rules, focused at each tick
+			std::string Name;
+			// its constructs, loaded after the shared knowledge
+			std::string File;
+			// deftemplates whose facts are asserted by the rules of this module only
+			std::vector<std::string> Conclusions;
+		};
+
+		// scheduler : workers of the ticks (nullptr : the modules run one after the other on the calling thread)
+		explicit ReasonerPartition(HTN::Scheduler* scheduler);
+		~ReasonerPartition();
+		ReasonerPartition(const ReasonerPartition&) = delete;
+		ReasonerPartition& operator=(const ReasonerPartition&) = delete;
+
+		// shared : the deftemplates of all the modules (MAIN exports them). False if a file, a defmodule or a
+		// concluded template is not found
+		bool load(const char* shared, const std::vector<Module>& modules);
+		// fire at most firings rules by module (-1 : until their agenda is empty), with the conclusions of the last
+		// tick. Returns the number of rules fired
+		long long tick(long long firings = -1);
+
+		size_t modules() const { return _partitions.size(); }
+		Reasoner& reasoner(size_t i) { return *_partitions[i]->Engine; }
+		// rules fired by a module during the last tick
+		long long firings(size_t i) const { return _partitions[i]->Firings; }
+		// conclusion facts asserted and retracted in the other modules so far
+		long long copiedFacts() const;
+
+	protected:
+		// value of a slot, out of its environment
+		struct SlotValue
+		{
+			unsigned short Type = 0;
+			std::string Symbol;
+			long long Integer = 0;
+			double Float = 0;
+			std::vector<SlotValue> Fields;
+		};
+
+		// conclusion fact asserted or retracted by a module
+		struct FactChange
+		{
+			bool Asserted = true;
+			// Conclusions index of the template
+			size_t Template = 0;
+			// index of the fact in the environment of the module
+			long long Index = 0;
+			// Asserted : values by Slots
+			std::vector<SlotValue> Values;
+		};
+
+		struct Partition
+		{
+			std::string Name;
+			std::unique_ptr<Reasoner> Engine;
+			void* Defmodule = nullptr;
+			std::vector<std::string> Conclusions;
+			// slot names by concluded template (an empty name : the multifield of an ordered fact)
+			std::vector<std::vector<std::string>> Slots;
+			// concluded facts seen by the other modules, by index
+			std::set<long long> Published;
+			// changes of the last tick, applied by the other modules at this one
+			std::vector<FactChange> Changes;
+			// changes of this tick, they replace Changes once all the modules are done
+			std::vector<FactChange> NextChanges;
+			// copies of the facts concluded by the other modules : by module, then by index of the fact in its module
+			std::vector<std::map<long long, void*>> Copies;
+			long long Firings = 0;
+			long long Copied = 0;
+		};
+
+		// job of a module for a tick
+		void run(Partition& partition, long long firings);
+		// apply the changes of the other modules
+		void copy(Partition& partition);
+		// list the changes of the concluded facts since the last tick
+		void publish(Partition& partition);
+
+	protected:
+		HTN::Scheduler* _scheduler;
+		std::vector<std::unique_ptr<Partition>> _partitions;
+	};
+
+}
+
+
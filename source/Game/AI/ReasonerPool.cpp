@@ -0,0 +1,123 @@
+
+
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+
+
+
+#include "ReasonerPool.h"
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+
+using namespace SubWorld;
+
+// ----------------------------------------------------------------------------
+
+
+ReasonerPool::ReasonerPool(size_t environments, const Reasoner::HashSizes& sizes)
+	: _owners(std::max<size_t>(1, environments), 0)
+{
+	for (size_t i = 0; i < _owners.size(); i++)
+	{
+		_reasoners.push_back(new Reasoner(sizes));
+	}
+}
+
+
+ReasonerPool::~ReasonerPool()
+{
+	for (Reasoner* reasoner : _reasoners)
+	{
+		delete reasoner;
+	}
+	_reasoners.clear();
+}
+
+// ----------------------------------------------------------------------------
+
+
+bool ReasonerPool::load(const char* file)
+{
+	bool loaded = true;
+	for (Reasoner* reasoner : _reasoners)
+	{
+		loaded = reasoner->load(file) && loaded;
+	}
+	return loaded;
+}
+
+
+bool ReasonerPool::loadImage(const char* image)
+{
+	bool loaded = true;
+	for (Reasoner* reasoner : _reasoners)
+	{
+		loaded = reasoner->loadImage(image) && loaded;
+	}
+	return loaded;
+}
+
+
+void ReasonerPool::start()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	_started = true;
+	for (Reasoner* reasoner : _reasoners)
+	{
+		reasoner->start();
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+
+ReasonerPool::Owner ReasonerPool::acquire()
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	size_t least = std::min_element(_owners.begin(), _owners.end()) - _owners.begin();
+	_owners[least]++;
+	Owner owner;
+	owner.reasoner = _reasoners[least];
+	owner.Id = _next_owner++;
+	return owner;
+}
+
+
+void ReasonerPool::release(const Owner& owner)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+	auto it = std::find(_reasoners.begin(), _reasoners.end(), owner.reasoner);
+	if (it == _reasoners.end()) return;
+	_owners[it - _reasoners.begin()]--;
+	// the thread owns the environment once started
+	if (_started)
+		owner.reasoner->pushRetractOwner(owner.Id);
+	else
+		owner.reasoner->retractOwner(owner.Id);
+}
@@ -0,0 +1,83 @@
+
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "Reasoner.h"
+#include <vector>
+#include <mutex>
+
+
+namespace SubWorld
+{
+
+	// CLIPS environments shared by many owners (AI entities) instead of one Reasoner each : an owner asserts its
+	// facts with its id in their owner slot, and the rules only join the facts of a same owner (see SensorAI.clp)
+	class ReasonerPool
+	{
+	public:
+		// environments of the pool, created with the hash table sizes given
+		ReasonerPool(size_t environments, const Reasoner::HashSizes& sizes);
+		~ReasonerPool();
+		ReasonerPool(const ReasonerPool&) = delete;
+		ReasonerPool& operator=(const ReasonerPool&) = delete;
+
+		// load the knowledge of every environment, from a .clp file or from a binary image (see Reasoner::compile)
+		bool load(const char* file);
+		bool loadImage(const char* image);
+		// start the thread of every environment : owners then push their facts
+		void start();
+
+		// owner of facts in a reasoner of the pool
+		struct Owner
+		{
+			Reasoner* reasoner = nullptr;
+			// owner slot of its facts, never 0
+			long Id = 0;
+		};
+		// new owner, in the environment which has the fewest
+		Owner acquire();
+		// retract the facts of an owner and forget it
+		void release(const Owner& owner);
+
+		size_t environments() const { return _reasoners.size(); }
+		Reasoner& reasoner(size_t i) { return *_reasoners[i]; }
+
+	protected:
+		std::vector<Reasoner*> _reasoners;
+		// number of owners, by environment
+		std::vector<size_t> _owners;
+		long _next_owner = 1;
+		bool _started = false;
+		std::mutex _mutex;
+	};
+
+}
@@ -31,6 +31,7 @@
 
 
 #include "SensorAI.h"
+#include "Reasoner.h"
 #include "../GameLevel.h"
 #include "../GameWorld.h"
 #include "../GamePlay.h"
@@ -61,6 +62,11 @@ REGISTER_COMPONENT(SensorAI);
 
 void SensorAI::shutdown()
 {
+	GameLevel* level = GamePlay::Game ? GamePlay::Game->getCurrentevel() : nullptr;
+	if (_owner && level && level->_reasoner)
+	{
+		level->_reasoner->pushRetractOwner(_owner);
+	}
 	for (DetectionSystem* ds : _detection_systems)
 	{
 		delete ds;
@@ -96,6 +102,34 @@ void SensorAI::passive_update(const float elapsedTime)
 	{
 		ds->passiveDetection(gamenode, _friends, _enemies);
 	}
+	GameLevel* level = GamePlay::Game ? GamePlay::Game->getCurrentevel() : nullptr;
+	if (level && level->_reasoner)
+	{
+		publish(*level->_reasoner);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+
+void SensorAI::publish(Reasoner& reasoner)
+{
+	if (_owner == 0)
+	{
+		// the unit assesses its own situation : the rules join its enemies with its facts (ids start at 0, owners at 1)
+		_owner = getGameNode()->_id + 1;
+		reasoner.pushSituationAwareness("strategical", "protection", {}, 0, _owner);
+		reasoner.pushTeam(_owner, "waiting", { getGameNode()->_id }, _owner);
+	}
+	std::vector<Reasoner::Sighting> sightings;
+	sightings.reserve(_enemies._targets.size());
+	for (const DetectedTarget& target : _enemies._targets)
+	{
+		// position relative to the sensor
+		OpenSteer::Vec3 position = target._bearing * target._distance;
+		sightings.push_back({ target._game_id, position.x, position.y, position.z, target._distance });
+	}
+	reasoner.pushEnemies(sightings, _owner);
 }
 
 // ----------------------------------------------------------------------------
@@ -48,6 +48,7 @@
 namespace SubWorld
 {
 	class GameNode;
+	class Reasoner;
 
 
 
@@ -82,6 +83,9 @@ namespace SubWorld
 		DetectionList& getDetectedFriends() { return _friends; }
 		// returns threats informations
 		DetectionList& getDetectedThreats() { return _enemies; }
+		// send the detected threats to the thread of a reasoner : only the enemy facts which changed since the last call are updated.
+		// Called by passive_update with the reasoner of the level, if any
+		void publish(Reasoner& reasoner);
 
 	protected:
 		void init();
@@ -94,6 +98,8 @@ namespace SubWorld
 		std::vector<DetectionSystem*> _detection_systems;
 		DetectionList _friends;
 		DetectionList _enemies;
+		// owner of the facts of the unit in the reasoner (0 : nothing published yet)
+		long _owner = 0;
 
 	};
 
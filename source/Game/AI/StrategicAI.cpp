@@ -60,12 +60,28 @@ using namespace SubWorld;
 
 REGISTER_COMPONENT(StrategicAI);
 
+// knowledge of the reasoner : the binary image built from SensorAI.clp (see Reasoner::compile), else the source
+static const char* knowledge_image = "SubWorld\\AI\\SensorAI.bin";
+static const char* knowledge_file = "SubWorld\\AI\\SensorAI.clp";
+
 // ----------------------------------------------------------------------------
 
 
 void StrategicAI::init()
 {
 	_reasoner = new Reasoner();
+	// the thread owns the environment once started : the knowledge is loaded before
+	if (!_reasoner->loadImage(knowledge_image) && !_reasoner->load(knowledge_file))
+	{
+		printf("\n StrategicAI::init: knowledge %s not found", knowledge_file);
+	}
+	_reasoner->start();
+	// the sensors of the units publish their detections to it
+	GameLevel* level = GamePlay::Game ? GamePlay::Game->getCurrentevel() : nullptr;
+	if (level && !level->_reasoner)
+	{
+		level->_reasoner = _reasoner;
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -73,8 +89,14 @@ void StrategicAI::init()
 
 void StrategicAI::shutdown()
 {
+	GameLevel* level = GamePlay::Game ? GamePlay::Game->getCurrentevel() : nullptr;
+	if (level && level->_reasoner == _reasoner)
+	{
+		level->_reasoner = nullptr;
+	}
 	delete _reasoner;
 	_reasoner = nullptr;
+	_situations.clear();
 
 }
 
@@ -83,7 +105,31 @@ void StrategicAI::shutdown()
 
 void StrategicAI::update()
 {
-	
+	if (!_reasoner) return;
+	// the reasoner thread publishes a conclusion each time the rules change a situation : the queue is emptied
+	// every frame, only the last situation of each owner is kept
+	while (std::unique_ptr<Reasoner::Conclusion> conclusion = _reasoner->popConclusion())
+	{
+		Situation& situation = _situations[conclusion->Owner];
+		if (situation.Strategy != conclusion->Strategy || situation.TeamResponse != conclusion->TeamResponse)
+		{
+			printf("\n StrategicAI::update: owner %ld, %s strategy %s, %zu teams respond, enemy is near %ld", conclusion->Owner,
+				conclusion->Level.c_str(), conclusion->Strategy.c_str(), conclusion->TeamResponse.size(), conclusion->EnemyIsNear);
+		}
+		situation.Level = conclusion->Level;
+		situation.Strategy = conclusion->Strategy;
+		situation.TeamResponse = conclusion->TeamResponse;
+		situation.EnemyIsNear = conclusion->EnemyIsNear;
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+
+const StrategicAI::Situation* StrategicAI::situation(long owner) const
+{
+	auto it = _situations.find(owner);
+	return it != _situations.end() ? &it->second : nullptr;
 }
 
 
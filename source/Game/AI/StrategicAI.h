@@ -38,6 +38,7 @@
 #include <UnigineWidgets.h>
 #include "../GameFactory.h"
 #include "../GameLevel.h"
+#include <map>
 #include <string>
 #include <vector>
 #include <functional>
@@ -64,6 +65,17 @@ namespace SubWorld
 		PROP_NAME("StrategicAI");
 		PROP_PARAM(String, name, "DummyParam");
 
+		// last situation_awareness concluded by the reasoner for an owner
+		struct Situation
+		{
+			std::string Level;
+			std::string Strategy;
+			std::vector<long> TeamResponse;
+			long EnemyIsNear = 0;
+		};
+		// situation of an owner (0 : not owned), nullptr if the reasoner did not conclude yet
+		const Situation* situation(long owner) const;
+
 	 
 	protected:
 		void init();
@@ -73,6 +85,8 @@ namespace SubWorld
 	protected:
 	 	GameNodePtr _wanderer;
 		Reasoner* _reasoner;
+		// conclusions of the reasoner, drained by update
+		std::map<long, Situation> _situations;
 	};
 
 
@@ -37,6 +37,7 @@
 #include "../GameNode.h"
 #include "../PathFinder.h"
 #include "../Converter.h"
+#include "GOAP/PlanningService.h"
 #include <UnigineApp.h>
 #include <UnigineWorld.h>
 #include <UnigineGame.h>
@@ -62,8 +63,12 @@ REGISTER_COMPONENT(UnitGOAPPlannerAI);
 
 void UnitGOAPPlannerAI::shutdown()
 {
-	 
-
+	// a pending plan must not be delivered to a destroyed component
+	GameLevel* level = GamePlay::Game ? GamePlay::Game->getCurrentevel() : nullptr;
+	if (level && level->_planning_service)
+	{
+		level->_planning_service->cancel(this);
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -79,7 +84,18 @@ void UnitGOAPPlannerAI::update()
 void UnitGOAPPlannerAI::update_planner(const float currentTime, const float elapsedTime)
 {
 	sensorUpdate(initial_state, elapsedTime);
-	computePlan();
+	// only replan when the current plan no longer reaches the goal and cannot be repaired
+	if (checkPlan()) return;
+	// plan in background, the result is delivered (onUpdatePlan) on the next tick
+	GameLevel* level = GamePlay::Game ? GamePlay::Game->getCurrentevel() : nullptr;
+	if (level && level->_planning_service)
+	{
+		level->_planning_service->request(this);
+	}
+	else
+	{
+		computePlan();
+	}
 }
 
 
@@ -89,6 +105,8 @@ void UnitGOAPPlannerAI::update_planner(const float currentTime, const float elap
 void UnitGOAPPlannerAI::init()
 {
 	GOAPInterface::initialize();
+	// same bounds as the level planning service (used by plan repairs and the fallback)
+	planner.setBudget(8192, 2.f);
 
 }
 
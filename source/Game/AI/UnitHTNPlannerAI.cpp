@@ -66,7 +66,8 @@ REGISTER_COMPONENT(UnitHTNPlannerAI);
 
 void UnitHTNPlannerAI::shutdown()
 {
-	 
+	// no more step in background, the node is going away
+	HTNPlanner::stop();
 
 }
 
@@ -97,7 +97,7 @@ void BasicStation::createNode()
 	// add battle unit component
 	ComponentSystem::get()->addComponent<BattleUnit>(_node);
 	// Add Strategic AI for this army
-//	ComponentSystem::get()->addComponent<StrategicAI>(_node);
+	ComponentSystem::get()->addComponent<StrategicAI>(_node);
 	
 	
 	// init capacities
@@ -42,6 +42,7 @@
 #include <iomanip>
 #include "Opensteer/include/OpenSteer/Draw.h"
 #include "Converter.h"
+#include "AI/GOAP/PlanningService.h"
 
 // ----------------------------------------------------------------------------
 
@@ -51,9 +52,12 @@ using namespace OpenSteer;
 // ----------------------------------------------------------------------------
 
 GameLevel::GameLevel(GamePlay* gameplay, const std::string& heightMap)
-	: _gameplay(gameplay), _heightMap(heightMap), _pathFinder(new PathFinder(this))
+	: _gameplay(gameplay), _heightMap(heightMap), _spatial_index(100.0f), _pathFinder(new PathFinder(this)),
+	_planning_service(new goap::PlanningService()), _reasoner(nullptr)
 {
 	initProximityDatabase();
+	// an unreachable goal must not stall the batch: settle for a partial plan
+	_planning_service->setBudget(8192, 2.f);
 }
 
 // ----------------------------------------------------------------------------
@@ -61,6 +65,7 @@ GameLevel::GameLevel(GamePlay* gameplay, const std::string& heightMap)
 GameLevel::~GameLevel()
 {
 	safe_delete(_pathFinder);
+	safe_delete(_planning_service);
 }
 
 // ----------------------------------------------------------------------------
@@ -68,6 +73,8 @@ GameLevel::~GameLevel()
 void GameLevel::addGameNode(GameNodePtr v)
 {
 	_nodes.push_back(v);
+	_nodes_by_id[v->_id] = v.get();
+	_spatial_index.insert(v.get(), v->position());
 }
 
 // ----------------------------------------------------------------------------
@@ -77,6 +84,12 @@ void GameLevel::removeGameNode(GameNodePtr v)
 {
 	 
 	printf("\n removeGameNode: %ld", v->_id);
+	_spatial_index.remove(v.get());
+	auto indexed = _nodes_by_id.find(v->_id);
+	if (indexed != _nodes_by_id.end() && indexed->second == v.get())
+	{
+		_nodes_by_id.erase(indexed);
+	}
 	// remove node
 	auto it = std::remove_if(_nodes.begin(), _nodes.end(),
 		[this, v](GameNodePtr g)
@@ -89,13 +102,11 @@ void GameLevel::removeGameNode(GameNodePtr v)
 
 // ----------------------------------------------------------------------------
 
-GameNodePtr GameLevel::getGameNode(int id)
+GameNodePtr GameLevel::getGameNode(long id)
 {
-	for (GameNodePtr v : _nodes)
-	{
-		if (v->_id == id) return v;
-	}
-	return nullptr;
+	auto found = _nodes_by_id.find(id);
+	if (found == _nodes_by_id.end()) return nullptr;
+	return found->second;
 }
 
 
@@ -119,11 +130,17 @@ void GameLevel::update(const float currentTime, const float elapsedTime)
 
 void GameLevel::update_on_400ms(const float currentTime, const float elapsedTime)
 {
+	// deliver the plans requested during the previous tick
+	_planning_service->collect();
+
 	for (GameNodePtr v : _nodes)
 	{
 		v->update_on_400ms(currentTime, elapsedTime);
 	}
 
+	// solve the plans requested during this tick in background
+	_planning_service->dispatch();
+
 }
 
 
@@ -236,20 +253,29 @@ void GameLevel::drawAnnotations(const float elapsedTime)
 // ----------------------------------------------------------------------------
 
 
-std::vector<long> GameLevel::getBoudingSphereIntersection(const OpenSteer::Vec3& center, float radius)
+size_t GameLevel::getBoudingSphereIntersection(const OpenSteer::Vec3& center, float radius, GameNode** nodes, size_t capacity)
 {
-	std::vector<long> nodes;
-	for (GameNodePtr v : _nodes)
-	{
+	return _spatial_index.query(center, radius, nodes, capacity);
+}
 
-		Unigine::Math::Vec3 d(Converter::toUnigine(center) - Converter::toUnigine(v->position()));
-		float distance = d.length();
-		if (distance < radius)
-		{
-			nodes.push_back(v->_id);
-		}
+
+size_t GameLevel::getBoudingSphereIntersection(const OpenSteer::Vec3& center, float radius, std::vector<GameNode*>& nodes)
+{
+	size_t count = _spatial_index.query(center, radius, nodes.data(), nodes.size());
+	if (count > nodes.size())
+	{
+		nodes.resize(count);
+		_spatial_index.query(center, radius, nodes.data(), nodes.size());
 	}
-	return nodes;
+	return count;
+}
+
+// ----------------------------------------------------------------------------
+
+
+void GameLevel::updateNodePosition(GameNode* node)
+{
+	_spatial_index.move(node, node->position());
 }
 
 // ----------------------------------------------------------------------------
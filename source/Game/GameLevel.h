@@ -31,16 +31,24 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
 #include "Opensteer/include/OpenSteer/AbstractVehicle.h"
 #include "Opensteer/include/OpenSteer/Obstacle.h"
 #include <UnigineMathLib.h>
 #include "GameNode.h"
+#include "SpatialGrid.h"
+
+namespace goap
+{
+	class PlanningService;
+}
 
 namespace SubWorld
 {
 	class GamePlay;
  
 	class PathFinder;
+	class Reasoner;
 
 	
 	// A level in game
@@ -64,8 +72,13 @@ namespace SubWorld
 		virtual void mouseClick(enumGameZone zone, const Unigine::Math::vec3& pt);
 		// draw annotations
 		virtual void drawAnnotations(const float elapsedTime);
-		// return all nodes ids which are in the given sphere
-		std::vector<long> getBoudingSphereIntersection(const OpenSteer::Vec3& center, float radius);
+		// write the nodes which are in the given sphere to nodes, up to capacity. Returns the number of nodes in the
+		// sphere : when it exceeds capacity, call again with a larger buffer
+		size_t getBoudingSphereIntersection(const OpenSteer::Vec3& center, float radius, GameNode** nodes, size_t capacity);
+		// same, growing nodes when it is too small. nodes keeps its size between the calls : only the first ones are valid
+		size_t getBoudingSphereIntersection(const OpenSteer::Vec3& center, float radius, std::vector<GameNode*>& nodes);
+		// update the spatial index once a node moved
+		void updateNodePosition(GameNode* node);
 		// try to select the node under the mouse pointer
 		void trySelectNode();
 		// add a node to the list
@@ -75,7 +88,7 @@ namespace SubWorld
 		// retrieves all nodes of this level
 		std::vector<GameNodePtr>& getNodes() { return _nodes;	}
 		// search and return a vehicule by its id
-		GameNodePtr getGameNode(int id);
+		GameNodePtr getGameNode(long id);
 		
 	private:
 		void initProximityDatabase(void);
@@ -87,6 +100,9 @@ namespace SubWorld
 		std::string _heightMap;
 		// list of nodes actually in the level
 		std::vector<GameNodePtr> _nodes;
+		// nodes of the level by id, and by position for the sphere queries
+		std::unordered_map<long, GameNode*> _nodes_by_id;
+		SpatialGrid<GameNode> _spatial_index;
 		// a pointer to the proximity database	 
 		ProximityDatabase* _pd;	 
 		// grouped vehicule used in collision database
@@ -95,6 +111,10 @@ namespace SubWorld
 		OpenSteer::ObstacleGroup _obstacles;
 		// path finder
 		PathFinder* _pathFinder;
+		// solves the GOAP plan requests of the units in background, between two update_on_400ms
+		goap::PlanningService* _planning_service;
+		// reasoner of the situation, fed by the sensors of the units (set by the StrategicAI, nullptr without one)
+		Reasoner* _reasoner;
 		// last click location in screen coordinate
 		Unigine::Math::ivec2 _last_mouse_click_coordinates;
 	};
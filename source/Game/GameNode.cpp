@@ -136,6 +136,7 @@ void GameNode::update(const float currentTime, const float elapsedTime)
  
 	_camera_distance = cameraDistance();
 	applySteeringForce(determineCombinedSteering(elapsedTime), elapsedTime);
+	_level->updateNodePosition(this);
 	updateNode(currentTime, elapsedTime);
 	
 	// update WCS alignement if needed
@@ -426,6 +427,7 @@ void GameNode::setWorldPosition(const OpenSteer::Vec3& position)
 	setPosition(position);
 	// notify proximity database that our position has changed
 	_proximityToken->updateForNewPosition(position);
+	_level->updateNodePosition(this);
 
 }
 
@@ -0,0 +1,184 @@
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include "Opensteer/include/OpenSteer/Vec3.h"
+
+
+namespace SubWorld
+{
+
+	// Uniform grid of the items of a level over the horizontal plane (x, z) : the steering keeps the nodes at their
+	// depth, so a cell is a column. A cell keeps its items with their position, a sphere query only reads the cells
+	// it overlaps. Cells are hashed : the level has no bounds and only the cells visited take memory
+	template <class T>
+	class SpatialGrid
+	{
+	public:
+		// cellSize : side of a cell, about the radius of the usual queries
+		explicit SpatialGrid(float cellSize) : _inverse_cell_size(1.0f / cellSize) {}
+		SpatialGrid(const SpatialGrid&) = delete;
+		SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+		// add an item at its position, or move it if it is already in the grid
+		void insert(T* item, const OpenSteer::Vec3& position)
+		{
+			if (_places.count(item))
+			{
+				move(item, position);
+				return;
+			}
+			_places[item] = attach(item, position);
+		}
+
+		// change the position of an item, nothing if it is not in the grid
+		void move(T* item, const OpenSteer::Vec3& position)
+		{
+			auto found = _places.find(item);
+			if (found == _places.end()) return;
+			Place& place = found->second;
+			CellKey cell = cellOf(position);
+			if (cell == place.Cell)
+			{
+				_cells[cell][place.Slot].Position = position;
+				return;
+			}
+			detach(place);
+			place = attach(item, position);
+		}
+
+		void remove(T* item)
+		{
+			auto found = _places.find(item);
+			if (found == _places.end()) return;
+			detach(found->second);
+			_places.erase(found);
+		}
+
+		void clear()
+		{
+			_cells.clear();
+			_places.clear();
+		}
+
+		size_t size() const { return _places.size(); }
+
+		// items closer than radius to center, written to items up to capacity. Returns the number of items in the
+		// sphere : when it exceeds capacity, the last ones are not written
+		size_t query(const OpenSteer::Vec3& center, float radius, T** items, size_t capacity) const
+		{
+			size_t found = 0;
+			const float radius2 = radius * radius;
+			auto test = [&](const std::vector<Entry>& entries)
+			{
+				for (const Entry& entry : entries)
+				{
+					if ((entry.Position - center).lengthSquared() < radius2)
+					{
+						if (found < capacity) items[found] = entry.Item;
+						found++;
+					}
+				}
+			};
+			const int x0 = cellIndex(center.x - radius), x1 = cellIndex(center.x + radius);
+			const int z0 = cellIndex(center.z - radius), z1 = cellIndex(center.z + radius);
+			// a sphere wider than the occupied cells reads them all
+			if ((double)(x1 - x0 + 1) * (z1 - z0 + 1) > _cells.size())
+			{
+				for (const auto& cell : _cells) test(cell.second);
+				return found;
+			}
+			for (int x = x0; x <= x1; x++)
+			{
+				for (int z = z0; z <= z1; z++)
+				{
+					auto cell = _cells.find(key(x, z));
+					if (cell != _cells.end()) test(cell->second);
+				}
+			}
+			return found;
+		}
+
+	protected:
+		typedef long long CellKey;
+
+		// item in a cell
+		struct Entry
+		{
+			T* Item;
+			OpenSteer::Vec3 Position;
+		};
+
+		// cell of an item and its index in the cell
+		struct Place
+		{
+			CellKey Cell;
+			size_t Slot;
+		};
+
+		int cellIndex(float coordinate) const { return (int)std::floor(coordinate * _inverse_cell_size); }
+		static CellKey key(int x, int z) { return ((CellKey)x << 32) | (unsigned int)z; }
+		CellKey cellOf(const OpenSteer::Vec3& position) const { return key(cellIndex(position.x), cellIndex(position.z)); }
+
+		Place attach(T* item, const OpenSteer::Vec3& position)
+		{
+			CellKey cell = cellOf(position);
+			std::vector<Entry>& entries = _cells[cell];
+			entries.push_back({ item, position });
+			return { cell, entries.size() - 1 };
+		}
+
+		// the last item of the cell takes the slot
+		void detach(const Place& place)
+		{
+			std::vector<Entry>& entries = _cells[place.Cell];
+			if (place.Slot + 1 < entries.size())
+			{
+				entries[place.Slot] = entries.back();
+				_places[entries[place.Slot].Item].Slot = place.Slot;
+			}
+			entries.pop_back();
+		}
+
+	protected:
+		float _inverse_cell_size;
+		// items by cell, the empty cells keep their memory for the next items
+		std::unordered_map<CellKey, std::vector<Entry>> _cells;
+		std::unordered_map<T*, Place> _places;
+	};
+
+}
+
+
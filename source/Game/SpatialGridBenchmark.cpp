@@ -0,0 +1,213 @@
+// ----------------------------------------------------------------------------
+//
+//
+// SubWorld -- SubMarine Game
+//
+// Copyright (c) 2020, F.Lainard
+// Original author: F.Lainard
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+
+#if defined SPATIAL_GRID_BENCHMARK
+
+// Headless benchmark of the SpatialGrid of GameLevel, without Unigine. On Linux :
+//   g++ -std=c++17 -O2 -DSPATIAL_GRID_BENCHMARK SpatialGridBenchmark.cpp Opensteer/src/Vec3.cpp -o spatial_grid_benchmark
+//   ./spatial_grid_benchmark [--nodes N] [--radius R] [--cell S] [--ticks T]
+// N nodes (10000) wander in a square of 4000 m at their depth, and each one looks for the nodes closer than R (100 m,
+// the passive detection of the units) at each of T ticks (20), on a grid of cells of S m (100). Compares the query
+// rate with the linear scan of the nodes, returning ids then searching each node by id as the level did, and
+// returning the nodes. Checks that the grid finds the same nodes as the scan.
+
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace SubWorld;
+
+namespace
+{
+	// a node of the level
+	struct BenchNode
+	{
+		int Id;
+		OpenSteer::Vec3 Position;
+		OpenSteer::Vec3 Velocity;
+	};
+
+	// deterministic random in [0, 1[
+	float random(unsigned int& seed)
+	{
+		seed = seed * 1103515245 + 12345;
+		return (float)((seed >> 16) & 0x7fff) / 32768.0f;
+	}
+
+	// linear scan of the level before the grid : ids of the nodes in the sphere, then the node of each id
+	size_t scanIds(std::vector<BenchNode>& nodes, const OpenSteer::Vec3& center, float radius, std::vector<long>& ids, BenchNode** found, size_t capacity)
+	{
+		ids.clear();
+		for (const BenchNode& node : nodes)
+		{
+			if ((center - node.Position).length() < radius)
+			{
+				ids.push_back(node.Id);
+			}
+		}
+		size_t count = 0;
+		for (long id : ids)
+		{
+			for (BenchNode& node : nodes)
+			{
+				if (node.Id == id)
+				{
+					if (count < capacity) found[count] = &node;
+					count++;
+					break;
+				}
+			}
+		}
+		return count;
+	}
+
+	// linear scan returning the nodes
+	size_t scanNodes(std::vector<BenchNode>& nodes, const OpenSteer::Vec3& center, float radius, BenchNode** found, size_t capacity)
+	{
+		size_t count = 0;
+		const float radius2 = radius * radius;
+		for (BenchNode& node : nodes)
+		{
+			if ((node.Position - center).lengthSquared() < radius2)
+			{
+				if (count < capacity) found[count] = &node;
+				count++;
+			}
+		}
+		return count;
+	}
+
+	double seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	int count = 10000;
+	float radius = 100;
+	float cell = 100;
+	int ticks = 20;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (!strcmp(argv[i], "--nodes")) count = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--radius")) radius = std::max(1.0f, (float)atof(argv[++i]));
+		else if (!strcmp(argv[i], "--cell")) cell = std::max(1.0f, (float)atof(argv[++i]));
+		else if (!strcmp(argv[i], "--ticks")) ticks = std::max(1, atoi(argv[++i]));
+	}
+	const float side = 4000;
+	// the scans are too slow to query from every node : a node out of scanEvery queries with them
+	const int scanEvery = 20;
+
+	unsigned int seed = 12345;
+	std::vector<BenchNode> nodes(count);
+	SpatialGrid<BenchNode> grid(cell);
+	for (int i = 0; i < count; i++)
+	{
+		float heading = random(seed) * 6.2831853f;
+		float speed = 2 + random(seed) * 8;
+		nodes[i] = { i, OpenSteer::Vec3(random(seed) * side, -random(seed) * 50, random(seed) * side),
+			OpenSteer::Vec3(std::cos(heading) * speed, 0, std::sin(heading) * speed) };
+		grid.insert(&nodes[i], nodes[i].Position);
+	}
+
+	std::vector<BenchNode*> found(count), expected(count);
+	std::vector<long> ids;
+	double moveSeconds = 0, gridSeconds = 0, idSeconds = 0, scanSeconds = 0;
+	long long gridQueries = 0, scanQueries = 0, gridFound = 0, scanFound = 0;
+	bool same = true;
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		// a tick of 1 s : the nodes move, and bounce on the sides of the square
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (BenchNode& node : nodes)
+		{
+			node.Position += node.Velocity;
+			if (node.Position.x < 0 || node.Position.x > side) node.Velocity.x = -node.Velocity.x;
+			if (node.Position.z < 0 || node.Position.z > side) node.Velocity.z = -node.Velocity.z;
+			grid.move(&node, node.Position);
+		}
+		moveSeconds += seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (const BenchNode& node : nodes)
+		{
+			gridFound += grid.query(node.Position, radius, found.data(), found.size());
+		}
+		gridSeconds += seconds(start);
+		gridQueries += count;
+
+		start = std::chrono::steady_clock::now();
+		for (int i = tick % scanEvery; i < count; i += scanEvery)
+		{
+			scanIds(nodes, nodes[i].Position, radius, ids, expected.data(), expected.size());
+		}
+		idSeconds += seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int i = tick % scanEvery; i < count; i += scanEvery)
+		{
+			scanFound += scanNodes(nodes, nodes[i].Position, radius, expected.data(), expected.size());
+		}
+		scanSeconds += seconds(start);
+		scanQueries += (count - tick % scanEvery + scanEvery - 1) / scanEvery;
+
+		// the grid finds the nodes of the scans
+		for (int i = tick % scanEvery; i < count; i += scanEvery)
+		{
+			size_t scanned = scanNodes(nodes, nodes[i].Position, radius, expected.data(), expected.size());
+			size_t queried = grid.query(nodes[i].Position, radius, found.data(), found.size());
+			std::sort(expected.begin(), expected.begin() + scanned);
+			std::sort(found.begin(), found.begin() + queried);
+			same = same && scanned == queried && std::equal(expected.begin(), expected.begin() + scanned, found.begin());
+		}
+	}
+
+	printf("%d nodes, radius %g m, cells of %g m, %d ticks : %.1f nodes by query\n", count, radius, cell, ticks, (double)gridFound / gridQueries);
+	printf("%-22s %12s %14s %10s %10s\n", "", "queries", "queries/s", "us/query", "speedup");
+	printf("%-22s %12lld %14.0f %10.2f %10.2f\n", "scan ids + getGameNode", scanQueries, scanQueries / idSeconds, idSeconds * 1e6 / scanQueries, 1.0);
+	printf("%-22s %12lld %14.0f %10.2f %10.2f\n", "scan nodes", scanQueries, scanQueries / scanSeconds, scanSeconds * 1e6 / scanQueries,
+		idSeconds / scanSeconds);
+	printf("%-22s %12lld %14.0f %10.2f %10.2f\n", "grid", gridQueries, gridQueries / gridSeconds, gridSeconds * 1e6 / gridQueries,
+		(idSeconds / scanQueries) / (gridSeconds / gridQueries));
+	printf("grid update : %.3f ms/tick for %d moves, %.1f nodes by scan query\n", moveSeconds * 1e3 / ticks, count, (double)scanFound / scanQueries);
+	printf("nodes found by the grid : %s\n", same ? "same as the scan" : "DIFFERENT");
+	return same ? 0 : 1;
+}
+
+#endif
@@ -138,18 +138,15 @@ void WeaponControlSystem::detect_targets()
 	GameNodePtr gamenode = getGameNode();
 	// check the intersection with nodes based on radar performance
 	Unigine::VectorStack<NodePtr> nodes;
-	std::vector<long> nodesIds = GamePlay::Game->getCurrentevel()->getBoudingSphereIntersection(gamenode->position(), _radar._radar_detection_range / 2);
-	if (nodesIds.size() > 1) // (because the current node is also in this list)
+	size_t count = GamePlay::Game->getCurrentevel()->getBoudingSphereIntersection(gamenode->position(), _radar._radar_detection_range / 2, _nodes_in_range);
+	if (count > 1) // (because the current node is also in this list)
 	{
-		for (int i = 0; i < nodesIds.size(); i++)
+		for (size_t i = 0; i < count; i++)
 		{
-			long nodeID = nodesIds[i];
-
-			//printf("\nWCS: IN BOUNDS of %d : %d", gamenode->_id, nodeID);
-			// verify the given node
-			GameNodePtr threat = GamePlay::Game->getCurrentevel()->getGameNode(nodeID);
+			GameNode* threat = _nodes_in_range[i];
+			//printf("\nWCS: IN BOUNDS of %d : %d", gamenode->_id, threat->_id);
 			// add to threat list if needed
-			if (threat && (threat->_id != gamenode->_id) && GamePlay::Game->isEnemy(gamenode->getFaction(), threat->getFaction()))
+			if ((threat->_id != gamenode->_id) && GamePlay::Game->isEnemy(gamenode->getFaction(), threat->getFaction()))
 			{
 				add_threat(threat->_id);
 			}
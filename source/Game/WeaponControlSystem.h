@@ -220,6 +220,8 @@ namespace SubWorld
 		Radar _radar;
 		ResourceCapacitySystem* _resourceCapacitySystem;
 		bool _showHUD;
+		// buffer of the sphere queries
+		std::vector<GameNode*> _nodes_in_range;
 	};
 
 